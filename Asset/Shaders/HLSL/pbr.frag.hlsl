@@ -8,8 +8,10 @@ float4 pbr_frag_main(pbr_vert_output _entryPointOutput) : SV_Target
     //float2 texCoords = ParallaxMapping(_entryPointOutput.uv, viewDir);
     float2 texCoords = _entryPointOutput.uv;
 
-    float3 tangent_normal = normalMap.Sample(samp0, texCoords).rgb;
-    tangent_normal = tangent_normal * 2.0f - 1.0f;   
+    // z is rebuilt from x and y, normal maps may be stored with two channels
+    float2 normal_xy = normalMap.Sample(samp0, texCoords).rg * 2.0f - 1.0f;
+    float3 tangent_normal = float3(normal_xy,
+        sqrt(saturate(1.0f - dot(normal_xy, normal_xy))));
     float3 N = normalize(mul(tangent_normal, _entryPointOutput.TBN)); 
 
     float3 V = normalize(camPos.xyz - _entryPointOutput.v_world.xyz);
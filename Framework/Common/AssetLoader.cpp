@@ -1,11 +1,257 @@
 #include "AssetLoader.hpp"
 
+#include <sys/stat.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "PakArchive.hpp"
+#include "config.h"
+
+#if defined(OS_LINUX) || defined(OS_ANDROID) || defined(OS_BSD) || \
+    defined(OS_MACOS)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define MYGE_MAPPED_READS 1
+#endif
+
+#if defined(USE_IO_URING)
+
+#include "IoUring.hpp"
+
+// reads submitted together by an I/O thread, a terrain is 256 tiles
+static const uint32_t kIoBatchSize = 64;
+#endif
+
 using namespace My;
 using namespace std;
 
-void AssetLoader::ClearSearchPath() { m_strSearchPath.clear(); }
+// smaller files are cheaper to read than to map
+static const size_t kMapThreshold = 64 * 1024;
+
+// packed by AssetPacker from the Asset tree
+static const char* kDefaultArchive = "Asset.pak";
+
+int AssetLoader::Initialize() {
+    if (FileExists(kDefaultArchive)) {
+        MountArchive(kDefaultArchive);
+    }
+
+    if (!m_strManifest.empty()) {
+        m_RecordingStart = chrono::steady_clock::now();
+
+        ifstream manifest(m_strManifest);
+        vector<string> names;
+        string line;
+        while (getline(manifest, line)) {
+            auto tab = line.find('\t');
+            if (line.empty() || line[0] == '#' || tab == string::npos) {
+                continue;
+            }
+            names.push_back(line.substr(tab + 1));
+        }
+
+        // the disk works through the list while the scene is parsed
+        if (!names.empty() && !m_PrefetchThread.joinable()) {
+            m_bStopPrefetch = false;
+            m_PrefetchThread = thread(&AssetLoader::PrefetchThreadMain, this,
+                                      std::move(names));
+        }
+    }
+
+    return 0;
+}
+
+void AssetLoader::Finalize() {
+    m_bStopPrefetch = true;
+    if (m_PrefetchThread.joinable()) {
+        m_PrefetchThread.join();
+    }
+
+    {
+        lock_guard<mutex> lock(m_AsyncMutex);
+        m_bStopIoThreads = true;
+    }
+    m_AsyncCondition.notify_all();
+
+    for (auto& thread : m_IoThreads) {
+        thread.join();
+    }
+    m_IoThreads.clear();
+
+    {
+        // callbacks of reads never started are dropped, futures waiting
+        // on them see a broken promise
+        lock_guard<mutex> lock(m_AsyncMutex);
+        m_AsyncQueue = decltype(m_AsyncQueue)();
+        m_mapPendingReads.clear();
+        m_mapAsyncRequests.clear();
+        m_bStopIoThreads = false;
+    }
+
+    WriteManifest();
+
+    UnmountArchives();
+}
+
+void AssetLoader::RecordAccess(const char* name) {
+    if (m_strManifest.empty()) return;
+
+    lock_guard<mutex> lock(m_ManifestMutex);
+    if (m_setAccessed.insert(name).second) {
+        auto elapsed = chrono::duration_cast<chrono::milliseconds>(
+            chrono::steady_clock::now() - m_RecordingStart);
+        m_Accesses.emplace_back(name, static_cast<uint32_t>(elapsed.count()));
+    }
+}
+
+void AssetLoader::WriteManifest() {
+    lock_guard<mutex> lock(m_ManifestMutex);
+    if (m_strManifest.empty() || m_Accesses.empty()) return;
+
+    error_code error;
+    filesystem::path path(m_strManifest);
+    if (path.has_parent_path()) {
+        filesystem::create_directories(path.parent_path(), error);
+    }
+
+    ofstream manifest(m_strManifest, ios::trunc);
+    manifest << "# milliseconds since start\tasset, in the order first read"
+             << endl;
+    for (const auto& access : m_Accesses) {
+        manifest << access.second << '\t' << access.first << '\n';
+    }
+
+    m_Accesses.clear();
+    m_setAccessed.clear();
+}
+
+void AssetLoader::PrefetchThreadMain(vector<string> names) {
+    for (const auto& name : names) {
+        if (m_bStopPrefetch) break;
+
+        {
+            lock_guard<mutex> lock(m_ArchiveMutex);
+            bool packed = false;
+            for (const auto& archive : m_Archives) {
+                Buffer bytes = archive->GetEntryBytes(name.c_str());
+                if (bytes.GetData()) {
+#if defined(MYGE_MAPPED_READS)
+                    // the archive is mapped, fault the entry in ahead
+                    auto begin = reinterpret_cast<uintptr_t>(bytes.GetData());
+                    auto page = begin & ~uintptr_t(kPakAlignment - 1);
+                    madvise(reinterpret_cast<void*>(page),
+                            begin - page + bytes.GetDataSize(),
+                            MADV_WILLNEED);
+#endif
+                    packed = true;
+                    break;
+                }
+            }
+            if (packed) continue;
+        }
+
+        string path = ResolvePath(name.c_str());
+        if (path.empty()) continue;
+
+#if defined(MYGE_MAPPED_READS)
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue;
+
+        // starts reading the file into the page cache and returns
+#if defined(OS_MACOS)
+        struct stat status;
+        if (fstat(fd, &status) == 0) {
+            radvisory advice = {0, static_cast<int>(status.st_size)};
+            fcntl(fd, F_RDADVISE, &advice);
+        }
+#else
+        posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+        close(fd);
+#endif
+    }
+}
+
+bool AssetLoader::MountArchive(const char* name) {
+    AssetFilePtr fp = OpenFile(name, MY_OPEN_BINARY);
+    if (!fp) {
+        fprintf(stderr, "Error opening archive '%s'\n", name);
+        return false;
+    }
+
+    // the toc is looked up on every read, and stored entries are handed
+    // out as slices of the archive, so all of it is mapped
+    size_t length = GetSize(fp);
+    Buffer data = MapFile(fp, length);
+    if (!data.GetData()) {
+        data = Buffer(length, Buffer::kPageAlignment);
+        if (fread(data.GetData(), length, 1, static_cast<FILE*>(fp)) != 1) {
+            data = Buffer();
+        }
+    }
+    CloseFile(fp);
+
+    auto archive = make_shared<PakArchive>();
+    if (!archive->Open(std::move(data))) {
+        fprintf(stderr, "'%s' is not a valid archive\n", name);
+        return false;
+    }
+
+#ifdef DEBUG
+    fprintf(stderr, "Mounted archive '%s', %zu entries\n", name,
+            archive->GetEntryCount());
+#endif
+
+    lock_guard<mutex> lock(m_ArchiveMutex);
+    m_Archives.insert(m_Archives.begin(), std::move(archive));
+    return true;
+}
+
+void AssetLoader::UnmountArchives() {
+    lock_guard<mutex> lock(m_ArchiveMutex);
+    m_Archives.clear();
+}
+
+Buffer AssetLoader::ReadFromArchives(const char* name) {
+    decltype(m_Archives) archives;
+    {
+        lock_guard<mutex> lock(m_ArchiveMutex);
+        if (m_Archives.empty()) return Buffer();
+        archives = m_Archives;
+    }
+
+    // inflating runs outside the lock, reads from several threads
+    // decompress in parallel
+    for (const auto& archive : archives) {
+        if (archive->Contains(name)) {
+            RecordAccess(name);
+            return archive->Read(name);
+        }
+    }
+
+    return Buffer();
+}
+
+bool AssetLoader::ArchivesContain(const char* name) {
+    lock_guard<mutex> lock(m_ArchiveMutex);
+    for (const auto& archive : m_Archives) {
+        if (archive->Contains(name)) return true;
+    }
+
+    return false;
+}
+
+void AssetLoader::ClearSearchPath() {
+    lock_guard<mutex> lock(m_PathCacheMutex);
+    m_strSearchPath.clear();
+    ClearPathCache();
+}
 
 bool AssetLoader::AddSearchPath(const char* path) {
+    lock_guard<mutex> lock(m_PathCacheMutex);
     auto src = m_strSearchPath.begin();
 
     while (src != m_strSearchPath.end()) {
@@ -14,15 +260,18 @@ bool AssetLoader::AddSearchPath(const char* path) {
     }
 
     m_strSearchPath.emplace_back(path);
+    ClearPathCache();
     return true;
 }
 
 bool AssetLoader::RemoveSearchPath(const char* path) {
+    lock_guard<mutex> lock(m_PathCacheMutex);
     auto src = m_strSearchPath.begin();
 
     while (src != m_strSearchPath.end()) {
         if (*src == path) {
             m_strSearchPath.erase(src);
+            ClearPathCache();
             return true;
         }
         src++;
@@ -31,33 +280,81 @@ bool AssetLoader::RemoveSearchPath(const char* path) {
     return true;
 }
 
+void AssetLoader::InvalidatePathCache() {
+    lock_guard<mutex> lock(m_PathCacheMutex);
+    ClearPathCache();
+}
+
+void AssetLoader::ClearPathCache() {
+    m_mapResolvedPaths.clear();
+    m_setMissingPaths.clear();
+    // lookups running against the old paths must not fill the cache
+    m_nPathCacheGeneration++;
+}
+
 bool AssetLoader::FileExists(const char* filePath) {
-    AssetFilePtr fp = OpenFile(filePath, MY_OPEN_BINARY);
-    if (fp != nullptr) {
-        CloseFile(fp);
-        return true;
-    }
-    return false;
+    return ArchivesContain(filePath) || !ResolvePath(filePath).empty();
 }
 
-AssetLoader::AssetFilePtr AssetLoader::OpenFile(const char* name,
-                                                AssetOpenMode mode) {
-    FILE* fp = nullptr;
+bool AssetLoader::GetFileStamp(const char* filePath, FileStamp& stamp) {
+    if (ArchivesContain(filePath)) return false;
+
+    string path = ResolvePath(filePath);
+    struct stat status;
+    if (path.empty() || stat(path.c_str(), &status) != 0) return false;
+
+    stamp.size = static_cast<uint64_t>(status.st_size);
+    // a file rewritten within the same second must stamp differently
+#if defined(OS_LINUX) || defined(OS_ANDROID)
+    stamp.modified = static_cast<int64_t>(status.st_mtim.tv_sec) *
+                         1000000000 +
+                     status.st_mtim.tv_nsec;
+#elif defined(OS_MACOS) || defined(OS_BSD)
+    stamp.modified = static_cast<int64_t>(status.st_mtimespec.tv_sec) *
+                         1000000000 +
+                     status.st_mtimespec.tv_nsec;
+#else
+    stamp.modified = static_cast<int64_t>(status.st_mtime) * 1000000000;
+#endif
+    stamp.path = std::move(path);
+    return true;
+}
+
+string AssetLoader::ResolvePath(const char* name) {
+    // the search path may change on another thread, the lookup works on a
+    // copy of it
+    vector<string> search_path;
+    uint64_t generation;
+    {
+        lock_guard<mutex> lock(m_PathCacheMutex);
+        auto it = m_mapResolvedPaths.find(name);
+        if (it != m_mapResolvedPaths.end()) {
+            return it->second;
+        }
+
+        if (m_setMissingPaths.count(name)) {
+            return string();
+        }
+
+        search_path = m_strSearchPath;
+        generation = m_nPathCacheGeneration;
+    }
+
     // loop N times up the hierarchy, testing at each level
 #ifdef __psp2__
     std::string upPath = "app0:/";
-#elseif __ORBIS__
+#elif __ORBIS__
     std::string upPath = "/app0/";
 #else
     std::string upPath;
 #endif
     std::string fullPath;
     for (int32_t i = 0; i < 10; i++) {
-        auto src = m_strSearchPath.begin();
+        auto src = search_path.begin();
         bool looping = true;
         while (looping) {
             fullPath.assign(upPath);  // reset to current upPath.
-            if (src != m_strSearchPath.end()) {
+            if (src != search_path.end()) {
                 fullPath.append(*src);
                 fullPath.append("/Asset/");
                 src++;
@@ -67,41 +364,87 @@ AssetLoader::AssetFilePtr AssetLoader::OpenFile(const char* name,
             }
             fullPath.append(name);
 
-            switch (mode) {
-                case MY_OPEN_TEXT:
-                    fp = fopen(fullPath.c_str(), "r");
-                    break;
-                case MY_OPEN_BINARY:
-                    fp = fopen(fullPath.c_str(), "rb");
-                    break;
-            }
-
-            if (fp) {
-                return (AssetFilePtr)fp;
+            struct stat status;
+            if (stat(fullPath.c_str(), &status) == 0 &&
+                (status.st_mode & S_IFMT) == S_IFREG) {
+                // absolute, so it stays valid if the working directory
+                // changes
+                error_code error;
+                auto absolute = filesystem::absolute(fullPath, error);
+                if (!error) {
+                    fullPath = absolute.lexically_normal().string();
+                }
+
+                lock_guard<mutex> lock(m_PathCacheMutex);
+                if (generation == m_nPathCacheGeneration) {
+                    m_mapResolvedPaths.emplace(name, fullPath);
+                }
+                return fullPath;
             }
         }
 
         upPath.append("../");
     }
 
-    return nullptr;
+    lock_guard<mutex> lock(m_PathCacheMutex);
+    if (generation == m_nPathCacheGeneration) {
+        m_setMissingPaths.emplace(name);
+    }
+
+    return string();
+}
+
+AssetLoader::AssetFilePtr AssetLoader::OpenFile(const char* name,
+                                                AssetOpenMode mode) {
+    string fullPath = ResolvePath(name);
+    if (fullPath.empty()) {
+        return nullptr;
+    }
+
+    FILE* fp = nullptr;
+    switch (mode) {
+        case MY_OPEN_TEXT:
+            fp = fopen(fullPath.c_str(), "r");
+            break;
+        case MY_OPEN_BINARY:
+            fp = fopen(fullPath.c_str(), "rb");
+            break;
+    }
+
+    if (!fp) {
+        // removed since it was resolved, look it up again next time
+        lock_guard<mutex> lock(m_PathCacheMutex);
+        m_mapResolvedPaths.erase(name);
+    }
+
+    return (AssetFilePtr)fp;
 }
 
 Buffer AssetLoader::SyncOpenAndReadText(const char* filePath) {
+    Buffer buff = ReadFromArchives(filePath);
+    if (buff.GetData()) {
+        // text buffers are terminated
+        Buffer text(buff.GetDataSize() + 1, Buffer::kSimdAlignment);
+        memcpy(text.GetData(), buff.GetData(), buff.GetDataSize());
+        text.GetData()[buff.GetDataSize()] = '\0';
+        return text;
+    }
+
     AssetFilePtr fp = OpenFile(filePath, MY_OPEN_TEXT);
-    Buffer buff;
 
     if (fp) {
+        RecordAccess(filePath);
         size_t length = GetSize(fp);
 
-        uint8_t* data = new uint8_t[length + 1];
-        length = fread(data, 1, length, static_cast<FILE*>(fp));
+        buff = Buffer(length + 1, Buffer::kSimdAlignment);
+        length = fread(buff.GetData(), 1, length, static_cast<FILE*>(fp));
 #ifdef DEBUG
         fprintf(stderr, "Read file '%s', %zu bytes\n", filePath, length);
 #endif
 
-        data[length] = '\0';
-        buff.SetData(data, length + 1);
+        buff.GetData()[length] = '\0';
+        // text mode may deliver less than the size of the file
+        buff = buff.Slice(0, length + 1);
 
         CloseFile(fp);
     } else {
@@ -112,18 +455,36 @@ Buffer AssetLoader::SyncOpenAndReadText(const char* filePath) {
 }
 
 Buffer AssetLoader::SyncOpenAndReadBinary(const char* filePath) {
+    Buffer buff = ReadFromArchives(filePath);
+    if (buff.GetData()) {
+        return buff;
+    }
+
     AssetFilePtr fp = OpenFile(filePath, MY_OPEN_BINARY);
-    Buffer buff;
 
     if (fp) {
+        RecordAccess(filePath);
         size_t length = GetSize(fp);
 
-        uint8_t* data = new uint8_t[length];
-        fread(data, length, 1, static_cast<FILE*>(fp));
+#if defined(MYGE_MAPPED_READS)
+        if (length >= kMapThreshold) {
+            buff = MapFile(fp, length);
+            if (buff.GetData()) {
+#ifdef DEBUG
+                fprintf(stderr, "Mapped file '%s', %zu bytes\n", filePath,
+                        length);
+#endif
+                CloseFile(fp);
+                return buff;
+            }
+        }
+#endif
+
+        buff = Buffer(length, Buffer::kSimdAlignment);
+        fread(buff.GetData(), length, 1, static_cast<FILE*>(fp));
 #ifdef DEBUG
         fprintf(stderr, "Read file '%s', %zu bytes\n", filePath, length);
 #endif
-        buff.SetData(data, length);
 
         CloseFile(fp);
     } else {
@@ -133,6 +494,30 @@ Buffer AssetLoader::SyncOpenAndReadBinary(const char* filePath) {
     return buff;
 }
 
+Buffer AssetLoader::MapFile(const AssetFilePtr& fp, size_t length) {
+#if defined(MYGE_MAPPED_READS)
+    int fd = fileno(static_cast<FILE*>(fp));
+
+    // private mapping, a parser writing into the buffer gets its own copy
+    // of the page and never touches the file
+    void* p =
+        mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+        return Buffer();
+    }
+
+    // parsers walk the file front to back, and all of it is needed
+    madvise(p, length, MADV_SEQUENTIAL);
+    madvise(p, length, MADV_WILLNEED);
+
+    // the mapping stays valid after the file is closed
+    return Buffer(static_cast<uint8_t*>(p), length,
+                  [length](uint8_t* data) { munmap(data, length); });
+#else
+    return Buffer();
+#endif
+}
+
 void AssetLoader::CloseFile(AssetFilePtr& fp) {
     fclose((FILE*)fp);
     fp = nullptr;
@@ -149,6 +534,224 @@ size_t AssetLoader::GetSize(const AssetFilePtr& fp) {
     return length;
 }
 
+AssetLoader::AsyncRequestId AssetLoader::AsyncReadBinary(
+    const char* filePath, int32_t priority, AsyncReadCallback callback) {
+    lock_guard<mutex> lock(m_AsyncMutex);
+
+    StartIoThreads();
+
+    AsyncRequestId id = m_nNextRequestId++;
+
+    auto& read = m_mapPendingReads[filePath];
+    if (!read) {
+        read = make_shared<PendingRead>();
+        read->name = filePath;
+        read->priority = priority;
+        read->sequence = m_nNextSequence++;
+        m_AsyncQueue.push({priority, read->sequence, read});
+    } else if (read->queued && priority > read->priority) {
+        read->priority = priority;
+        m_AsyncQueue.push({priority, read->sequence, read});
+    }
+
+    read->waiters.emplace_back(id, std::move(callback));
+    m_mapAsyncRequests.emplace(id, read);
+
+    m_AsyncCondition.notify_one();
+
+    return id;
+}
+
+future<Buffer> AssetLoader::AsyncReadBinary(const char* filePath,
+                                            int32_t priority) {
+    auto promise = make_shared<std::promise<Buffer>>();
+    auto result = promise->get_future();
+
+    AsyncReadBinary(filePath, priority, [promise](Buffer buf) {
+        promise->set_value(std::move(buf));
+    });
+
+    return result;
+}
+
+bool AssetLoader::CancelAsyncRead(AsyncRequestId id) {
+    // released after the lock, whatever the callback holds
+    AsyncReadCallback callback;
+
+    lock_guard<mutex> lock(m_AsyncMutex);
+
+    auto it = m_mapAsyncRequests.find(id);
+    if (it == m_mapAsyncRequests.end()) {
+        return false;
+    }
+
+    auto read = it->second;
+    m_mapAsyncRequests.erase(it);
+
+    auto& waiters = read->waiters;
+    for (auto waiter = waiters.begin(); waiter != waiters.end(); waiter++) {
+        if (waiter->first == id) {
+            callback = std::move(waiter->second);
+            waiters.erase(waiter);
+            break;
+        }
+    }
+
+    // nobody is left waiting for a queued read, its queue entries are
+    // skipped. a read in flight completes and is thrown away.
+    if (waiters.empty() && read->queued) {
+        read->queued = false;
+        m_mapPendingReads.erase(read->name);
+    }
+
+    return true;
+}
+
+void AssetLoader::StartIoThreads() {
+    // called with m_AsyncMutex held
+    if (!m_IoThreads.empty()) return;
+
+    for (size_t i = 0; i < kIoThreadCount; i++) {
+        m_IoThreads.emplace_back(&AssetLoader::IoThreadMain, this);
+    }
+}
+
+void AssetLoader::IoThreadMain() {
+#if defined(USE_IO_URING)
+    // each thread owns a ring, the reads it takes from the queue in one go
+    // are submitted and reaped with a single syscall
+    IoUring ring(kIoBatchSize);
+    const size_t batch_size = ring.IsValid() ? kIoBatchSize : 1;
+#else
+    const size_t batch_size = 1;
+#endif
+
+    while (true) {
+        vector<shared_ptr<PendingRead>> batch;
+
+        {
+            unique_lock<mutex> lock(m_AsyncMutex);
+            m_AsyncCondition.wait(lock, [this] {
+                return m_bStopIoThreads || !m_AsyncQueue.empty();
+            });
+
+            if (m_bStopIoThreads) return;
+
+            while (!m_AsyncQueue.empty() && batch.size() < batch_size) {
+                QueueEntry entry = m_AsyncQueue.top();
+                m_AsyncQueue.pop();
+
+                // cancelled, or pushed again with a higher priority
+                if (!entry.read->queued ||
+                    entry.priority != entry.read->priority) {
+                    continue;
+                }
+
+                entry.read->queued = false;
+                batch.push_back(std::move(entry.read));
+            }
+        }
+
+        vector<Buffer> buffers(batch.size());
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            buffers[i] = ReadFromArchives(batch[i]->name.c_str());
+        }
+
+#if defined(USE_IO_URING)
+        if (ring.IsValid()) {
+            ReadBatch(ring, batch, buffers);
+        }
+#endif
+
+        // without a ring, and for what the ring failed to read
+        for (size_t i = 0; i < batch.size(); i++) {
+            const char* name = batch[i]->name.c_str();
+            if (!buffers[i].GetData() && FileExists(name)) {
+                buffers[i] = SyncOpenAndReadBinary(name);
+            }
+        }
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            Deliver(batch[i], buffers[i]);
+        }
+    }
+}
+
+void AssetLoader::Deliver(const shared_ptr<PendingRead>& read,
+                          const Buffer& buf) {
+    decltype(read->waiters) waiters;
+    {
+        lock_guard<mutex> lock(m_AsyncMutex);
+        waiters = std::move(read->waiters);
+        read->waiters.clear();
+        for (auto& waiter : waiters) {
+            m_mapAsyncRequests.erase(waiter.first);
+        }
+
+        // later requests for the file read it again
+        auto it = m_mapPendingReads.find(read->name);
+        if (it != m_mapPendingReads.end() && it->second == read) {
+            m_mapPendingReads.erase(it);
+        }
+    }
+
+    // a waiter may write into its buffer, so only one of them gets the
+    // store itself and the others a copy of it. the copies are taken
+    // before the store is handed out.
+    for (size_t i = 0; i < waiters.size(); i++) {
+        if (i + 1 == waiters.size() || !buf.GetData()) {
+            waiters[i].second(buf.View());
+        } else {
+            Buffer copy(buf.GetDataSize(), Buffer::kSimdAlignment);
+            memcpy(copy.GetData(), buf.GetData(), buf.GetDataSize());
+            waiters[i].second(std::move(copy));
+        }
+    }
+}
+
+#if defined(USE_IO_URING)
+void AssetLoader::ReadBatch(IoUring& ring,
+                            const vector<shared_ptr<PendingRead>>& batch,
+                            vector<Buffer>& buffers) {
+    vector<IoUring::Read> reads;
+    vector<size_t> indices;
+
+    for (size_t i = 0; i < batch.size(); i++) {
+        // served from an archive
+        if (buffers[i].GetData()) continue;
+
+        string path = ResolvePath(batch[i]->name.c_str());
+        if (path.empty()) continue;
+
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue;
+        RecordAccess(batch[i]->name.c_str());
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            continue;
+        }
+
+        auto size = static_cast<size_t>(st.st_size);
+        // page aligned, the same buffers work with O_DIRECT
+        buffers[i] = Buffer(size, Buffer::kPageAlignment);
+        reads.push_back({fd, buffers[i].GetData(), size});
+        indices.push_back(i);
+    }
+
+    ring.ReadAll(reads);
+
+    for (size_t j = 0; j < reads.size(); j++) {
+        close(reads[j].fd);
+        if (reads[j].error) {
+            buffers[indices[j]] = Buffer();
+        }
+    }
+}
+#endif
+
 size_t AssetLoader::SyncRead(const AssetFilePtr& fp, Buffer& buf) {
     size_t sz;
 
@@ -1,7 +1,18 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -9,11 +20,27 @@
 #include "IRuntimeModule.hpp"
 
 namespace My {
+class IoUring;
+class PakArchive;
+
 class AssetLoader : public IRuntimeModule {
    public:
-    ~AssetLoader() override = default;
+    AssetLoader() = default;
+    // records the assets read during the run to manifest, see Initialize
+    explicit AssetLoader(const char* manifest) : m_strManifest(manifest) {}
+    ~AssetLoader() override { Finalize(); }
     using AssetFilePtr = void*;
 
+    using AsyncRequestId = uint64_t;
+
+    // reads block on the disk, not on the CPU. a few threads keep requests
+    // in flight without competing with the decoders.
+    static constexpr size_t kIoThreadCount = 4;
+
+    // called on an I/O thread with the content of the file, the buffer
+    // is empty when the file could not be read
+    using AsyncReadCallback = std::function<void(Buffer)>;
+
     enum AssetOpenMode {
         MY_OPEN_TEXT = 0,    /// Open In Text Mode
         MY_OPEN_BINARY = 1,  /// Open In Binary Mode
@@ -25,8 +52,14 @@ class AssetLoader : public IRuntimeModule {
         MY_SEEK_END = 2   /// SEEK_END
     };
 
-    int Initialize() override { return 0; }
-    void Finalize() override {}
+    // mounts Asset.pak when there is one. with a manifest, the files it
+    // lists are prefetched in the background, in the order the previous
+    // run read them.
+    int Initialize() override;
+    // drops the reads still queued, joins the I/O threads and unmounts
+    // the archives. with a manifest, the assets read during this run are
+    // written to it.
+    void Finalize() override;
     void Tick() override {}
 
     bool AddSearchPath(const char* path);
@@ -35,14 +68,52 @@ class AssetLoader : public IRuntimeModule {
 
     void ClearSearchPath();
 
+    // forgets every resolved and missing path, call it when files appear
+    // or move on disk. changing the search paths does it as well.
+    void InvalidatePathCache();
+
+    // entries of mounted archives shadow loose files of the same name, the
+    // archive mounted last is searched first. the archive is found like
+    // any other asset.
+    bool MountArchive(const char* name);
+
+    void UnmountArchives();
+
     virtual bool FileExists(const char* filePath);
 
+    struct FileStamp {
+        uint64_t size;
+        // nanoseconds, as fine as the file system records it
+        int64_t modified;
+        // absolute
+        std::string path;
+    };
+
+    // size, modification time and path of a loose file, false when the
+    // file is missing or an archive shadows it
+    bool GetFileStamp(const char* filePath, FileStamp& stamp);
+
     virtual AssetFilePtr OpenFile(const char* name, AssetOpenMode mode);
 
     virtual Buffer SyncOpenAndReadText(const char* filePath);
 
+    // large files are memory mapped where the platform allows, the
+    // buffer is then a view over the page cache
     virtual Buffer SyncOpenAndReadBinary(const char* filePath);
 
+    // queues a read of filePath on the I/O threads, higher priorities are
+    // read first. a request for a file already queued or being read
+    // shares that read. the id returned can be passed to CancelAsyncRead.
+    AsyncRequestId AsyncReadBinary(const char* filePath, int32_t priority,
+                                   AsyncReadCallback callback);
+
+    std::future<Buffer> AsyncReadBinary(const char* filePath,
+                                        int32_t priority = 0);
+
+    // true when the callback of the request is guaranteed not to be
+    // called, false when it has already been called or is being called
+    bool CancelAsyncRead(AsyncRequestId id);
+
     virtual size_t SyncRead(const AssetFilePtr& fp, Buffer& buf);
 
     virtual void CloseFile(AssetFilePtr& fp);
@@ -65,8 +136,96 @@ class AssetLoader : public IRuntimeModule {
         return result;
     }
 
+   protected:
+    // maps length bytes of an open file, empty if mapping is not possible
+    Buffer MapFile(const AssetFilePtr& fp, size_t length);
+
+    // the path name resolves to on disk, empty if there is none
+    std::string ResolvePath(const char* name);
+
+    // the entry of the first archive holding name, empty if none does
+    Buffer ReadFromArchives(const char* name);
+    bool ArchivesContain(const char* name);
+
+    // notes the first read of name for the manifest
+    void RecordAccess(const char* name);
+
    private:
+    // with m_PathCacheMutex held
+    void ClearPathCache();
+
+    // logical asset name to resolved absolute path, and names known to be
+    // missing. textures are loaded from worker threads, hence the mutex,
+    // which guards the search path as well.
+    std::mutex m_PathCacheMutex;
     std::vector<std::string> m_strSearchPath;
+    std::unordered_map<std::string, std::string> m_mapResolvedPaths;
+    std::unordered_set<std::string> m_setMissingPaths;
+    // bumped whenever the cache is cleared
+    uint64_t m_nPathCacheGeneration{0};
+
+    std::mutex m_ArchiveMutex;
+    std::vector<std::shared_ptr<PakArchive>> m_Archives;
+
+    void PrefetchThreadMain(std::vector<std::string> names);
+    void WriteManifest();
+
+    std::string m_strManifest;
+    std::mutex m_ManifestMutex;
+    std::chrono::steady_clock::time_point m_RecordingStart;
+    // assets in the order of their first read, with the milliseconds
+    // since Initialize
+    std::vector<std::pair<std::string, uint32_t>> m_Accesses;
+    std::unordered_set<std::string> m_setAccessed;
+    std::thread m_PrefetchThread;
+    std::atomic<bool> m_bStopPrefetch{false};
+
+    // a read shared by every request for the same file
+    struct PendingRead {
+        std::string name;
+        int32_t priority;
+        uint64_t sequence;
+        bool queued{true};
+        std::vector<std::pair<AsyncRequestId, AsyncReadCallback>> waiters;
+    };
+
+    // raising the priority of a queued read pushes it again, the entry
+    // left behind is skipped when it comes up
+    struct QueueEntry {
+        int32_t priority;
+        uint64_t sequence;
+        std::shared_ptr<PendingRead> read;
+
+        bool operator<(const QueueEntry& rhs) const {
+            if (priority != rhs.priority) return priority < rhs.priority;
+            return sequence > rhs.sequence;
+        }
+    };
+
+    void StartIoThreads();
+    void IoThreadMain();
+    // hands the content of a finished read to its waiters
+    void Deliver(const std::shared_ptr<PendingRead>& read, const Buffer& buf);
+#if defined(USE_IO_URING)
+    // reads a batch through the ring, what fails is left empty
+    void ReadBatch(IoUring& ring,
+                   const std::vector<std::shared_ptr<PendingRead>>& batch,
+                   std::vector<Buffer>& buffers);
+#endif
+
+    std::mutex m_AsyncMutex;
+    std::condition_variable m_AsyncCondition;
+    std::priority_queue<QueueEntry> m_AsyncQueue;
+    // queued and in-flight reads by file name
+    std::unordered_map<std::string, std::shared_ptr<PendingRead>>
+        m_mapPendingReads;
+    // requests not yet delivered
+    std::unordered_map<AsyncRequestId, std::shared_ptr<PendingRead>>
+        m_mapAsyncRequests;
+    std::vector<std::thread> m_IoThreads;
+    AsyncRequestId m_nNextRequestId{1};
+    uint64_t m_nNextSequence{0};
+    bool m_bStopIoThreads{false};
 };
 
 extern AssetLoader* g_pAssetLoader;
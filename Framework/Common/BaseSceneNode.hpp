@@ -1,5 +1,6 @@
 #pragma once
 #include <map>
+#include <memory_resource>
 #include <string>
 #include <vector>
 
@@ -11,7 +12,9 @@ namespace My {
 class BaseSceneNode : public TreeNode {
    protected:
     std::string m_strName;
-    std::vector<std::shared_ptr<SceneObjectTransform>> m_Transforms;
+    // keeps the resource m_Transforms allocates from alive
+    std::shared_ptr<std::pmr::memory_resource> m_pMemoryResource;
+    std::pmr::vector<std::shared_ptr<SceneObjectTransform>> m_Transforms;
     std::map<int, std::shared_ptr<SceneObjectAnimationClip>> m_AnimationClips;
     std::map<std::string, std::shared_ptr<SceneObjectTransform>> m_LUTtransform;
     Matrix4X4f m_RuntimeTransform;
@@ -27,6 +30,13 @@ class BaseSceneNode : public TreeNode {
         m_strName = name;
         BuildIdentityMatrix(m_RuntimeTransform);
     };
+    BaseSceneNode(const std::string& name,
+                  std::shared_ptr<std::pmr::memory_resource> resource)
+        : m_strName(name),
+          m_pMemoryResource(std::move(resource)),
+          m_Transforms(m_pMemoryResource.get()) {
+        BuildIdentityMatrix(m_RuntimeTransform);
+    };
     ~BaseSceneNode() override = default;
 
     [[nodiscard]] std::string GetName() const { return m_strName; };
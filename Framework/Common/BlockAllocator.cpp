@@ -3,6 +3,8 @@
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "MemoryManager.hpp"
 
@@ -13,20 +15,50 @@
 using namespace My;
 using namespace std;
 
-BlockAllocator::BlockAllocator() = default;
+namespace {
+uint64_t NextAllocatorId() {
+    static atomic<uint64_t> s_nNextId{1};
+    return s_nNextId.fetch_add(1, memory_order_relaxed);
+}
+
+struct ThreadCacheEntry {
+    const BlockAllocator* pAllocator;
+    uint64_t nAllocatorId;
+    ThreadCache* pCache;
+    // used only at thread exit, the allocator might be gone by then
+    weak_ptr<ThreadCache> wpCache;
+};
+
+struct ThreadCacheTable {
+    vector<ThreadCacheEntry> entries;
+
+    ~ThreadCacheTable() {
+        for (auto& entry : entries) {
+            if (auto pCache = entry.wpCache.lock()) {
+                pCache->bAbandoned.store(true, memory_order_release);
+            }
+        }
+    }
+};
+
+thread_local ThreadCacheTable t_ThreadCacheTable;
+}  // namespace
+
+BlockAllocator::BlockAllocator() : m_nId(NextAllocatorId()) {}
 
 BlockAllocator::BlockAllocator(size_t data_size, size_t page_size,
-                               size_t alignment)
-    : m_pPageList(nullptr), m_pFreeList(nullptr) {
-    Reset(data_size, page_size, alignment);
+                               size_t alignment, MemoryTag tag)
+    : m_nId(NextAllocatorId()) {
+    Reset(data_size, page_size, alignment, tag);
 }
 
 BlockAllocator::~BlockAllocator() { FreeAll(); }
 
 void BlockAllocator::Reset(size_t data_size, size_t page_size,
-                           size_t alignment) {
+                           size_t alignment, MemoryTag tag) {
     FreeAll();
 
+    m_Tag = tag;
     m_szPageSize = page_size;
 
     size_t minimal_size =
@@ -36,6 +68,7 @@ void BlockAllocator::Reset(size_t data_size, size_t page_size,
     // we use a assert to guarantee it
 #if defined(_DEBUG)
     assert(alignment > 0 && ((alignment & (alignment - 1))) == 0);
+    assert(page_size > 0 && ((page_size & (page_size - 1))) == 0);
 #endif
     m_szBlockSize = ALIGN(minimal_size, alignment);
 
@@ -50,40 +83,20 @@ void* BlockAllocator::Allocate(size_t size) {
 }
 
 void* BlockAllocator::Allocate() {
-    if (!m_pFreeList) {
-        // allocate a new page
-        auto* pNewPage = reinterpret_cast<PageHeader*>(
-            g_pMemoryManager->AllocatePage(m_szPageSize));
-        ++m_nPages;
-        m_nBlocks += m_nBlocksPerPage;
-        m_nFreeBlocks += m_nBlocksPerPage;
+    ThreadCache* pCache = GetThreadCache();
 
-#if defined(_DEBUG)
-        FillFreePage(pNewPage);
-#endif
-
-        if (m_pPageList) {
-            pNewPage->pNext = m_pPageList;
-        } else {
-            pNewPage->pNext = nullptr;
-        }
-
-        m_pPageList = pNewPage;
-
-        BlockHeader* pBlock = pNewPage->Blocks();
-        // link each block in the page
-        for (uint32_t i = 0; i < m_nBlocksPerPage - 1; i++) {
-            pBlock->pNext = NextBlock(pBlock);
-            pBlock = NextBlock(pBlock);
-        }
-        pBlock->pNext = nullptr;
+    if (!pCache->pFreeList) {
+        // take back everything other threads have freed to us
+        pCache->pFreeList =
+            pCache->pRemoteFreeList.exchange(nullptr, memory_order_acquire);
+    }
 
-        m_pFreeList = pNewPage->Blocks();
+    if (!pCache->pFreeList) {
+        AllocateNewPage(pCache);
     }
 
-    BlockHeader* freeBlock = m_pFreeList;
-    m_pFreeList = m_pFreeList->pNext;
-    --m_nFreeBlocks;
+    BlockHeader* freeBlock = pCache->pFreeList;
+    pCache->pFreeList = freeBlock->pNext;
 
 #if defined(_DEBUG)
     FillAllocatedBlock(freeBlock);
@@ -99,12 +112,24 @@ void BlockAllocator::Free(void* p) {
     FillFreeBlock(block);
 #endif
 
-    block->pNext = m_pFreeList;
-    m_pFreeList = block;
-    ++m_nFreeBlocks;
+    ThreadCache* pOwner = PageOf(block)->pOwner;
+
+    if (pOwner == FindThreadCache()) {
+        block->pNext = pOwner->pFreeList;
+        pOwner->pFreeList = block;
+    } else {
+        // lock-free push, the owner pops the whole list at once so there
+        // is no ABA problem here
+        block->pNext = pOwner->pRemoteFreeList.load(memory_order_relaxed);
+        while (!pOwner->pRemoteFreeList.compare_exchange_weak(
+            block->pNext, block, memory_order_release, memory_order_relaxed)) {
+        }
+    }
 }
 
 void BlockAllocator::FreeAll() {
+    lock_guard<mutex> lock(m_Mutex);
+
     PageHeader* pPage = m_pPageList;
     while (pPage) {
         PageHeader* _p = pPage;
@@ -114,17 +139,160 @@ void BlockAllocator::FreeAll() {
     }
 
     m_pPageList = nullptr;
-    m_pFreeList = nullptr;
+
+    // keep the caches alive, threads still refer to them
+    for (auto& pCache : m_ThreadCaches) {
+        pCache->pFreeList = nullptr;
+        pCache->pRemoteFreeList.store(nullptr, memory_order_relaxed);
+    }
 
     m_nPages = 0;
     m_nBlocks = 0;
-    m_nFreeBlocks = 0;
+}
+
+size_t BlockAllocator::Trim() {
+    ThreadCache* pCache = FindThreadCache();
+    if (!pCache) return 0;
+
+    // take back the remote frees too, they may complete a page
+    BlockHeader* pRemote =
+        pCache->pRemoteFreeList.exchange(nullptr, memory_order_acquire);
+    if (pRemote) {
+        BlockHeader* pTail = pRemote;
+        while (pTail->pNext) pTail = pTail->pNext;
+        pTail->pNext = pCache->pFreeList;
+        pCache->pFreeList = pRemote;
+    }
+
+    unordered_map<PageHeader*, size_t> free_blocks;
+    for (BlockHeader* pBlock = pCache->pFreeList; pBlock;
+         pBlock = pBlock->pNext) {
+        ++free_blocks[PageOf(pBlock)];
+    }
+
+    unordered_set<PageHeader*> empty_pages;
+    for (const auto& page : free_blocks) {
+        if (page.second == m_nBlocksPerPage) {
+            empty_pages.insert(page.first);
+        }
+    }
+
+    if (empty_pages.empty()) return 0;
+
+    // drop the blocks of the empty pages from the free list
+    BlockHeader** ppBlock = &pCache->pFreeList;
+    while (*ppBlock) {
+        if (empty_pages.count(PageOf(*ppBlock))) {
+            *ppBlock = (*ppBlock)->pNext;
+        } else {
+            ppBlock = &(*ppBlock)->pNext;
+        }
+    }
+
+    lock_guard<mutex> lock(m_Mutex);
+
+    PageHeader** ppPage = &m_pPageList;
+    while (*ppPage) {
+        PageHeader* pPage = *ppPage;
+        if (empty_pages.count(pPage)) {
+            *ppPage = pPage->pNext;
+            g_pMemoryManager->FreePage(reinterpret_cast<void*>(pPage));
+        } else {
+            ppPage = &pPage->pNext;
+        }
+    }
+
+    m_nPages -= empty_pages.size();
+    m_nBlocks -= empty_pages.size() * m_nBlocksPerPage;
+
+    return empty_pages.size();
+}
+
+void BlockAllocator::AllocateNewPage(ThreadCache* pCache) {
+    auto* pNewPage = reinterpret_cast<PageHeader*>(
+        g_pMemoryManager->AllocatePage(m_szPageSize, m_Tag));
+    assert(PageOf(pNewPage->Blocks()) == pNewPage);
+
+#if defined(_DEBUG)
+    FillFreePage(pNewPage);
+#endif
+
+    pNewPage->pOwner = pCache;
+
+    {
+        lock_guard<mutex> lock(m_Mutex);
+        ++m_nPages;
+        m_nBlocks += m_nBlocksPerPage;
+
+        pNewPage->pNext = m_pPageList;
+        m_pPageList = pNewPage;
+    }
+
+    BlockHeader* pBlock = pNewPage->Blocks();
+    // link each block in the page
+    for (uint32_t i = 0; i < m_nBlocksPerPage - 1; i++) {
+        pBlock->pNext = NextBlock(pBlock);
+        pBlock = NextBlock(pBlock);
+    }
+    pBlock->pNext = nullptr;
+
+    pCache->pFreeList = pNewPage->Blocks();
+}
+
+ThreadCache* BlockAllocator::FindThreadCache() {
+    for (auto& entry : t_ThreadCacheTable.entries) {
+        if (entry.pAllocator == this && entry.nAllocatorId == m_nId) {
+            return entry.pCache;
+        }
+    }
+
+    return nullptr;
+}
+
+ThreadCache* BlockAllocator::GetThreadCache() {
+    ThreadCache* pCache = FindThreadCache();
+    if (pCache) return pCache;
+
+    shared_ptr<ThreadCache> spCache;
+    {
+        lock_guard<mutex> lock(m_Mutex);
+
+        // adopt the cache of an exited thread first, so its pages and
+        // the blocks freed to it are not lost
+        for (auto& pAbandoned : m_ThreadCaches) {
+            bool expected = true;
+            if (pAbandoned->bAbandoned.compare_exchange_strong(
+                    expected, false, memory_order_acquire)) {
+                spCache = pAbandoned;
+                break;
+            }
+        }
+
+        if (!spCache) {
+            spCache = make_shared<ThreadCache>();
+            m_ThreadCaches.push_back(spCache);
+        }
+    }
+
+    auto& entries = t_ThreadCacheTable.entries;
+    ThreadCacheEntry entry = {this, m_nId, spCache.get(), spCache};
+    for (auto& slot : entries) {
+        if (slot.pAllocator == this || slot.wpCache.expired()) {
+            // stale entry from a destroyed allocator
+            slot = entry;
+            return spCache.get();
+        }
+    }
+    entries.push_back(entry);
+
+    return spCache.get();
 }
 
 #if defined(_DEBUG)
 void BlockAllocator::FillFreePage(PageHeader* pPage) {
     // page header
     pPage->pNext = nullptr;
+    pPage->pOwner = nullptr;
 
     // blocks
     BlockHeader* pBlock = pPage->Blocks();
@@ -160,3 +328,8 @@ My::BlockHeader* BlockAllocator::NextBlock(BlockHeader* pBlock) {
     return reinterpret_cast<BlockHeader*>(reinterpret_cast<uint8_t*>(pBlock) +
                                           m_szBlockSize);
 }
+
+My::PageHeader* BlockAllocator::PageOf(BlockHeader* pBlock) {
+    return reinterpret_cast<PageHeader*>(reinterpret_cast<uintptr_t>(pBlock) &
+                                         ~(uintptr_t)(m_szPageSize - 1));
+}
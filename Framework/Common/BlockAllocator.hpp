@@ -1,8 +1,13 @@
 #pragma once
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 #include "IAllocator.hpp"
+#include "IMemoryManager.hpp"
 
 namespace My {
 
@@ -11,29 +16,55 @@ struct BlockHeader {
     BlockHeader* pNext;
 };
 
+// per-thread magazine of free blocks. the owning thread pops and pushes
+// pFreeList without synchronization, other threads hand blocks back
+// through the lock-free pRemoteFreeList.
+struct ThreadCache {
+    BlockHeader* pFreeList{nullptr};
+    std::atomic<BlockHeader*> pRemoteFreeList{nullptr};
+    // set when the owning thread exits, the next new thread adopts it
+    std::atomic<bool> bAbandoned{false};
+};
+
 struct PageHeader {
     PageHeader* pNext;
+    // the thread cache which owns all blocks of this page
+    ThreadCache* pOwner;
     BlockHeader* Blocks() { return reinterpret_cast<BlockHeader*>(this + 1); }
 };
 
 class BlockAllocator : _implements_ IAllocator {
    public:
     BlockAllocator();
-    BlockAllocator(size_t data_size, size_t page_size, size_t alignment);
+    BlockAllocator(size_t data_size, size_t page_size, size_t alignment,
+                   MemoryTag tag = MemoryTag::kGeneral);
     ~BlockAllocator() override;
     // disable copy & assignment
     BlockAllocator(const BlockAllocator& clone) = delete;
     BlockAllocator& operator=(const BlockAllocator& rhs) = delete;
 
     // resets the allocator to a new configuration
-    void Reset(size_t data_size, size_t page_size, size_t alignment);
+    // page_size must be 2^n, pages are aligned to their size so that
+    // the page header of any block can be found by masking its address
+    void Reset(size_t data_size, size_t page_size, size_t alignment,
+               MemoryTag tag = MemoryTag::kGeneral);
 
-    // alloc and free blocks
+    // alloc and free blocks, both are thread safe
     void* Allocate();
     void* Allocate(size_t size) override;
     void Free(void* p) override;
+    // must not race with Allocate / Free
     void FreeAll() override;
 
+    // returns the pages of the calling thread's cache whose blocks are
+    // all free to the memory manager, gives the number of pages released.
+    // blocks still sitting in other threads' caches keep their page alive.
+    size_t Trim();
+
+    [[nodiscard]] size_t GetBlockSize() const { return m_szBlockSize; }
+    [[nodiscard]] size_t GetPageCount() const { return m_nPages; }
+    [[nodiscard]] size_t GetBlockCount() const { return m_nBlocks; }
+
    private:
 #if defined(_DEBUG)
     // fill a free page with debug patterns
@@ -49,20 +80,41 @@ class BlockAllocator : _implements_ IAllocator {
     // gets the next block
     BlockHeader* NextBlock(BlockHeader* pBlock);
 
+    // gets the page which contains the block
+    PageHeader* PageOf(BlockHeader* pBlock);
+
+    // gets the cache of the calling thread, nullptr if it has none yet
+    ThreadCache* FindThreadCache();
+
+    // gets or creates the cache of the calling thread
+    ThreadCache* GetThreadCache();
+
+    // allocates a new page and hands all its blocks to the cache
+    void AllocateNewPage(ThreadCache* pCache);
+
+    // unique per instance, so a stale thread local entry is never
+    // mistaken for an allocator constructed at the same address
+    uint64_t m_nId;
+
+    // guards the page list, the cache list and the statistics
+    std::mutex m_Mutex;
+
     // the page list
-    PageHeader* m_pPageList;
+    PageHeader* m_pPageList{nullptr};
+
+    // all thread caches ever created for this allocator
+    std::vector<std::shared_ptr<ThreadCache>> m_ThreadCaches;
 
-    // the free block list
-    BlockHeader* m_pFreeList;
+    // pages are accounted to this tag
+    MemoryTag m_Tag{MemoryTag::kGeneral};
 
-    size_t m_szPageSize;
-    size_t m_szAlignmentSize;
-    size_t m_szBlockSize;
-    size_t m_nBlocksPerPage;
+    size_t m_szPageSize{0};
+    size_t m_szAlignmentSize{0};
+    size_t m_szBlockSize{0};
+    size_t m_nBlocksPerPage{0};
 
     // statistics
-    size_t m_nPages;
-    size_t m_nBlocks;
-    size_t m_nFreeBlocks;
+    size_t m_nPages{0};
+    size_t m_nBlocks{0};
 };
 }  // namespace My
@@ -1,23 +1,58 @@
 #pragma once
+#include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
 
+#include "config.h"
+
+#if defined(OS_WINDOWS)
+#include <malloc.h>
+#endif
+
 namespace My {
+// a range of bytes inside a ref-counted backing store. views and slices
+// share the store of the buffer they are taken from, the store is
+// released together with the last buffer referring to it.
 class Buffer {
    public:
+    // SIMD loads and stores
+    static constexpr size_t kSimdAlignment = 64;
+    // direct (unbuffered) I/O
+    static constexpr size_t kPageAlignment = 4096;
+
     Buffer() = default;
 
     explicit Buffer(size_t size, size_t alignment = 4) : m_szSize(size) {
-        m_pData = reinterpret_cast<uint8_t*>(new uint8_t[size]);
+        if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            // new[] aligns this far, and MoveData can hand it out as is
+            m_pData = new uint8_t[size ? size : 1];
+            m_pStore.reset(m_pData, ArrayDeleter());
+        } else {
+            m_pData = AllocateAligned(size, alignment);
+            if (!m_pData) {
+                // out of memory, the buffer is left empty
+                m_szSize = 0;
+                return;
+            }
+            m_pStore.reset(m_pData, FreeAligned);
+        }
     }
 
+    // adopts memory released by deleter once no buffer refers to it
+    template <typename Deleter>
+    Buffer(uint8_t* data, size_t size, Deleter deleter)
+        : m_pStore(data, deleter), m_pData(data), m_szSize(size) {}
+
+    // sharing a store is explicit, see View and Slice
     Buffer(const Buffer& rhs) = delete;
 
-    Buffer(Buffer&& rhs) noexcept {
-        m_pData = rhs.m_pData;
-        m_szSize = rhs.m_szSize;
+    Buffer(Buffer&& rhs) noexcept
+        : m_pStore(std::move(rhs.m_pStore)),
+          m_pData(rhs.m_pData),
+          m_szSize(rhs.m_szSize) {
         rhs.m_pData = nullptr;
         rhs.m_szSize = 0;
     }
@@ -25,7 +60,7 @@ class Buffer {
     Buffer& operator=(const Buffer& rhs) = delete;
 
     Buffer& operator=(Buffer&& rhs) noexcept {
-        delete[] m_pData;
+        m_pStore = std::move(rhs.m_pStore);
         m_pData = rhs.m_pData;
         m_szSize = rhs.m_szSize;
         rhs.m_pData = nullptr;
@@ -33,31 +68,93 @@ class Buffer {
         return *this;
     }
 
-    ~Buffer() {
-        if (m_pData != nullptr) {
-            delete[] m_pData;
-        }
-    }
+    ~Buffer() = default;
 
     [[nodiscard]] uint8_t* GetData() { return m_pData; };
     [[nodiscard]] const uint8_t* GetData() const { return m_pData; };
     [[nodiscard]] size_t GetDataSize() const { return m_szSize; };
+
+    // hands out the data allocated with new[], which the caller then owns,
+    // and empties the buffer. the store itself is handed out when nothing
+    // else refers to it and it came from new[], else a copy.
     uint8_t* MoveData() {
-        uint8_t* tmp = m_pData;
+        uint8_t* tmp = nullptr;
+        auto* deleter = std::get_deleter<ArrayDeleter>(m_pStore);
+        if (m_pData && deleter && !IsShared() &&
+            m_pData == m_pStore.get()) {
+            deleter->released = true;
+            tmp = m_pData;
+        } else if (m_pData) {
+            tmp = new uint8_t[m_szSize];
+            memcpy(tmp, m_pData, m_szSize);
+        }
+        m_pStore.reset();
         m_pData = nullptr;
         m_szSize = 0;
         return tmp;
     }
 
+    // adopts data allocated with new[]
     void SetData(uint8_t* data, size_t size) {
-        if (m_pData != nullptr) {
-            delete[] m_pData;
-        }
+        m_pStore.reset(data, ArrayDeleter());
         m_pData = data;
         m_szSize = size;
     }
 
+    // the whole buffer, sharing the store. views are meant for reading,
+    // writes are seen by every buffer sharing the store.
+    [[nodiscard]] Buffer View() const { return Slice(0, m_szSize); }
+
+    // size bytes starting at offset, sharing the store
+    [[nodiscard]] Buffer Slice(size_t offset, size_t size) const {
+        assert(offset <= m_szSize && size <= m_szSize - offset);
+        Buffer slice;
+        slice.m_pStore = m_pStore;
+        slice.m_pData = m_pData + offset;
+        slice.m_szSize = size;
+        return slice;
+    }
+
+    // true when other buffers refer to the same store
+    [[nodiscard]] bool IsShared() const { return m_pStore.use_count() > 1; }
+
+    [[nodiscard]] bool IsAligned(size_t alignment) const {
+        return (reinterpret_cast<uintptr_t>(m_pData) & (alignment - 1)) == 0;
+    }
+
    protected:
+    // delete[], unless MoveData handed the data out
+    struct ArrayDeleter {
+        bool released{false};
+        void operator()(uint8_t* p) const {
+            if (!released) delete[] p;
+        }
+    };
+
+    static uint8_t* AllocateAligned(size_t size, size_t alignment) {
+        assert(alignment > 0 && ((alignment & (alignment - 1))) == 0);
+        if (alignment < sizeof(void*)) alignment = sizeof(void*);
+        if (size == 0) size = 1;
+
+#if defined(OS_WINDOWS)
+        return static_cast<uint8_t*>(_aligned_malloc(size, alignment));
+#else
+        void* p = nullptr;
+        return (posix_memalign(&p, alignment, size) == 0)
+                   ? static_cast<uint8_t*>(p)
+                   : nullptr;
+#endif
+    }
+
+    static void FreeAligned(uint8_t* p) {
+#if defined(OS_WINDOWS)
+        _aligned_free(p);
+#else
+        free(p);
+#endif
+    }
+
+    std::shared_ptr<uint8_t> m_pStore;
     uint8_t* m_pData{nullptr};
     size_t m_szSize{0};
 };
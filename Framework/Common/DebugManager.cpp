@@ -1,9 +1,11 @@
 #include "DebugManager.hpp"
 
+#include <iomanip>
 #include <iostream>
 
 #include "GraphicsManager.hpp"
 #include "IGameLogic.hpp"
+#include "IMemoryManager.hpp"
 #include "IPhysicsManager.hpp"
 
 using namespace My;
@@ -26,7 +28,40 @@ void DebugManager::Tick() {
 #endif
 }
 
-void DebugManager::ToggleDebugInfo() { m_bDrawDebugInfo = !m_bDrawDebugInfo; }
+void DebugManager::ToggleDebugInfo() {
+    m_bDrawDebugInfo = !m_bDrawDebugInfo;
+
+    if (m_bDrawDebugInfo) {
+        DumpMemoryStatistics();
+    }
+}
+
+void DebugManager::DumpMemoryStatistics() {
+    auto flags = cerr.flags();
+
+    cerr << "Memory Statistics" << endl;
+    cerr << "-----------------" << endl;
+    cerr << left << setw(18) << "Tag" << right << setw(14) << "In Use"
+         << setw(14) << "Peak" << setw(12) << "Allocs" << setw(12) << "Allocs/s"
+         << setw(14) << "Budget" << endl;
+
+    for (int32_t i = 0; i < static_cast<int32_t>(MemoryTag::kCount); i++) {
+        auto tag = static_cast<MemoryTag>(i);
+        auto statistics = g_pMemoryManager->GetStatistics(tag);
+        cerr << left << setw(18) << tag << right << setw(14)
+             << statistics.inUse << setw(14) << statistics.peak << setw(12)
+             << statistics.allocationCount << setw(12) << fixed
+             << setprecision(1) << statistics.allocationRate << setw(14);
+        if (statistics.budget) {
+            cerr << statistics.budget;
+        } else {
+            cerr << "-";
+        }
+        cerr << endl;
+    }
+
+    cerr.flags(flags);
+}
 
 void DebugManager::DrawDebugInfo() {
     DrawGrid();
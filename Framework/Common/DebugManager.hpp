@@ -11,6 +11,8 @@ class DebugManager : _implements_ IRuntimeModule {
 
     void ToggleDebugInfo();
 
+    static void DumpMemoryStatistics();
+
     void DrawDebugInfo() override;
 
    protected:
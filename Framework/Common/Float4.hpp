@@ -0,0 +1,88 @@
+#pragma once
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MYGE_FLOAT4_SSE 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#define MYGE_FLOAT4_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace My {
+// four floats in one SSE2 or NEON register. both are part of the 64 bit
+// targets, so unlike the shuffles of PixelConversion they need no run
+// time dispatch. plain floats stand in elsewhere.
+#if defined(MYGE_FLOAT4_SSE)
+struct Float4 {
+    __m128 v;
+
+    static Float4 Load(const float* p) { return {_mm_loadu_ps(p)}; }
+    static Float4 Splat(float f) { return {_mm_set1_ps(f)}; }
+    void Store(float* p) const { _mm_storeu_ps(p, v); }
+};
+
+inline Float4 operator+(Float4 a, Float4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline Float4 operator-(Float4 a, Float4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline Float4 operator*(Float4 a, Float4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline Float4 Min(Float4 a, Float4 b) { return {_mm_min_ps(a.v, b.v)}; }
+inline Float4 Max(Float4 a, Float4 b) { return {_mm_max_ps(a.v, b.v)}; }
+// t in the lanes where a < b, f in the others
+inline Float4 SelectLess(Float4 a, Float4 b, Float4 t, Float4 f) {
+    __m128 mask = _mm_cmplt_ps(a.v, b.v);
+    return {_mm_or_ps(_mm_and_ps(mask, t.v), _mm_andnot_ps(mask, f.v))};
+}
+#elif defined(MYGE_FLOAT4_NEON)
+struct Float4 {
+    float32x4_t v;
+
+    static Float4 Load(const float* p) { return {vld1q_f32(p)}; }
+    static Float4 Splat(float f) { return {vdupq_n_f32(f)}; }
+    void Store(float* p) const { vst1q_f32(p, v); }
+};
+
+inline Float4 operator+(Float4 a, Float4 b) { return {vaddq_f32(a.v, b.v)}; }
+inline Float4 operator-(Float4 a, Float4 b) { return {vsubq_f32(a.v, b.v)}; }
+inline Float4 operator*(Float4 a, Float4 b) { return {vmulq_f32(a.v, b.v)}; }
+inline Float4 Min(Float4 a, Float4 b) { return {vminq_f32(a.v, b.v)}; }
+inline Float4 Max(Float4 a, Float4 b) { return {vmaxq_f32(a.v, b.v)}; }
+inline Float4 SelectLess(Float4 a, Float4 b, Float4 t, Float4 f) {
+    return {vbslq_f32(vcltq_f32(a.v, b.v), t.v, f.v)};
+}
+#else
+struct Float4 {
+    float v[4];
+
+    static Float4 Load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+    static Float4 Splat(float f) { return {{f, f, f, f}}; }
+    void Store(float* p) const { std::copy(v, v + 4, p); }
+};
+
+template <typename Op>
+inline Float4 PerLane(Float4 a, Float4 b, Op op) {
+    for (int i = 0; i < 4; i++) a.v[i] = op(a.v[i], b.v[i]);
+    return a;
+}
+
+inline Float4 operator+(Float4 a, Float4 b) {
+    return PerLane(a, b, [](float x, float y) { return x + y; });
+}
+inline Float4 operator-(Float4 a, Float4 b) {
+    return PerLane(a, b, [](float x, float y) { return x - y; });
+}
+inline Float4 operator*(Float4 a, Float4 b) {
+    return PerLane(a, b, [](float x, float y) { return x * y; });
+}
+inline Float4 Min(Float4 a, Float4 b) {
+    return PerLane(a, b, [](float x, float y) { return std::min(x, y); });
+}
+inline Float4 Max(Float4 a, Float4 b) {
+    return PerLane(a, b, [](float x, float y) { return std::max(x, y); });
+}
+inline Float4 SelectLess(Float4 a, Float4 b, Float4 t, Float4 f) {
+    for (int i = 0; i < 4; i++) t.v[i] = (a.v[i] < b.v[i]) ? t.v[i] : f.v[i];
+    return t;
+}
+#endif
+}  // namespace My
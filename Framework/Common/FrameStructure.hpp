@@ -1,6 +1,8 @@
 #pragma once
+#include <memory_resource>
 #include <vector>
 
+#include "MemoryResource.hpp"
 #include "Scene.hpp"
 #include "cbuffer.h"
 
@@ -18,7 +20,8 @@ struct DrawBatchContext : PerBatchConstants {
 struct Frame : global_textures {
     int32_t frameIndex{0};
     DrawFrameContext frameContext;
-    std::vector<std::shared_ptr<DrawBatchContext>> batchContexts;
+    std::pmr::vector<std::shared_ptr<DrawBatchContext>> batchContexts{
+        GetMemoryResource(MemoryTag::kScene)};
     LightInfo lightInfo;
 };
 }  // namespace My
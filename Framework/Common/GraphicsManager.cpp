@@ -1,7 +1,9 @@
 #include "GraphicsManager.hpp"
 
+#include <cmath>
 #include <cstring>
 #include <iostream>
+#include <limits>
 
 #include "BRDFIntegrator.hpp"
 #include "ForwardGeometryPass.hpp"
@@ -14,6 +16,41 @@
 using namespace My;
 using namespace std;
 
+static const size_t kFrameAllocatorPageSize = 256 * 1024;
+static const size_t kFrameAllocatorAlignment = 16;
+
+static vector<shared_ptr<SceneObjectTexture>> GetMaterialTextures(
+    const SceneObjectMaterial& material) {
+    vector<shared_ptr<SceneObjectTexture>> textures;
+    for (const auto* texture :
+         {&material.GetBaseColor().ValueMap, &material.GetNormal().ValueMap,
+          &material.GetMetallic().ValueMap, &material.GetRoughness().ValueMap,
+          &material.GetAO().ValueMap, &material.GetHeight().ValueMap}) {
+        if (*texture) textures.push_back(*texture);
+    }
+    return textures;
+}
+
+// textures load when first asked for. asking for all of them up front
+// keeps the decode pool busy while the initializers below wait on each
+// in turn.
+static void RequestSceneTextures(const Scene& scene) {
+    for (const auto& entry : scene.Materials) {
+        const auto& material = entry.second;
+        if (!material) continue;
+
+        for (const auto& texture : GetMaterialTextures(*material)) {
+            texture->RequestImage();
+        }
+    }
+
+    if (scene.SkyBox) {
+        for (uint32_t i = 0; i < 18; i++) {
+            scene.SkyBox->GetTexture(i).RequestImage();
+        }
+    }
+}
+
 int GraphicsManager::Initialize() {
     int result = 0;
 #if !defined(OS_WEBASSEMBLY)
@@ -23,6 +60,11 @@ int GraphicsManager::Initialize() {
     m_DrawPasses.push_back(make_shared<ShadowMapPass>());
     m_DrawPasses.push_back(make_shared<ForwardGeometryPass>());
 
+    for (auto& allocator : m_FrameAllocators) {
+        allocator.Reset(kFrameAllocatorPageSize, kFrameAllocatorAlignment,
+                        MemoryTag::kFrame);
+    }
+
     InitConstants();
     return result;
 }
@@ -32,6 +74,10 @@ void GraphicsManager::Finalize() {
     ClearDebugBuffers();
 #endif
     EndScene();
+
+    for (auto& allocator : m_FrameAllocators) {
+        allocator.FreeAll();
+    }
 }
 
 void GraphicsManager::Tick() {
@@ -53,6 +99,8 @@ void GraphicsManager::Tick() {
     EndFrame(m_Frames[m_nFrameIndex]);
 
     Present();
+
+    SceneObjectTexture::AdvanceFrame();
 }
 
 void GraphicsManager::ResizeCanvas(int32_t width, int32_t height) {
@@ -93,6 +141,8 @@ void GraphicsManager::UpdateConstants() {
     // Generate the view matrix based on the camera's position.
     CalculateCameraMatrix();
     CalculateLights();
+    CalculateTextureDemand();
+    UpdateTerrainPages();
 }
 
 void GraphicsManager::Draw() {
@@ -142,6 +192,8 @@ void GraphicsManager::CalculateCameraMatrix() {
         farClipDistance = pCamera->GetFarClipDistance();
     }
 
+    m_fViewDistance = farClipDistance;
+
     const GfxConfiguration& conf = g_pApp->GetConfiguration();
 
     float screenAspect = (float)conf.screenWidth / (float)conf.screenHeight;
@@ -152,6 +204,61 @@ void GraphicsManager::CalculateCameraMatrix() {
                                 farClipDistance);
 }
 
+void GraphicsManager::CalculateTextureDemand() {
+    const auto& frame = m_Frames[m_nFrameIndex];
+    const auto& frameContext = frame.frameContext;
+    const GfxConfiguration& conf = g_pApp->GetConfiguration();
+
+    // the pixels a sphere of unit radius at unit distance is drawn across
+    const float scale = frameContext.projectionMatrix[1][1] *
+                        static_cast<float>(conf.screenHeight);
+
+    for (const auto& pDbc : frame.batchContexts) {
+        auto it = m_TextureDemands.find(pDbc->node.get());
+        if (it == m_TextureDemands.end()) continue;
+        const auto& demand = it->second;
+
+        Vector3f center = demand.centroid;
+        TransformCoord(center, pDbc->modelMatrix);
+
+        // the bounding sphere grows with the largest scale of the model
+        float axis = 0.0f;
+        for (int32_t i = 0; i < 3; i++) {
+            const auto& row = pDbc->modelMatrix[i];
+            axis = max(axis, sqrtf(row[0] * row[0] + row[1] * row[1] +
+                                   row[2] * row[2]));
+        }
+        float radius = demand.radius * axis;
+
+        float dx = center[0] - frameContext.camPos[0];
+        float dy = center[1] - frameContext.camPos[1];
+        float dz = center[2] - frameContext.camPos[2];
+        float distance = sqrtf(dx * dx + dy * dy + dz * dz);
+
+        // the camera inside the sphere asks for every level
+        float pixels = (distance > radius)
+                           ? radius * scale / distance
+                           : numeric_limits<float>::max();
+
+        for (const auto& texture : demand.textures) {
+            texture->RequestScreenSize(pixels);
+        }
+    }
+}
+
+void GraphicsManager::UpdateTerrainPages() {
+    if (!m_pTerrainVirtualTexture) return;
+
+    // the pages around the camera, as far as it sees
+    const auto& camPos = m_Frames[m_nFrameIndex].frameContext.camPos;
+    const float patch = SceneObjectTerrain::kPatchSize;
+    const float origin = SceneObjectTerrain::kGridOrigin;
+    m_pTerrainVirtualTexture->Feedback((camPos[0] - origin) / patch,
+                                       (camPos[1] - origin) / patch,
+                                       m_fViewDistance / patch);
+    m_pTerrainVirtualTexture->Update();
+}
+
 void GraphicsManager::CalculateLights() {
     DrawFrameContext& frameContext = m_Frames[m_nFrameIndex].frameContext;
     auto& light_info = m_Frames[m_nFrameIndex].lightInfo;
@@ -301,6 +408,40 @@ void GraphicsManager::CalculateLights() {
 }
 
 void GraphicsManager::BeginScene(const Scene& scene) {
+    RequestSceneTextures(scene);
+
+    m_TextureDemands.clear();
+    for (const auto& entry : scene.GeometryNodes) {
+        const auto pGeometryNode = entry.second.lock();
+        if (!pGeometryNode || !pGeometryNode->Visible()) continue;
+        const auto pGeometry =
+            scene.GetGeometry(pGeometryNode->GetSceneObjectRef());
+        if (!pGeometry) continue;
+        const auto pMesh = pGeometry->GetMesh().lock();
+        if (!pMesh) continue;
+
+        TextureDemand demand;
+        auto box = pMesh->GetBoundingBox();
+        demand.centroid = box.centroid;
+        demand.radius = sqrtf(box.extent[0] * box.extent[0] +
+                              box.extent[1] * box.extent[1] +
+                              box.extent[2] * box.extent[2]);
+
+        for (size_t i = 0; i < pMesh->GetIndexGroupCount(); i++) {
+            const auto material =
+                scene.GetMaterial(pGeometryNode->GetMaterialRef(
+                    pMesh->GetIndexArray(i).GetMaterialIndex()));
+            if (!material) continue;
+            for (auto& texture : GetMaterialTextures(*material)) {
+                demand.textures.push_back(std::move(texture));
+            }
+        }
+
+        if (!demand.textures.empty()) {
+            m_TextureDemands.emplace(pGeometryNode.get(), std::move(demand));
+        }
+    }
+
     // first, call init passes on frame 0
     for (const auto& pPass : m_InitPasses) {
         pPass->BeginPass();
@@ -345,6 +486,21 @@ void GraphicsManager::BeginScene(const Scene& scene) {
         initializeGeometries(scene);
     }
     if (scene.Terrain) {
+        // the grid as one texture, its pages loaded as the camera nears
+        m_pTerrainVirtualTexture = make_unique<VirtualTexture>(
+            SceneObjectTerrain::nMaxTerrainGridWidth,
+            SceneObjectTerrain::nMaxTerrainGridHeight);
+        // named as SceneObjectTerrain::SetName does, column by column
+        uint32_t index = 0;
+        for (uint32_t i = 0; i < SceneObjectTerrain::nMaxTerrainGridWidth;
+             i++) {
+            for (uint32_t j = 0; j < SceneObjectTerrain::nMaxTerrainGridHeight;
+                 j++) {
+                const auto& name = scene.Terrain->GetTexture(index++).GetName();
+                m_pTerrainVirtualTexture->SetPageName(i, j, name);
+            }
+        }
+
         initializeTerrain(scene);
     }
     if (scene.SkyBox) {
@@ -352,13 +508,26 @@ void GraphicsManager::BeginScene(const Scene& scene) {
     }
 }
 
-void GraphicsManager::EndScene() {}
+void GraphicsManager::EndScene() {
+    // the batches keep the geometry nodes, and with them the scene arena,
+    // alive. their storage came from the memory manager, which may be
+    // finalized next, so it is given back rather than kept for reuse.
+    for (auto& frame : m_Frames) {
+        decltype(frame.batchContexts)(frame.batchContexts.get_allocator())
+            .swap(frame.batchContexts);
+    }
+    m_TextureDemands.clear();
+    m_pTerrainVirtualTexture.reset();
+}
 
 void GraphicsManager::BeginFrame(const Frame& frame) {}
 
 void GraphicsManager::EndFrame(const Frame&) {
     m_nFrameIndex =
         ((m_nFrameIndex + 1) % GfxConfiguration::kMaxInFlightFrameCount);
+
+    // the arena was last used kMaxInFlightFrameCount frames ago
+    m_FrameAllocators[m_nFrameIndex].Rewind();
 }
 
 int32_t GraphicsManager::GetTexture(const char* id) {
@@ -13,6 +13,8 @@
 #include "Image.hpp"
 #include "Polyhedron.hpp"
 #include "Scene.hpp"
+#include "StackAllocator.hpp"
+#include "VirtualTexture.hpp"
 #include "cbuffer.h"
 #include "geommath.hpp"
 
@@ -133,6 +135,12 @@ class GraphicsManager : _implements_ IRuntimeModule {
     virtual void BeginCompute() {}
     virtual void EndCompute() {}
 
+    // scratch memory which lives until the same in-flight frame comes around
+    // again, so no per allocation bookkeeping is needed
+    StackAllocator& GetFrameAllocator() {
+        return m_FrameAllocators[m_nFrameIndex];
+    }
+
    protected:
     virtual void BeginScene(const Scene& scene);
     virtual void EndScene();
@@ -152,17 +160,39 @@ class GraphicsManager : _implements_ IRuntimeModule {
     void InitConstants() {}
     void CalculateCameraMatrix();
     void CalculateLights();
+    void CalculateTextureDemand();
+    void UpdateTerrainPages();
 
     void UpdateConstants();
 
+    // how far each geometry node reaches and the textures it is drawn
+    // with, gathered once a scene for the streaming of their mips
+    struct TextureDemand {
+        Vector3f centroid;
+        float radius{0.0f};
+        std::vector<std::shared_ptr<SceneObjectTexture>> textures;
+    };
+    std::unordered_map<const SceneGeometryNode*, TextureDemand>
+        m_TextureDemands;
+
+    // how far the camera sees, the terrain pages within it are kept
+    float m_fViewDistance{100.0f};
+
    protected:
     std::unordered_map<std::string, uint32_t> m_Textures;
 
+    // the height maps of the terrain grid as one texture, set up before
+    // initializeTerrain. the pages it filled are for the backends to
+    // upload.
+    std::unique_ptr<VirtualTexture> m_pTerrainVirtualTexture;
+
     uint64_t m_nSceneRevision{0};
 
     uint32_t m_nFrameIndex{0};
 
     std::array<Frame, GfxConfiguration::kMaxInFlightFrameCount> m_Frames;
+    std::array<StackAllocator, GfxConfiguration::kMaxInFlightFrameCount>
+        m_FrameAllocators;
     std::vector<std::shared_ptr<IDispatchPass>> m_InitPasses;
     std::vector<std::shared_ptr<IDispatchPass>> m_DispatchPasses;
     std::vector<std::shared_ptr<IDrawPass>> m_DrawPasses;
@@ -14,6 +14,7 @@ Image::Image(Image&& rhs) noexcept {
     is_float = rhs.is_float;
     compress_format = rhs.compress_format;
     mipmaps = std::move(rhs.mipmaps);
+    storage = std::move(rhs.storage);
     rhs.Width = 0;
     rhs.Height = 0;
     rhs.data = nullptr;
@@ -37,6 +38,7 @@ Image& Image::operator=(Image&& rhs) noexcept {
         is_float = rhs.is_float;
         compress_format = rhs.compress_format;
         mipmaps = std::move(rhs.mipmaps);
+        storage = std::move(rhs.storage);
         rhs.Width = 0;
         rhs.Height = 0;
         rhs.data = nullptr;
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <vector>
 
+#include "Buffer.hpp"
 #include "config.h"
 #include "geommath.hpp"
 
@@ -34,6 +35,9 @@ struct Image {
         }
     };
     std::vector<Mipmap> mipmaps;
+    // when set, data points into it (e.g. a view into the file buffer)
+    // and is released with it instead of by delete[]
+    Buffer storage;
 
     Image() = default;
     Image(const Image& rhs) = delete;  // disable copy contruct
@@ -41,7 +45,17 @@ struct Image {
     Image& operator=(const Image& rhs) = delete;  // disable copy assignment
     Image& operator=(Image&& rhs) noexcept;
     ~Image() {
-        if (data) delete[] data;
+        if (data && !storage.GetData()) delete[] data;
+    }
+
+    // releases the current pixels and adopts new_data allocated by new[]
+    void AdoptData(uint8_t* new_data) {
+        if (storage.GetData()) {
+            storage = Buffer();
+        } else {
+            delete[] data;
+        }
+        data = new_data;
     }
 };
 
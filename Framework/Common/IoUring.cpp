@@ -0,0 +1,181 @@
+#include "IoUring.hpp"
+
+#if defined(USE_IO_URING)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+using namespace My;
+using namespace std;
+
+// the syscalls are used directly, there is no liburing dependency
+static int io_uring_setup(uint32_t entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int io_uring_enter(int fd, uint32_t to_submit, uint32_t min_complete,
+                          uint32_t flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, to_submit,
+                                    min_complete, flags, nullptr, 0));
+}
+
+static void* MapRing(int fd, size_t size, off_t offset) {
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, offset);
+    return (p == MAP_FAILED) ? nullptr : p;
+}
+
+IoUring::IoUring(uint32_t entries) {
+    io_uring_params params;
+    memset(&params, 0x00, sizeof(params));
+
+    int fd = io_uring_setup(entries, &params);
+    if (fd < 0) {
+        return;
+    }
+
+    m_szSqRing = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    m_szCqRing =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    m_szSqes = params.sq_entries * sizeof(io_uring_sqe);
+
+    // newer kernels share one mapping between both rings
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        m_szSqRing = m_szCqRing = max(m_szSqRing, m_szCqRing);
+    }
+
+    m_pSqRing = MapRing(fd, m_szSqRing, IORING_OFF_SQ_RING);
+    m_pCqRing =
+        single_mmap ? m_pSqRing : MapRing(fd, m_szCqRing, IORING_OFF_CQ_RING);
+    m_pSqes = MapRing(fd, m_szSqes, IORING_OFF_SQES);
+
+    m_nFd = fd;
+
+    if (!m_pSqRing || !m_pCqRing || !m_pSqes) {
+        Release();
+        return;
+    }
+
+    auto* sq = static_cast<uint8_t*>(m_pSqRing);
+    m_pSqTail = reinterpret_cast<uint32_t*>(sq + params.sq_off.tail);
+    m_pSqMask = reinterpret_cast<uint32_t*>(sq + params.sq_off.ring_mask);
+    m_pSqArray = reinterpret_cast<uint32_t*>(sq + params.sq_off.array);
+
+    auto* cq = static_cast<uint8_t*>(m_pCqRing);
+    m_pCqHead = reinterpret_cast<uint32_t*>(cq + params.cq_off.head);
+    m_pCqTail = reinterpret_cast<uint32_t*>(cq + params.cq_off.tail);
+    m_pCqMask = reinterpret_cast<uint32_t*>(cq + params.cq_off.ring_mask);
+    m_pCqes = cq + params.cq_off.cqes;
+
+    m_nEntries = params.sq_entries;
+    m_Iovecs.resize(m_nEntries);
+}
+
+IoUring::~IoUring() { Release(); }
+
+void IoUring::Release() {
+    if (m_pSqes) munmap(m_pSqes, m_szSqes);
+    if (m_pCqRing && m_pCqRing != m_pSqRing) munmap(m_pCqRing, m_szCqRing);
+    if (m_pSqRing) munmap(m_pSqRing, m_szSqRing);
+    if (m_nFd >= 0) close(m_nFd);
+
+    m_pSqes = m_pCqRing = m_pSqRing = nullptr;
+    m_nFd = -1;
+}
+
+void IoUring::Queue(vector<Read>& reads, size_t index) {
+    Read& read = reads[index];
+
+    uint32_t tail = *m_pSqTail;
+    uint32_t slot = tail & *m_pSqMask;
+
+    m_Iovecs[slot].iov_base = read.data + read.done;
+    m_Iovecs[slot].iov_len = read.size - read.done;
+
+    // READV is available since the first io_uring kernels, READ is not
+    auto* sqe = static_cast<io_uring_sqe*>(m_pSqes) + slot;
+    memset(sqe, 0x00, sizeof(io_uring_sqe));
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = read.fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&m_Iovecs[slot]);
+    sqe->len = 1;
+    sqe->off = read.done;
+    sqe->user_data = index;
+
+    m_pSqArray[slot] = slot;
+
+    // the kernel must see the entry before the tail moves past it
+    __atomic_store_n(m_pSqTail, tail + 1, __ATOMIC_RELEASE);
+    m_nQueued++;
+}
+
+void IoUring::SubmitAndWait(vector<Read>& reads, uint32_t count) {
+    uint32_t completed = 0;
+
+    while (completed < count) {
+        int ret = io_uring_enter(m_nFd, m_nQueued, count - completed,
+                                 IORING_ENTER_GETEVENTS);
+        if (ret < 0) {
+            if (errno == EINTR) continue;
+
+            // the ring is unusable, fail what is still outstanding
+            for (auto& read : reads) {
+                if (!read.error && read.done < read.size) read.error = errno;
+            }
+            m_nQueued = 0;
+            return;
+        }
+        m_nQueued -= min<uint32_t>(m_nQueued, ret);
+
+        uint32_t head = *m_pCqHead;
+        uint32_t tail = __atomic_load_n(m_pCqTail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            auto& cqe =
+                static_cast<io_uring_cqe*>(m_pCqes)[head & *m_pCqMask];
+            Read& read = reads[cqe.user_data];
+            if (cqe.res < 0) {
+                read.error = -cqe.res;
+            } else if (cqe.res == 0) {
+                // the file shrank since its size was taken
+                read.error = EIO;
+            } else {
+                read.done += cqe.res;
+            }
+            head++;
+            completed++;
+        }
+        __atomic_store_n(m_pCqHead, head, __ATOMIC_RELEASE);
+    }
+}
+
+void IoUring::ReadAll(vector<Read>& reads) {
+    while (true) {
+        uint32_t count = 0;
+        for (size_t i = 0; i < reads.size(); i++) {
+            if (reads[i].error || reads[i].done >= reads[i].size) continue;
+
+            Queue(reads, i);
+            if (++count == m_nEntries) {
+                SubmitAndWait(reads, count);
+                count = 0;
+            }
+        }
+
+        if (count) {
+            SubmitAndWait(reads, count);
+        }
+
+        // short reads are left with done < size, go around again
+        bool pending = any_of(reads.begin(), reads.end(), [](const Read& r) {
+            return !r.error && r.done < r.size;
+        });
+        if (!pending) break;
+    }
+}
+#endif  // defined(USE_IO_URING)
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "config.h"
+
+#if defined(USE_IO_URING)
+#include <sys/uio.h>
+
+namespace My {
+// a Linux io_uring used to read many files with a single submission.
+// the ring is not thread safe, each thread reading through it owns one.
+class IoUring {
+   public:
+    struct Read {
+        int fd;
+        uint8_t* data;
+        size_t size;
+        // bytes read so far
+        size_t done{0};
+        // errno of the failed read, 0 on success
+        int error{0};
+    };
+
+    explicit IoUring(uint32_t entries);
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // false when the kernel does not provide io_uring, or forbids it
+    [[nodiscard]] bool IsValid() const { return m_nFd >= 0; }
+
+    // reads every file from offset 0 into its buffer, submitting up to
+    // the ring size at once. short reads are resubmitted for the rest.
+    void ReadAll(std::vector<Read>& reads);
+
+   private:
+    void Release();
+    // queues a read of what is left of reads[index]
+    void Queue(std::vector<Read>& reads, size_t index);
+    // submits the queued reads and waits for count completions
+    void SubmitAndWait(std::vector<Read>& reads, uint32_t count);
+
+    int m_nFd{-1};
+    uint32_t m_nEntries{0};
+
+    void* m_pSqRing{nullptr};
+    size_t m_szSqRing{0};
+    void* m_pCqRing{nullptr};
+    size_t m_szCqRing{0};
+    void* m_pSqes{nullptr};
+    size_t m_szSqes{0};
+
+    uint32_t* m_pSqTail{nullptr};
+    uint32_t* m_pSqMask{nullptr};
+    uint32_t* m_pSqArray{nullptr};
+    uint32_t* m_pCqHead{nullptr};
+    uint32_t* m_pCqTail{nullptr};
+    uint32_t* m_pCqMask{nullptr};
+    void* m_pCqes{nullptr};
+
+    uint32_t m_nQueued{0};
+    // one iovec per submission slot
+    std::vector<iovec> m_Iovecs;
+};
+}  // namespace My
+#endif  // defined(USE_IO_URING)
@@ -1,13 +1,134 @@
 #include "MemoryManager.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <cstdlib>
 #include <iostream>
 
+#if defined(OS_WINDOWS)
+#include <malloc.h>
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#define MYGE_VIRTUAL_MEMORY 1
+#elif defined(OS_LINUX) || defined(OS_ANDROID) || defined(OS_BSD) || \
+    defined(OS_MACOS)
+#include <sys/mman.h>
+#include <unistd.h>
+#define MYGE_VIRTUAL_MEMORY 1
+#endif
+
 using namespace My;
 using namespace std;
 
 namespace My {
+static const uint32_t kBlockSizes[] = {
+    // 8-increments
+    8, 16, 24, 32, 40, 48, 56, 64,
+
+    // 16-increments
+    80, 96, 112, 128,
+
+    // 32-increments
+    160, 192, 224, 256,
+
+    // 64-increments
+    320, 384, 448, 512,
+
+    // 128-increments
+    640, 768, 896, 1024,
+
+    // 256-increments
+    1280, 1536, 1792, 2048,
+
+    // 512-increments
+    2560, 3072, 3584, 4096};
+
+static const uint32_t kPageSize = 32768;
+static const uint32_t kAlignment = 8;
+
+// number of elements in the block size array
+static const uint32_t kNumBlockSizes =
+    sizeof(kBlockSizes) / sizeof(kBlockSizes[0]);
+
+// largest valid block size, anything bigger goes to malloc directly
+static const uint32_t kMaxBlockSize = kBlockSizes[kNumBlockSizes - 1];
+
+// virtual address space reserved for pages. only 64-bit targets have
+// room for it, 32-bit targets allocate pages from the heap.
+static const size_t kReservedAddressSpace =
+    (sizeof(void*) == 8) ? (size_t(32) << 30) : 0;
+
+// the reservation starts on a huge page boundary
+static const size_t kHugePageSize = size_t(2) << 20;
+
+// granularity of commit and decommit
+static const size_t kSystemPageSize = 4096;
+
+#if defined(MYGE_VIRTUAL_MEMORY)
+// reserved ranges come in power of 2 sizes from one system page up, so a
+// freed range serves any later request of the same bucket
+static size_t ReservedRangeSize(size_t size) {
+    size_t range_size = kSystemPageSize;
+    while (range_size < size) range_size <<= 1;
+    return range_size;
+}
+#endif
+
+// sampling seconds between two trims of the size class caches
+static const uint32_t kTrimInterval = 10;
+
+#if defined(MYGE_VIRTUAL_MEMORY)
+#if defined(OS_WINDOWS)
+static uint8_t* ReserveAddressSpace(size_t size) {
+    return static_cast<uint8_t*>(
+        VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS));
+}
+
+static void ReleaseAddressSpace(uint8_t* p, size_t) {
+    VirtualFree(p, 0, MEM_RELEASE);
+}
+
+static bool CommitRange(uint8_t* p, size_t size) {
+    return VirtualAlloc(p, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+}
+
+static void DecommitRange(uint8_t* p, size_t size) {
+    VirtualFree(p, size, MEM_DECOMMIT);
+}
+#else
+// the range is mapped read-write without swap reservation, the kernel
+// commits physical pages on first touch. protecting every free page
+// with PROT_NONE would split the mapping into one VMA per page.
+static uint8_t* ReserveAddressSpace(size_t size) {
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_NORESERVE)
+    flags |= MAP_NORESERVE;
+#endif
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (p == MAP_FAILED) return nullptr;
+
+#if defined(MADV_HUGEPAGE)
+    // ask for transparent huge pages, it is only a hint
+    madvise(p, size, MADV_HUGEPAGE);
+#endif
+
+    return static_cast<uint8_t*>(p);
+}
+
+static void ReleaseAddressSpace(uint8_t* p, size_t size) { munmap(p, size); }
+
+static bool CommitRange(uint8_t*, size_t) { return true; }
+
+static void DecommitRange(uint8_t* p, size_t size) {
+    // the range reads back as zeros and no longer counts towards RSS
+    madvise(p, size, MADV_DONTNEED);
+}
+#endif
+#endif
+
 std::ostream& operator<<(std::ostream& out, MemoryType type) {
     auto n = static_cast<int32_t>(type);
     n = endian_net_unsigned_int<int32_t>(n);
@@ -19,42 +140,315 @@ std::ostream& operator<<(std::ostream& out, MemoryType type) {
 
     return out;
 }
+
+std::ostream& operator<<(std::ostream& out, MemoryTag tag) {
+    static const char* names[] = {"General", "Scene",  "Texture",
+                                  "Mesh",    "Physics", "Parser",
+                                  "Debug",   "Frame",  "SmallObjectPool"};
+    static_assert(sizeof(names) / sizeof(names[0]) ==
+                      static_cast<size_t>(MemoryTag::kCount),
+                  "missing memory tag name");
+
+    auto index = static_cast<size_t>(tag);
+    if (index < static_cast<size_t>(MemoryTag::kCount)) {
+        out << names[index];
+    } else {
+        out << "Unknown";
+    }
+
+    return out;
+}
 }  // namespace My
 
-int MemoryManager::Initialize() { return 0; }
+int MemoryManager::Initialize() {
+    if (!m_pAllocators) {
+        // initialize block size lookup table
+        m_pBlockSizeLookup = new uint8_t[kMaxBlockSize + 1];
+        size_t j = 0;
+        for (size_t i = 0; i <= kMaxBlockSize; i++) {
+            if (i > kBlockSizes[j]) ++j;
+            m_pBlockSizeLookup[i] = static_cast<uint8_t>(j);
+        }
+
+        // initialize the allocators
+        m_pAllocators = new BlockAllocator[kNumBlockSizes];
+        for (size_t i = 0; i < kNumBlockSizes; i++) {
+            m_pAllocators[i].Reset(kBlockSizes[i], kPageSize, kAlignment,
+                                   MemoryTag::kSmallObjectPool);
+        }
+    }
+
+#if defined(MYGE_VIRTUAL_MEMORY)
+    if (!m_pReservedBase && kReservedAddressSpace) {
+        m_pReservedBase = ReserveAddressSpace(kReservedAddressSpace);
+        if (m_pReservedBase) {
+            m_szReserved = kReservedAddressSpace;
+            auto base = reinterpret_cast<uintptr_t>(m_pReservedBase);
+            m_szReservedTop = ALIGN(base, kHugePageSize) - base;
+        } else {
+            cerr << "[MemoryManager] could not reserve address space, "
+                    "falling back to heap pages"
+                 << endl;
+        }
+    }
+#endif
+
+    m_LastSampleTime = chrono::steady_clock::now();
+
+    return 0;
+}
+
+void MemoryManager::Finalize() {
+    // the allocators return their pages through FreePage
+    delete[] m_pAllocators;
+    m_pAllocators = nullptr;
+    delete[] m_pBlockSizeLookup;
+    m_pBlockSizeLookup = nullptr;
 
-void MemoryManager::Finalize() { assert(m_mapMemoryAllocationInfo.empty()); }
+    assert(m_mapMemoryAllocationInfo.empty());
+
+#if defined(MYGE_VIRTUAL_MEMORY)
+    if (m_pReservedBase) {
+        ReleaseAddressSpace(m_pReservedBase, m_szReserved);
+        m_pReservedBase = nullptr;
+        m_szReserved = 0;
+        m_szReservedTop = 0;
+        m_mapFreeRanges.clear();
+    }
+#endif
+}
 
 void MemoryManager::Tick() {
-#if DEBUG
-    static int count = 0;
+    auto now = chrono::steady_clock::now();
+    chrono::duration<float> elapsed = now - m_LastSampleTime;
+    bool sample = elapsed.count() >= 1.0f;
+    if (sample) {
+        m_LastSampleTime = now;
 
-    if (count++ == 3600) {
-        for (auto info : m_mapMemoryAllocationInfo) {
-            cerr << info.first << '\t';
-            cerr << info.second.PageMemoryType;
-            cerr << info.second.PageSize;
+        if (++m_nSamplesSinceTrim >= kTrimInterval) {
+            m_nSamplesSinceTrim = 0;
+            Trim();
         }
     }
+
+    for (size_t i = 0; i < m_TagCounters.size(); i++) {
+        auto& counters = m_TagCounters[i];
+
+        if (sample) {
+            size_t count = counters.allocationCount.load(memory_order_relaxed);
+            counters.allocationRate =
+                static_cast<float>(count - counters.lastAllocationCount) /
+                elapsed.count();
+            counters.lastAllocationCount = count;
+        }
+
+        if (counters.budget) {
+            size_t in_use = counters.inUse.load(memory_order_relaxed);
+            bool over_budget = in_use > counters.budget;
+            if (over_budget && !counters.overBudget) {
+                cerr << "[MemoryManager] " << static_cast<MemoryTag>(i)
+                     << " is over budget: " << in_use << " / "
+                     << counters.budget << " bytes" << endl;
+            }
+            counters.overBudget = over_budget;
+        }
+    }
+}
+
+MemoryStatistics MemoryManager::GetStatistics(MemoryTag tag) const {
+    const auto& counters = m_TagCounters[static_cast<size_t>(tag)];
+
+    MemoryStatistics statistics;
+    statistics.inUse = counters.inUse.load(memory_order_relaxed);
+    statistics.peak = counters.peak.load(memory_order_relaxed);
+    statistics.allocationCount =
+        counters.allocationCount.load(memory_order_relaxed);
+    statistics.allocationRate = counters.allocationRate;
+    statistics.budget = counters.budget;
+
+    return statistics;
+}
+
+void MemoryManager::SetBudget(MemoryTag tag, size_t bytes) {
+    auto& counters = m_TagCounters[static_cast<size_t>(tag)];
+    counters.budget = bytes;
+    counters.overBudget = false;
+}
+
+void MemoryManager::TrackAllocation(MemoryTag tag, size_t size) {
+    auto& counters = m_TagCounters[static_cast<size_t>(tag)];
+
+    size_t in_use =
+        counters.inUse.fetch_add(size, memory_order_relaxed) + size;
+    counters.allocationCount.fetch_add(1, memory_order_relaxed);
+
+    size_t peak = counters.peak.load(memory_order_relaxed);
+    while (in_use > peak && !counters.peak.compare_exchange_weak(
+                                peak, in_use, memory_order_relaxed)) {
+    }
+}
+
+void MemoryManager::TrackFree(MemoryTag tag, size_t size) {
+    m_TagCounters[static_cast<size_t>(tag)].inUse.fetch_sub(
+        size, memory_order_relaxed);
+}
+
+uint8_t* MemoryManager::AllocateReservedPage(size_t size, size_t alignment) {
+#if defined(MYGE_VIRTUAL_MEMORY)
+    if (!m_pReservedBase) return nullptr;
+
+    size_t range_size = ReservedRangeSize(size);
+    // a page is never aligned to more than its own size
+    assert(alignment <= range_size);
+    (void)alignment;
+
+    uint8_t* p = nullptr;
+    auto it = m_mapFreeRanges.find(range_size);
+    if (it != m_mapFreeRanges.end() && !it->second.empty()) {
+        p = it->second.back();
+        it->second.pop_back();
+    } else {
+        // every range is aligned to its size, which satisfies any page
+        // later put in it
+        auto base = reinterpret_cast<uintptr_t>(m_pReservedBase);
+        size_t offset = ALIGN(base + m_szReservedTop, range_size) - base;
+        if (offset + range_size > m_szReserved) return nullptr;
+
+        p = m_pReservedBase + offset;
+        m_szReservedTop = offset + range_size;
+    }
+
+    if (!CommitRange(p, range_size)) {
+        m_mapFreeRanges[range_size].push_back(p);
+        return nullptr;
+    }
+
+    return p;
+#else
+    return nullptr;
 #endif
 }
 
-void* MemoryManager::AllocatePage(size_t size) {
+bool MemoryManager::FreeReservedPage(void* p, size_t size) {
+#if defined(MYGE_VIRTUAL_MEMORY)
+    auto* _p = static_cast<uint8_t*>(p);
+    if (_p < m_pReservedBase || _p >= m_pReservedBase + m_szReserved) {
+        return false;
+    }
+
+    size_t range_size = ReservedRangeSize(size);
+    DecommitRange(_p, range_size);
+    m_mapFreeRanges[range_size].push_back(_p);
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+size_t MemoryManager::Trim() {
+    size_t released = 0;
+
+    if (m_pAllocators) {
+        for (size_t i = 0; i < kNumBlockSizes; i++) {
+            released += m_pAllocators[i].Trim();
+        }
+    }
+
+    return released;
+}
+
+BlockAllocator* MemoryManager::LookUpAllocator(size_t size) {
+    assert(m_pAllocators);
+
+    if (size <= kMaxBlockSize) {
+        return m_pAllocators + m_pBlockSizeLookup[size];
+    }
+
+    return nullptr;
+}
+
+void* MemoryManager::Allocate(size_t size, MemoryTag tag) {
+    TrackAllocation(tag, size);
+
+    BlockAllocator* pAlloc = LookUpAllocator(size);
+    if (pAlloc) {
+        return pAlloc->Allocate();
+    }
+
+    return malloc(size);
+}
+
+void MemoryManager::Free(void* p, size_t size, MemoryTag tag) {
+    if (!p) return;
+
+    TrackFree(tag, size);
+
+    BlockAllocator* pAlloc = LookUpAllocator(size);
+    if (pAlloc) {
+        pAlloc->Free(p);
+    } else {
+        free(p);
+    }
+}
+
+void* MemoryManager::AllocatePage(size_t size, MemoryTag tag) {
     uint8_t* p;
 
-    p = static_cast<uint8_t*>(malloc(size));
-    if (p) {
-        MemoryAllocationInfo info = {size, MemoryType::CPU};
-        m_mapMemoryAllocationInfo.insert({p, info});
+    // power of 2 sized pages are aligned to their size, so allocators can
+    // locate the page header from any address inside the page
+    size_t alignment =
+        ((size & (size - 1)) == 0) ? size : alignof(std::max_align_t);
+    alignment = std::max(alignment, sizeof(void*));
+
+    {
+        lock_guard<mutex> lock(m_Mutex);
+        p = AllocateReservedPage(size, alignment);
+        if (p) {
+            m_mapMemoryAllocationInfo.insert(
+                {p, MemoryAllocationInfo{size, MemoryType::CPU, tag}});
+        }
+    }
+
+    if (!p) {
+        // no reservation, or it is exhausted
+#if defined(OS_WINDOWS)
+        p = static_cast<uint8_t*>(_aligned_malloc(size, alignment));
+#else
+        void* _p = nullptr;
+        p = (posix_memalign(&_p, alignment, size) == 0)
+                ? static_cast<uint8_t*>(_p)
+                : nullptr;
+#endif
+        if (!p) return nullptr;
+
+        lock_guard<mutex> lock(m_Mutex);
+        m_mapMemoryAllocationInfo.insert(
+            {p, MemoryAllocationInfo{size, MemoryType::CPU, tag}});
     }
 
+    TrackAllocation(tag, size);
+
     return static_cast<void*>(p);
 }
 
 void MemoryManager::FreePage(void* p) {
-    auto it = m_mapMemoryAllocationInfo.find(p);
-    if (it != m_mapMemoryAllocationInfo.end()) {
+    {
+        lock_guard<mutex> lock(m_Mutex);
+        auto it = m_mapMemoryAllocationInfo.find(p);
+        if (it == m_mapMemoryAllocationInfo.end()) {
+            return;
+        }
+        TrackFree(it->second.PageMemoryTag, it->second.PageSize);
+        size_t size = it->second.PageSize;
         m_mapMemoryAllocationInfo.erase(it);
-        free(p);
+
+        if (FreeReservedPage(p, size)) return;
     }
+
+#if defined(OS_WINDOWS)
+    _aligned_free(p);
+#else
+    free(p);
+#endif
 }
@@ -1,8 +1,14 @@
 #pragma once
-#include <map>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <new>
 #include <ostream>
+#include <unordered_map>
+#include <vector>
 
+#include "BlockAllocator.hpp"
 #include "IMemoryManager.hpp"
 #include "portable.hpp"
 
@@ -18,15 +24,82 @@ class MemoryManager : _implements_ IMemoryManager {
     void Finalize() override;
     void Tick() override;
 
-    void* AllocatePage(size_t size) override;
+    void* AllocatePage(size_t size,
+                       MemoryTag tag = MemoryTag::kGeneral) override;
     void FreePage(void* p) override;
 
+    void* Allocate(size_t size, MemoryTag tag = MemoryTag::kGeneral) override;
+    void Free(void* p, size_t size,
+              MemoryTag tag = MemoryTag::kGeneral) override;
+
+    [[nodiscard]] MemoryStatistics GetStatistics(MemoryTag tag) const override;
+    void SetBudget(MemoryTag tag, size_t bytes) override;
+
+    // hands the pages of the calling thread which hold no live small
+    // object back to the system, returns the number of pages released
+    size_t Trim();
+
+    // pages come from the reserved range, freed pages are decommitted and
+    // their range handed out again. false if nothing could be reserved.
+    [[nodiscard]] bool HasReservedAddressSpace() const {
+        return m_pReservedBase != nullptr;
+    }
+
    protected:
     struct MemoryAllocationInfo {
         size_t PageSize;
         MemoryType PageMemoryType;
+        MemoryTag PageMemoryTag;
+    };
+
+    std::unordered_map<void*, MemoryAllocationInfo> m_mapMemoryAllocationInfo;
+    // pages are requested by block allocators from any thread
+    std::mutex m_Mutex;
+
+   private:
+    // updated from any thread, each tag on its own cache line
+    struct alignas(64) TagCounters {
+        std::atomic<size_t> inUse{0};
+        std::atomic<size_t> peak{0};
+        std::atomic<size_t> allocationCount{0};
+
+        // only touched by Tick and SetBudget
+        size_t lastAllocationCount{0};
+        float allocationRate{0.0f};
+        size_t budget{0};
+        bool overBudget{false};
     };
 
-    std::map<void*, MemoryAllocationInfo> m_mapMemoryAllocationInfo;
+    std::array<TagCounters, static_cast<size_t>(MemoryTag::kCount)>
+        m_TagCounters;
+    std::chrono::steady_clock::time_point m_LastSampleTime;
+
+    void TrackAllocation(MemoryTag tag, size_t size);
+    void TrackFree(MemoryTag tag, size_t size);
+
+    // size class index for every request size up to the largest block
+    uint8_t* m_pBlockSizeLookup{nullptr};
+    // one block allocator per size class
+    BlockAllocator* m_pAllocators{nullptr};
+
+    BlockAllocator* LookUpAllocator(size_t size);
+
+    // pages are carved out of a virtual address range reserved at
+    // Initialize. physical memory is committed when a page is handed out
+    // and decommitted when it comes back, the address range is kept and
+    // reused for the next page of the same power of 2 bucket. both must be
+    // called with m_Mutex held.
+    uint8_t* AllocateReservedPage(size_t size, size_t alignment);
+    bool FreeReservedPage(void* p, size_t size);
+
+    uint8_t* m_pReservedBase{nullptr};
+    size_t m_szReserved{0};
+    // offset of the first byte never handed out
+    size_t m_szReservedTop{0};
+    // decommitted ranges by bucket size
+    std::unordered_map<size_t, std::vector<uint8_t*>> m_mapFreeRanges;
+
+    // samples since the size class caches were last trimmed
+    uint32_t m_nSamplesSinceTrim{0};
 };
 }  // namespace My
@@ -0,0 +1,97 @@
+#include "MemoryResource.hpp"
+
+#include <array>
+#include <cassert>
+
+using namespace My;
+using namespace std;
+
+// blocks of the memory manager size classes are aligned to this
+static const size_t kSizeClassAlignment = 8;
+
+void* BlockMemoryResource::do_allocate(size_t bytes,
+                                       [[maybe_unused]] size_t alignment) {
+    assert(bytes <= m_Allocator.GetBlockSize());
+    // blocks are not aligned any further than the size classes are
+    assert(alignment <= kSizeClassAlignment);
+    return m_Allocator.Allocate(bytes);
+}
+
+void BlockMemoryResource::do_deallocate(void* p, size_t, size_t) {
+    m_Allocator.Free(p);
+}
+
+bool BlockMemoryResource::do_is_equal(
+    const pmr::memory_resource& other) const noexcept {
+    const auto* _other = dynamic_cast<const BlockMemoryResource*>(&other);
+    return _other && &_other->m_Allocator == &m_Allocator;
+}
+
+void* StackMemoryResource::do_allocate(size_t bytes, size_t alignment) {
+    return m_Allocator.Allocate(bytes, alignment);
+}
+
+void StackMemoryResource::do_deallocate(void*, size_t, size_t) {}
+
+bool StackMemoryResource::do_is_equal(
+    const pmr::memory_resource& other) const noexcept {
+    const auto* _other = dynamic_cast<const StackMemoryResource*>(&other);
+    return _other && &_other->m_Allocator == &m_Allocator;
+}
+
+ArenaMemoryResource::ArenaMemoryResource(MemoryTag tag, size_t page_size)
+    : m_Allocator(page_size, alignof(max_align_t), tag) {}
+
+void* ArenaMemoryResource::do_allocate(size_t bytes, size_t alignment) {
+    return m_Allocator.Allocate(bytes, alignment);
+}
+
+void ArenaMemoryResource::do_deallocate(void*, size_t, size_t) {}
+
+bool ArenaMemoryResource::do_is_equal(
+    const pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+void* TaggedMemoryResource::do_allocate(size_t bytes, size_t alignment) {
+    if (alignment > kSizeClassAlignment) {
+        // the size classes do not guarantee more than that
+        return pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    return g_pMemoryManager->Allocate(bytes, m_Tag);
+}
+
+void TaggedMemoryResource::do_deallocate(void* p, size_t bytes,
+                                         size_t alignment) {
+    if (alignment > kSizeClassAlignment) {
+        pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        return;
+    }
+
+    g_pMemoryManager->Free(p, bytes, m_Tag);
+}
+
+bool TaggedMemoryResource::do_is_equal(
+    const pmr::memory_resource& other) const noexcept {
+    const auto* _other = dynamic_cast<const TaggedMemoryResource*>(&other);
+    return _other && _other->m_Tag == m_Tag;
+}
+
+namespace My {
+pmr::memory_resource* GetMemoryResource(MemoryTag tag) {
+    static array<TaggedMemoryResource, static_cast<size_t>(MemoryTag::kCount)>
+        resources = {
+            TaggedMemoryResource(MemoryTag::kGeneral),
+            TaggedMemoryResource(MemoryTag::kScene),
+            TaggedMemoryResource(MemoryTag::kTexture),
+            TaggedMemoryResource(MemoryTag::kMesh),
+            TaggedMemoryResource(MemoryTag::kPhysics),
+            TaggedMemoryResource(MemoryTag::kParser),
+            TaggedMemoryResource(MemoryTag::kDebug),
+            TaggedMemoryResource(MemoryTag::kFrame),
+            TaggedMemoryResource(MemoryTag::kSmallObjectPool)};
+
+    return &resources[static_cast<size_t>(tag)];
+}
+}  // namespace My
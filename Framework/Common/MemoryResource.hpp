@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+
+#include "BlockAllocator.hpp"
+#include "IMemoryManager.hpp"
+#include "StackAllocator.hpp"
+
+namespace My {
+// std::pmr adapters, so standard containers can draw their storage from
+// the engine allocators
+
+// hands out single blocks, every request must fit into one block
+class BlockMemoryResource : public std::pmr::memory_resource {
+   public:
+    explicit BlockMemoryResource(BlockAllocator& allocator)
+        : m_Allocator(allocator) {}
+
+   protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    [[nodiscard]] bool do_is_equal(
+        const std::pmr::memory_resource& other) const noexcept override;
+
+   private:
+    BlockAllocator& m_Allocator;
+};
+
+// bumps through a stack allocator. deallocation is a no-op, the memory
+// comes back when the allocator is rewound or freed.
+class StackMemoryResource : public std::pmr::memory_resource {
+   public:
+    explicit StackMemoryResource(StackAllocator& allocator)
+        : m_Allocator(allocator) {}
+
+   protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    [[nodiscard]] bool do_is_equal(
+        const std::pmr::memory_resource& other) const noexcept override;
+
+   private:
+    StackAllocator& m_Allocator;
+};
+
+// a stack allocator of its own, all pages are returned at once when the
+// arena is destroyed. containers living in the arena skip the per
+// element deallocation.
+class ArenaMemoryResource : public std::pmr::memory_resource {
+   public:
+    explicit ArenaMemoryResource(MemoryTag tag = MemoryTag::kGeneral,
+                                 size_t page_size = 64 * 1024);
+
+    [[nodiscard]] size_t GetAllocatedSize() const {
+        return m_Allocator.GetAllocatedSize();
+    }
+
+   protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    [[nodiscard]] bool do_is_equal(
+        const std::pmr::memory_resource& other) const noexcept override;
+
+   private:
+    StackAllocator m_Allocator;
+};
+
+// the size classes of the memory manager, accounted to a tag
+class TaggedMemoryResource : public std::pmr::memory_resource {
+   public:
+    explicit TaggedMemoryResource(MemoryTag tag) : m_Tag(tag) {}
+
+   protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    [[nodiscard]] bool do_is_equal(
+        const std::pmr::memory_resource& other) const noexcept override;
+
+   private:
+    MemoryTag m_Tag;
+};
+
+// shared tagged resource, valid while g_pMemoryManager is initialized
+std::pmr::memory_resource* GetMemoryResource(MemoryTag tag);
+}  // namespace My
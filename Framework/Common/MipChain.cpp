@@ -0,0 +1,319 @@
+#include "MipChain.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "Float4.hpp"
+#include "WorkerPool.hpp"
+
+using namespace My;
+using namespace std;
+
+namespace {
+enum class Format { kR8, kRGBA8, kSRGBA8, kRGBA16, kRGBA32F };
+
+// 8 bit values to linear floats, sRGB decoded or not
+struct DecodeTables {
+    float linear[256];
+    float srgb[256];
+};
+
+const DecodeTables& GetDecodeTables() {
+    static const DecodeTables s_Tables = []() {
+        DecodeTables tables;
+        for (int32_t i = 0; i < 256; i++) {
+            float c = i / 255.0f;
+            tables.linear[i] = c;
+            tables.srgb[i] = (c <= 0.04045f)
+                                 ? c / 12.92f
+                                 : powf((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return tables;
+    }();
+    return s_Tables;
+}
+
+// linear values quantized to 12 bits to sRGB encoded bytes, fine enough
+// that no 8 bit value is lost
+const size_t kEncodeSteps = 4096;
+
+const uint8_t* GetEncodeTable() {
+    static const auto s_Table = []() {
+        vector<uint8_t> table(kEncodeSteps);
+        for (size_t i = 0; i < kEncodeSteps; i++) {
+            float c = i / float(kEncodeSteps - 1);
+            float s = (c <= 0.0031308f)
+                          ? c * 12.92f
+                          : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+            table[i] = static_cast<uint8_t>(s * 255.0f + 0.5f);
+        }
+        return table;
+    }();
+    return s_Table.data();
+}
+
+// single channel pixels are filtered as RGBA too, with the others empty
+void DecodeRow(Format format, const uint8_t* src, float* dst, size_t width) {
+    switch (format) {
+        case Format::kR8: {
+            const float* linear = GetDecodeTables().linear;
+            for (size_t i = 0; i < width; i++) {
+                dst[4 * i] = linear[src[i]];
+                dst[4 * i + 1] = 0.0f;
+                dst[4 * i + 2] = 0.0f;
+                dst[4 * i + 3] = 1.0f;
+            }
+        } break;
+        case Format::kRGBA8:
+        case Format::kSRGBA8: {
+            const auto& tables = GetDecodeTables();
+            const float* color =
+                (format == Format::kSRGBA8) ? tables.srgb : tables.linear;
+            for (size_t i = 0; i < width; i++) {
+                dst[4 * i] = color[src[4 * i]];
+                dst[4 * i + 1] = color[src[4 * i + 1]];
+                dst[4 * i + 2] = color[src[4 * i + 2]];
+                dst[4 * i + 3] = tables.linear[src[4 * i + 3]];
+            }
+        } break;
+        case Format::kRGBA16: {
+            const auto* src16 = reinterpret_cast<const uint16_t*>(src);
+            for (size_t i = 0; i < 4 * width; i++) {
+                dst[i] = src16[i] * (1.0f / 65535.0f);
+            }
+        } break;
+        case Format::kRGBA32F:
+            memcpy(dst, src, 4 * width * sizeof(float));
+            break;
+    }
+}
+
+// src is already clamped to what the format holds
+void EncodeRow(Format format, const float* src, uint8_t* dst, size_t width) {
+    switch (format) {
+        case Format::kR8:
+            for (size_t i = 0; i < width; i++) {
+                dst[i] = static_cast<uint8_t>(src[4 * i] * 255.0f + 0.5f);
+            }
+            break;
+        case Format::kRGBA8:
+            for (size_t i = 0; i < 4 * width; i++) {
+                dst[i] = static_cast<uint8_t>(src[i] * 255.0f + 0.5f);
+            }
+            break;
+        case Format::kSRGBA8: {
+            const uint8_t* encode = GetEncodeTable();
+            const float steps = float(kEncodeSteps - 1);
+            for (size_t i = 0; i < width; i++) {
+                for (size_t c = 0; c < 3; c++) {
+                    dst[4 * i + c] = encode[static_cast<size_t>(
+                        src[4 * i + c] * steps + 0.5f)];
+                }
+                dst[4 * i + 3] =
+                    static_cast<uint8_t>(src[4 * i + 3] * 255.0f + 0.5f);
+            }
+        } break;
+        case Format::kRGBA16: {
+            auto* dst16 = reinterpret_cast<uint16_t*>(dst);
+            for (size_t i = 0; i < 4 * width; i++) {
+                dst16[i] = static_cast<uint16_t>(src[i] * 65535.0f + 0.5f);
+            }
+        } break;
+        case Format::kRGBA32F:
+            memcpy(dst, src, 4 * width * sizeof(float));
+            break;
+    }
+}
+
+// a 2:1 kernel, output pixel x is weighted from source pixels 2x + 1 + k,
+// k running from -radius to radius - 1
+const int32_t kMaxRadius = 3;
+struct Kernel {
+    int32_t radius;
+    float weights[2 * kMaxRadius];
+};
+
+const float kKaiserAlpha = 4.0f;
+
+double BesselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int32_t k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+const Kernel& GetKernel(MipFilter filter) {
+    static const Kernel s_Box = {1, {0.5f, 0.5f}};
+    static const Kernel s_Kaiser = []() {
+        Kernel kernel = {kMaxRadius, {}};
+        const double pi = 3.14159265358979323846;
+        double sum = 0.0;
+        double weights[2 * kMaxRadius];
+        for (int32_t k = -kMaxRadius; k < kMaxRadius; k++) {
+            // distance from the center of the output pixel, in source
+            // pixels. the sinc cuts off at half the source frequency.
+            double d = k + 0.5;
+            double t = pi * d / 2.0;
+            double sinc = sin(t) / t;
+            double r = d / kMaxRadius;
+            double window = BesselI0(kKaiserAlpha * sqrt(1.0 - r * r)) /
+                            BesselI0(kKaiserAlpha);
+            weights[k + kMaxRadius] = sinc * window;
+            sum += sinc * window;
+        }
+        for (int32_t i = 0; i < 2 * kMaxRadius; i++) {
+            kernel.weights[i] = static_cast<float>(weights[i] / sum);
+        }
+        return kernel;
+    }();
+
+    return (filter == MipFilter::kBox) ? s_Box : s_Kaiser;
+}
+
+int32_t Edge(int32_t i, int32_t size, bool wrap) {
+    if (wrap) return ((i % size) + size) % size;
+    return min(max(i, 0), size - 1);
+}
+
+struct Level {
+    uint8_t* data;
+    uint32_t width;
+    uint32_t height;
+    size_t pitch;
+};
+
+const uint32_t kBandRows = 16;
+
+void FilterLevel(const Level& src, const Level& dst, Format format,
+                 const Kernel& kernel, bool wrap) {
+    const int32_t taps = 2 * kernel.radius;
+
+    // the source columns of every output pixel, shared by all rows
+    vector<int32_t> columns(static_cast<size_t>(dst.width) * taps);
+    for (uint32_t x = 0; x < dst.width; x++) {
+        for (int32_t k = 0; k < taps; k++) {
+            int32_t sx = 2 * static_cast<int32_t>(x) + 1 - kernel.radius + k;
+            columns[x * taps + k] =
+                4 * Edge(sx, static_cast<int32_t>(src.width), wrap);
+        }
+    }
+
+    // negative lobes may push values out of range
+    const float hi = (format == Format::kRGBA32F) ? INFINITY : 1.0f;
+
+    size_t bands = (dst.height + kBandRows - 1) / kBandRows;
+    WorkerPool::GetDecodePool().ParallelFor(bands, [&](size_t band) {
+        int32_t y0 = static_cast<int32_t>(band * kBandRows);
+        int32_t y1 = min(y0 + static_cast<int32_t>(kBandRows),
+                         static_cast<int32_t>(dst.height));
+
+        // the source rows the band reads, filtered across first
+        int32_t first = 2 * y0 + 1 - kernel.radius;
+        int32_t rows = 2 * (y1 - 1) + kernel.radius - first + 1;
+        const size_t stride = static_cast<size_t>(dst.width) * 4;
+        vector<float> line(static_cast<size_t>(src.width) * 4);
+        vector<float> across(rows * stride);
+
+        for (int32_t r = 0; r < rows; r++) {
+            int32_t sy =
+                Edge(first + r, static_cast<int32_t>(src.height), wrap);
+            DecodeRow(format, src.data + src.pitch * sy, line.data(),
+                      src.width);
+
+            float* out = &across[r * stride];
+            for (uint32_t x = 0; x < dst.width; x++) {
+                const int32_t* column = &columns[x * taps];
+                // a pixel is four floats, filtered in one vector
+                Float4 sum = Float4::Splat(0.0f);
+                for (int32_t k = 0; k < taps; k++) {
+                    sum = sum + Float4::Load(&line[column[k]]) *
+                                    Float4::Splat(kernel.weights[k]);
+                }
+                sum.Store(out + 4 * x);
+            }
+        }
+
+        // then down, a row at a time
+        vector<float> row(stride);
+        for (int32_t y = y0; y < y1; y++) {
+            const float* in =
+                &across[(2 * y + 1 - kernel.radius - first) * stride];
+            for (uint32_t x = 0; x < dst.width; x++) {
+                Float4 sum = Float4::Splat(0.0f);
+                for (int32_t k = 0; k < taps; k++) {
+                    sum = sum + Float4::Load(in + k * stride + 4 * x) *
+                                    Float4::Splat(kernel.weights[k]);
+                }
+                Min(Max(sum, Float4::Splat(0.0f)), Float4::Splat(hi))
+                    .Store(&row[4 * x]);
+            }
+
+            EncodeRow(format, row.data(), dst.data + dst.pitch * y,
+                      dst.width);
+        }
+    });
+}
+}  // namespace
+
+namespace My {
+bool GenerateMipChain(Image& image, const MipChainSettings& settings) {
+    if (image.compressed || !image.data || image.mipmaps.size() > 1) {
+        return false;
+    }
+
+    Format format;
+    if (image.bitcount == 8 && !image.is_float) {
+        format = Format::kR8;
+    } else if (image.bitcount == 32 && !image.is_float) {
+        format = settings.srgb ? Format::kSRGBA8 : Format::kRGBA8;
+    } else if (image.bitcount == 64 && !image.is_float) {
+        format = Format::kRGBA16;
+    } else if (image.bitcount == 128 && image.is_float) {
+        format = Format::kRGBA32F;
+    } else {
+        return false;
+    }
+
+    const size_t pixel_size = image.bitcount >> 3;
+    const size_t base_size = image.pitch * image.Height;
+
+    vector<Image::Mipmap> mipmaps;
+    mipmaps.emplace_back(image.Width, image.Height, image.pitch, 0,
+                         base_size);
+    size_t data_size = base_size;
+    uint32_t width = image.Width;
+    uint32_t height = image.Height;
+    while (width > 1 || height > 1) {
+        width = max(1u, width >> 1);
+        height = max(1u, height >> 1);
+        size_t pitch = width * pixel_size;
+        mipmaps.emplace_back(width, height, pitch, data_size, pitch * height);
+        data_size += pitch * height;
+    }
+
+    auto* data = new uint8_t[data_size];
+    memcpy(data, image.data, base_size);
+
+    const Kernel& kernel = GetKernel(settings.filter);
+    for (size_t i = 1; i < mipmaps.size(); i++) {
+        const auto& above = mipmaps[i - 1];
+        const auto& mip = mipmaps[i];
+        FilterLevel({data + above.offset, above.Width, above.Height,
+                     above.pitch},
+                    {data + mip.offset, mip.Width, mip.Height, mip.pitch},
+                    format, kernel, settings.wrap);
+    }
+
+    image.AdoptData(data);
+    image.data_size = data_size;
+    image.mipmaps = std::move(mipmaps);
+
+    return true;
+}
+}  // namespace My
@@ -0,0 +1,28 @@
+#pragma once
+#include "Image.hpp"
+
+namespace My {
+enum class MipFilter {
+    // 2x2 average, the cheapest
+    kBox,
+    // Kaiser windowed sinc, sharper levels with less aliasing
+    kKaiser,
+};
+
+struct MipChainSettings {
+    MipFilter filter{MipFilter::kKaiser};
+    // the color channels of 8 bit images hold sRGB and are filtered in
+    // linear space, alpha is always linear
+    bool srgb{false};
+    // tiling textures wrap around at the edges, others are clamped
+    bool wrap{true};
+};
+
+// appends the levels down to 1x1 to an image holding only its base level,
+// laid out one after another as in a DDS file. each level is filtered from
+// the one above it in bands of rows spread over the decode pool, so it may
+// be called from a decode task. 8 and 16 bit RGBA, 32 bit float RGBA and
+// 8 bit single channel images, which are never sRGB, are handled. any
+// other image is left alone and false returned.
+bool GenerateMipChain(Image& image, const MipChainSettings& settings = {});
+}  // namespace My
@@ -0,0 +1,277 @@
+#include "PakArchive.hpp"
+
+#include "zlib.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "config.h"
+
+#if defined(USE_LZ4)
+#include <lz4.h>
+#endif
+
+using namespace My;
+using namespace std;
+
+namespace My {
+string NormalizePakName(const char* name) {
+    string normalized(name);
+    replace(normalized.begin(), normalized.end(), '\\', '/');
+
+    size_t start = 0;
+    while (true) {
+        if (normalized.compare(start, 2, "./") == 0) {
+            start += 2;
+        } else if (normalized.compare(start, 1, "/") == 0) {
+            start += 1;
+        } else {
+            break;
+        }
+    }
+
+    return normalized.substr(start);
+}
+
+uint64_t HashPakName(const string& normalized) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (char c : normalized) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+}  // namespace My
+
+bool PakArchive::Open(Buffer&& data) {
+    m_Data = std::move(data);
+    m_pToc = nullptr;
+    m_pNames = nullptr;
+    m_nEntryCount = 0;
+
+    size_t size = m_Data.GetDataSize();
+    if (size < sizeof(PakHeader)) return false;
+
+    PakHeader header;
+    memcpy(&header, m_Data.GetData(), sizeof(header));
+    if (header.magic != kPakMagic || header.version != kPakVersion) {
+        return false;
+    }
+
+    uint64_t toc_size = uint64_t(header.entryCount) * sizeof(PakTocEntry);
+    if (header.tocOffset > size || toc_size > size - header.tocOffset ||
+        header.tocOffset % alignof(PakTocEntry) ||
+        header.namesOffset > size ||
+        header.namesSize > size - header.namesOffset) {
+        return false;
+    }
+
+    m_pToc = reinterpret_cast<const PakTocEntry*>(m_Data.GetData() +
+                                                  header.tocOffset);
+    m_pNames =
+        reinterpret_cast<const char*>(m_Data.GetData() + header.namesOffset);
+    m_nEntryCount = header.entryCount;
+
+    // a damaged toc must not send a read outside the archive
+    for (size_t i = 0; i < m_nEntryCount; i++) {
+        const auto& entry = m_pToc[i];
+        if (entry.offset > size || entry.storedSize > size - entry.offset ||
+            entry.nameOffset > header.namesSize ||
+            entry.nameLength > header.namesSize - entry.nameOffset) {
+            m_pToc = nullptr;
+            m_nEntryCount = 0;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+const PakTocEntry* PakArchive::Find(const char* name) const {
+    string normalized = NormalizePakName(name);
+    uint64_t hash = HashPakName(normalized);
+
+    const PakTocEntry* end = m_pToc + m_nEntryCount;
+    auto it = lower_bound(
+        m_pToc, end, hash,
+        [](const PakTocEntry& entry, uint64_t h) { return entry.hash < h; });
+
+    // colliding hashes sit next to each other, the name decides
+    for (; it != end && it->hash == hash; it++) {
+        if (normalized.compare(0, string::npos, m_pNames + it->nameOffset,
+                               it->nameLength) == 0) {
+            return it;
+        }
+    }
+
+    return nullptr;
+}
+
+bool PakArchive::Contains(const char* name) const {
+    return Find(name) != nullptr;
+}
+
+Buffer PakArchive::GetEntryBytes(const char* name) const {
+    const PakTocEntry* entry = Find(name);
+    if (!entry) return Buffer();
+
+    return m_Data.Slice(entry->offset, entry->storedSize);
+}
+
+Buffer PakArchive::Read(const char* name) const {
+    const PakTocEntry* entry = Find(name);
+    if (!entry) return Buffer();
+
+    if (entry->codec == PakCodec::kStored) {
+        return m_Data.Slice(entry->offset, entry->storedSize);
+    }
+
+    Buffer buf(entry->size, Buffer::kSimdAlignment);
+    const uint8_t* src = m_Data.GetData() + entry->offset;
+
+    switch (entry->codec) {
+        case PakCodec::kZlib: {
+            uLongf size = entry->size;
+            if (uncompress(buf.GetData(), &size, src, entry->storedSize) !=
+                    Z_OK ||
+                size != entry->size) {
+                return Buffer();
+            }
+        } break;
+#if defined(USE_LZ4)
+        case PakCodec::kLz4: {
+            int size = LZ4_decompress_safe(
+                reinterpret_cast<const char*>(src),
+                reinterpret_cast<char*>(buf.GetData()),
+                static_cast<int>(entry->storedSize),
+                static_cast<int>(entry->size));
+            if (size < 0 || static_cast<uint64_t>(size) != entry->size) {
+                return Buffer();
+            }
+        } break;
+#endif
+        default:
+            fprintf(stderr, "Unsupported codec %u for archive entry '%s'\n",
+                    static_cast<uint32_t>(entry->codec), name);
+            return Buffer();
+    }
+
+    return buf;
+}
+
+PakWriter::~PakWriter() {
+    if (m_pFile) fclose(m_pFile);
+}
+
+bool PakWriter::Begin(const char* path) {
+    m_pFile = fopen(path, "wb");
+    if (!m_pFile) return false;
+
+    m_Toc.clear();
+    m_Names.clear();
+
+    // the header is written by Finish once the toc is known, the first
+    // payload starts on the next page
+    m_nOffset = 0;
+    return Pad(kPakAlignment);
+}
+
+bool PakWriter::Pad(size_t padding) {
+    static const uint8_t zeros[kPakAlignment] = {};
+    if (padding && fwrite(zeros, padding, 1, m_pFile) != 1) return false;
+    m_nOffset += padding;
+    return true;
+}
+
+bool PakWriter::AddEntry(const char* name, const uint8_t* data, size_t size,
+                         PakCodec codec) {
+    string normalized = NormalizePakName(name);
+
+    PakTocEntry entry;
+    memset(&entry, 0x00, sizeof(entry));
+    entry.hash = HashPakName(normalized);
+    entry.offset = m_nOffset;
+    entry.size = size;
+    entry.nameOffset = static_cast<uint32_t>(m_Names.size());
+    entry.nameLength = static_cast<uint32_t>(normalized.size());
+
+#if !defined(USE_LZ4)
+    if (codec == PakCodec::kLz4) codec = PakCodec::kZlib;
+#endif
+
+    vector<uint8_t> compressed;
+    if (codec == PakCodec::kZlib && size) {
+        uLongf bound = compressBound(size);
+        compressed.resize(bound);
+        if (compress2(compressed.data(), &bound, data, size,
+                      Z_BEST_COMPRESSION) != Z_OK) {
+            return false;
+        }
+        compressed.resize(bound);
+    }
+#if defined(USE_LZ4)
+    else if (codec == PakCodec::kLz4 && size) {
+        compressed.resize(LZ4_compressBound(static_cast<int>(size)));
+        int bound = LZ4_compress_default(
+            reinterpret_cast<const char*>(data),
+            reinterpret_cast<char*>(compressed.data()), static_cast<int>(size),
+            static_cast<int>(compressed.size()));
+        if (bound <= 0) return false;
+        compressed.resize(bound);
+    }
+#endif
+
+    // already compressed formats (png, jpeg) do not shrink, store them so
+    // they are read without a copy
+    if (compressed.empty() || compressed.size() > size - size / 8) {
+        codec = PakCodec::kStored;
+    } else {
+        data = compressed.data();
+        size = compressed.size();
+    }
+
+    entry.codec = codec;
+    entry.storedSize = size;
+
+    if (size && fwrite(data, size, 1, m_pFile) != 1) return false;
+    m_nOffset += size;
+
+    m_Toc.push_back(entry);
+    m_Names.append(normalized);
+
+    return Pad((kPakAlignment - m_nOffset % kPakAlignment) % kPakAlignment);
+}
+
+bool PakWriter::Finish() {
+    stable_sort(m_Toc.begin(), m_Toc.end(),
+                [](const PakTocEntry& a, const PakTocEntry& b) {
+                    return a.hash < b.hash;
+                });
+
+    PakHeader header;
+    memset(&header, 0x00, sizeof(header));
+    header.magic = kPakMagic;
+    header.version = kPakVersion;
+    header.entryCount = static_cast<uint32_t>(m_Toc.size());
+    header.tocOffset = m_nOffset;
+    header.namesOffset = m_nOffset + m_Toc.size() * sizeof(PakTocEntry);
+    header.namesSize = m_Names.size();
+
+    bool ok = true;
+    if (!m_Toc.empty()) {
+        ok = fwrite(m_Toc.data(), m_Toc.size() * sizeof(PakTocEntry), 1,
+                    m_pFile) == 1;
+    }
+    if (ok && !m_Names.empty()) {
+        ok = fwrite(m_Names.data(), m_Names.size(), 1, m_pFile) == 1;
+    }
+    if (ok) {
+        ok = fseek(m_pFile, 0, SEEK_SET) == 0 &&
+             fwrite(&header, sizeof(header), 1, m_pFile) == 1;
+    }
+
+    ok = (fclose(m_pFile) == 0) && ok;
+    m_pFile = nullptr;
+
+    return ok;
+}
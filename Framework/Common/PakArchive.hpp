@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Buffer.hpp"
+
+namespace My {
+// .pak archive layout, all integers little endian
+//
+//   PakHeader
+//   entry payloads, each starting on a kPakAlignment boundary
+//   PakTocEntry[entryCount], sorted by hash
+//   names of the entries, referred to by the toc
+//
+// a stored entry is a slice of the archive, so it keeps the alignment of
+// the mapping. compressed entries are inflated into buffers of their own.
+
+static constexpr uint32_t kPakMagic = 0x4b50594d;  // "MYPK"
+static constexpr uint32_t kPakVersion = 1;
+static constexpr size_t kPakAlignment = 4096;
+
+enum class PakCodec : uint32_t { kStored = 0, kZlib = 1, kLz4 = 2 };
+
+struct PakHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t tocOffset;
+    uint64_t namesOffset;
+    uint64_t namesSize;
+};
+
+struct PakTocEntry {
+    uint64_t hash;
+    uint64_t offset;
+    uint64_t storedSize;
+    uint64_t size;
+    PakCodec codec;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(PakHeader) == 40, "PakHeader is part of the format");
+static_assert(sizeof(PakTocEntry) == 48, "PakTocEntry is part of the format");
+
+// forward slashes, no leading "./" or "/"
+std::string NormalizePakName(const char* name);
+
+// FNV-1a of the normalized name
+uint64_t HashPakName(const std::string& normalized);
+
+// read-only view of an archive held in a buffer, usually a mapping of the
+// whole file. thread safe once opened.
+class PakArchive {
+   public:
+    // takes the archive content, false if it is not a valid archive
+    bool Open(Buffer&& data);
+
+    [[nodiscard]] bool Contains(const char* name) const;
+
+    // the content of the entry, empty if there is none or it is corrupt
+    [[nodiscard]] Buffer Read(const char* name) const;
+
+    // the bytes of the entry as stored in the archive, compressed or not
+    [[nodiscard]] Buffer GetEntryBytes(const char* name) const;
+
+    [[nodiscard]] size_t GetEntryCount() const { return m_nEntryCount; }
+
+   private:
+    [[nodiscard]] const PakTocEntry* Find(const char* name) const;
+
+    Buffer m_Data;
+    const PakTocEntry* m_pToc{nullptr};
+    const char* m_pNames{nullptr};
+    size_t m_nEntryCount{0};
+};
+
+// writes an archive entry by entry, the toc follows the payloads
+class PakWriter {
+   public:
+    ~PakWriter();
+
+    bool Begin(const char* path);
+
+    // codec is a preference, entries that do not shrink by at least an
+    // eighth are stored. kLz4 falls back to kZlib without LZ4 support.
+    bool AddEntry(const char* name, const uint8_t* data, size_t size,
+                  PakCodec codec);
+
+    bool Finish();
+
+   private:
+    bool Pad(size_t padding);
+
+    FILE* m_pFile{nullptr};
+    uint64_t m_nOffset{0};
+    std::vector<PakTocEntry> m_Toc;
+    std::string m_Names;
+};
+}  // namespace My
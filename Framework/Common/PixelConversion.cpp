@@ -0,0 +1,265 @@
+#include "PixelConversion.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+#define MYGE_PIXEL_SSE 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+// the intrinsics are always available, the CPU is checked at run time
+#define MYGE_TARGET(features)
+#else
+#include <immintrin.h>
+#define MYGE_TARGET(features) __attribute__((target(features)))
+#endif
+#elif defined(__aarch64__) && !defined(__ARM_BIG_ENDIAN)
+#define MYGE_PIXEL_NEON 1
+#include <arm_neon.h>
+#endif
+
+using namespace My;
+
+// every conversion is a byte shuffle of fixed size blocks, the same table
+// serves pshufb and tbl. an index with the high bit set gives a zero byte
+// the alpha is or-ed into.
+namespace {
+const uint8_t Z = 0x80;
+
+// 12 bytes in, 16 out
+const uint8_t kRGB8ToRGBA8[16] = {0, 1, 2, Z, 3, 4,  5,  Z,
+                                  6, 7, 8, Z, 9, 10, 11, Z};
+const uint8_t kBGR8ToRGBA8[16] = {2, 1, 0, Z, 5,  4,  3, Z,
+                                  8, 7, 6, Z, 11, 10, 9, Z};
+const uint8_t kRGB16ToRGBA16[16] = {0, 1, 2, 3, 4,  5,  Z, Z,
+                                    6, 7, 8, 9, 10, 11, Z, Z};
+const uint8_t kRGB16BEToRGBA16[16] = {1, 0, 3, 2, 5,  4,  Z, Z,
+                                      7, 6, 9, 8, 11, 10, Z, Z};
+const uint8_t kAlpha8[16] = {0, 0, 0, 0xFF, 0, 0, 0, 0xFF,
+                             0, 0, 0, 0xFF, 0, 0, 0, 0xFF};
+const uint8_t kAlpha16[16] = {0, 0, 0, 0, 0, 0, 0xFF, 0xFF,
+                              0, 0, 0, 0, 0, 0, 0xFF, 0xFF};
+
+// 16 bytes in, 16 out
+const uint8_t kBGRA8ToRGBA8[16] = {2,  1, 0, 3,  6,  5,  4,  7,
+                                   10, 9, 8, 11, 14, 13, 12, 15};
+const uint8_t kSwapBytes16[16] = {1, 0, 3,  2,  5,  4,  7,  6,
+                                  9, 8, 11, 10, 13, 12, 15, 14};
+const uint8_t kNoAlpha[16] = {0};
+
+// shuffles blocks of in bytes to blocks of 16. when in is less than 16,
+// every load still reads 16 bytes, the caller leaves that much readable.
+using BlockKernel = void (*)(const uint8_t* src, uint8_t* dst, size_t blocks,
+                             size_t in, const uint8_t* table,
+                             const uint8_t* alpha);
+
+#if defined(MYGE_PIXEL_SSE)
+MYGE_TARGET("ssse3")
+void ShuffleBlocksSsse3(const uint8_t* src, uint8_t* dst, size_t blocks,
+                        size_t in, const uint8_t* table, const uint8_t* alpha) {
+    const __m128i mask =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(table));
+    const __m128i bits =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(alpha));
+
+    for (size_t i = 0; i < blocks; i++) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+        v = _mm_or_si128(_mm_shuffle_epi8(v, mask), bits);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), v);
+        src += in;
+        dst += 16;
+    }
+}
+
+MYGE_TARGET("avx2")
+void ShuffleBlocksAvx2(const uint8_t* src, uint8_t* dst, size_t blocks,
+                       size_t in, const uint8_t* table, const uint8_t* alpha) {
+    // two blocks at a time, one in each lane
+    const __m256i mask = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(table)));
+    const __m256i bits = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(alpha)));
+
+    size_t i = 0;
+    for (; i + 2 <= blocks; i += 2) {
+        __m256i v = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(src))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + in)), 1);
+        v = _mm256_or_si256(_mm256_shuffle_epi8(v, mask), bits);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), v);
+        src += 2 * in;
+        dst += 32;
+    }
+
+    if (i < blocks) {
+        ShuffleBlocksSsse3(src, dst, 1, in, table, alpha);
+    }
+}
+
+bool CpuHasSsse3() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+#else
+    return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+bool CpuHasAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    // the OS saves the ymm registers
+    bool os_saves_ymm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return os_saves_ymm && (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#elif defined(MYGE_PIXEL_NEON)
+void ShuffleBlocksNeon(const uint8_t* src, uint8_t* dst, size_t blocks,
+                       size_t in, const uint8_t* table, const uint8_t* alpha) {
+    // tbl gives zero for out of range indices, as pshufb does
+    const uint8x16_t mask = vld1q_u8(table);
+    const uint8x16_t bits = vld1q_u8(alpha);
+
+    for (size_t i = 0; i < blocks; i++) {
+        uint8x16_t v = vqtbl1q_u8(vld1q_u8(src), mask);
+        vst1q_u8(dst, vorrq_u8(v, bits));
+        src += in;
+        dst += 16;
+    }
+}
+#endif
+
+BlockKernel GetBlockKernel() {
+    static const BlockKernel s_Kernel = []() -> BlockKernel {
+#if defined(MYGE_PIXEL_SSE)
+        if (CpuHasAvx2()) return ShuffleBlocksAvx2;
+        if (CpuHasSsse3()) return ShuffleBlocksSsse3;
+#elif defined(MYGE_PIXEL_NEON)
+        return ShuffleBlocksNeon;
+#endif
+        return nullptr;
+    }();
+
+    return s_Kernel;
+}
+
+// 16 pixels in, their first bytes out. SSE2 and NEON are part of the 64
+// bit targets, no dispatch needed.
+size_t ExtractRedRow(const uint8_t* src, uint8_t* dst, size_t count) {
+    size_t i = 0;
+#if defined(MYGE_PIXEL_SSE) && (defined(__SSE2__) || defined(_M_X64))
+    const __m128i low = _mm_set1_epi32(0xFF);
+    for (; i + 16 <= count; i += 16) {
+        const auto* in = reinterpret_cast<const __m128i*>(src + 4 * i);
+        __m128i a = _mm_and_si128(_mm_loadu_si128(in), low);
+        __m128i b = _mm_and_si128(_mm_loadu_si128(in + 1), low);
+        __m128i c = _mm_and_si128(_mm_loadu_si128(in + 2), low);
+        __m128i d = _mm_and_si128(_mm_loadu_si128(in + 3), low);
+        __m128i v = _mm_packus_epi16(_mm_packs_epi32(a, b),
+                                     _mm_packs_epi32(c, d));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+    }
+#elif defined(MYGE_PIXEL_NEON)
+    for (; i + 16 <= count; i += 16) {
+        vst1q_u8(dst + i, vld4q_u8(src + 4 * i).val[0]);
+    }
+#endif
+    return i;
+}
+
+// the blocks of a row the kernel can take, every load reading 16 bytes
+// within the row. the rest is left to the scalar loops.
+size_t CountBlocks(size_t bytes, size_t in) {
+    return bytes < 16 ? 0 : (bytes - 16) / in + 1;
+}
+
+// runs the kernel over the leading blocks, returns the pixels it converted
+size_t ShuffleRow(const uint8_t* src, uint8_t* dst, size_t count,
+                  size_t in_pixel, size_t pixels_per_block,
+                  const uint8_t* table, const uint8_t* alpha) {
+    BlockKernel kernel = GetBlockKernel();
+    if (!kernel) return 0;
+
+    size_t in = in_pixel * pixels_per_block;
+    size_t blocks = CountBlocks(count * in_pixel, in);
+    kernel(src, dst, blocks, in, table, alpha);
+
+    return blocks * pixels_per_block;
+}
+}  // namespace
+
+namespace My {
+void ExpandRGB8ToRGBA8(const uint8_t* src, uint8_t* dst, size_t count) {
+    size_t i = ShuffleRow(src, dst, count, 3, 4, kRGB8ToRGBA8, kAlpha8);
+    for (; i < count; i++) {
+        dst[4 * i] = src[3 * i];
+        dst[4 * i + 1] = src[3 * i + 1];
+        dst[4 * i + 2] = src[3 * i + 2];
+        dst[4 * i + 3] = 0xFF;
+    }
+}
+
+void ExpandBGR8ToRGBA8(const uint8_t* src, uint8_t* dst, size_t count) {
+    size_t i = ShuffleRow(src, dst, count, 3, 4, kBGR8ToRGBA8, kAlpha8);
+    for (; i < count; i++) {
+        dst[4 * i] = src[3 * i + 2];
+        dst[4 * i + 1] = src[3 * i + 1];
+        dst[4 * i + 2] = src[3 * i];
+        dst[4 * i + 3] = 0xFF;
+    }
+}
+
+void SwizzleBGRA8ToRGBA8(const uint8_t* src, uint8_t* dst, size_t count) {
+    size_t i = ShuffleRow(src, dst, count, 4, 4, kBGRA8ToRGBA8, kNoAlpha);
+    for (; i < count; i++) {
+        dst[4 * i] = src[4 * i + 2];
+        dst[4 * i + 1] = src[4 * i + 1];
+        dst[4 * i + 2] = src[4 * i];
+        dst[4 * i + 3] = src[4 * i + 3];
+    }
+}
+
+void ExpandRGB16ToRGBA16(const uint16_t* src, uint16_t* dst, size_t count) {
+    size_t i = ShuffleRow(reinterpret_cast<const uint8_t*>(src),
+                          reinterpret_cast<uint8_t*>(dst), count, 6, 2,
+                          kRGB16ToRGBA16, kAlpha16);
+    for (; i < count; i++) {
+        dst[4 * i] = src[3 * i];
+        dst[4 * i + 1] = src[3 * i + 1];
+        dst[4 * i + 2] = src[3 * i + 2];
+        dst[4 * i + 3] = 0xFFFF;
+    }
+}
+
+void ExpandRGB16BEToRGBA16(const uint8_t* src, uint16_t* dst, size_t count) {
+    size_t i = ShuffleRow(src, reinterpret_cast<uint8_t*>(dst), count, 6, 2,
+                          kRGB16BEToRGBA16, kAlpha16);
+    for (; i < count; i++) {
+        for (size_t c = 0; c < 3; c++) {
+            const uint8_t* sample = src + 6 * i + 2 * c;
+            dst[4 * i + c] =
+                static_cast<uint16_t>((sample[0] << 8) | sample[1]);
+        }
+        dst[4 * i + 3] = 0xFFFF;
+    }
+}
+
+void LoadBigEndian16(const uint8_t* src, uint16_t* dst, size_t count) {
+    size_t i = ShuffleRow(src, reinterpret_cast<uint8_t*>(dst), count, 2, 8,
+                          kSwapBytes16, kNoAlpha);
+    for (; i < count; i++) {
+        dst[i] = static_cast<uint16_t>((src[2 * i] << 8) | src[2 * i + 1]);
+    }
+}
+
+void ExtractRedFromRGBA8(const uint8_t* src, uint8_t* dst, size_t count) {
+    size_t i = ExtractRedRow(src, dst, count);
+    for (; i < count; i++) {
+        dst[i] = src[4 * i];
+    }
+}
+}  // namespace My
@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace My {
+// what the image parsers write for sources without an alpha channel
+enum class PixelLayout {
+    // the channels as stored, 24 and 48 bit pixels stay as they are
+    kNative,
+    // widened to 32 and 64 bit with an opaque alpha, the layouts GPUs take
+    kRGBA,
+};
+
+// row conversions for the parsers, count is in pixels. SSSE3 or AVX2 is
+// used when the CPU has it, NEON on 64 bit ARM. source and destination
+// must not overlap, neither needs to be aligned.
+
+// 8 bit RGB to RGBA, alpha 0xFF
+void ExpandRGB8ToRGBA8(const uint8_t* src, uint8_t* dst, size_t count);
+// 8 bit BGR to RGBA, alpha 0xFF
+void ExpandBGR8ToRGBA8(const uint8_t* src, uint8_t* dst, size_t count);
+// 8 bit BGRA to RGBA
+void SwizzleBGRA8ToRGBA8(const uint8_t* src, uint8_t* dst, size_t count);
+// 16 bit RGB to RGBA, alpha 0xFFFF
+void ExpandRGB16ToRGBA16(const uint16_t* src, uint16_t* dst, size_t count);
+// big endian 16 bit RGB to native RGBA, alpha 0xFFFF
+void ExpandRGB16BEToRGBA16(const uint8_t* src, uint16_t* dst, size_t count);
+// big endian 16 bit samples to native ones, count is in samples
+void LoadBigEndian16(const uint8_t* src, uint16_t* dst, size_t count);
+// the red channel of 8 bit RGBA, for maps holding a single value
+void ExtractRedFromRGBA8(const uint8_t* src, uint8_t* dst, size_t count);
+}  // namespace My
@@ -4,7 +4,7 @@ using namespace My;
 using namespace std;
 
 shared_ptr<SceneObjectCamera> Scene::GetCamera(const std::string& key) const {
-    auto i = Cameras.find(key);
+    auto i = Cameras.find(Key(key));
     if (i == Cameras.end()) {
         return nullptr;
     }
@@ -13,7 +13,7 @@ shared_ptr<SceneObjectCamera> Scene::GetCamera(const std::string& key) const {
 }
 
 shared_ptr<SceneObjectLight> Scene::GetLight(const std::string& key) const {
-    auto i = Lights.find(key);
+    auto i = Lights.find(Key(key));
     if (i == Lights.end()) {
         return nullptr;
     }
@@ -23,7 +23,7 @@ shared_ptr<SceneObjectLight> Scene::GetLight(const std::string& key) const {
 
 shared_ptr<SceneObjectGeometry> Scene::GetGeometry(
     const std::string& key) const {
-    auto i = Geometries.find(key);
+    auto i = Geometries.find(Key(key));
     if (i == Geometries.end()) {
         return nullptr;
     }
@@ -33,7 +33,7 @@ shared_ptr<SceneObjectGeometry> Scene::GetGeometry(
 
 shared_ptr<SceneObjectMaterial> Scene::GetMaterial(
     const std::string& key) const {
-    auto i = Materials.find(key);
+    auto i = Materials.find(Key(key));
     if (i == Materials.end()) {
         return m_pDefaultMaterial;
     }
@@ -1,38 +1,54 @@
 #pragma once
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
+#include "MemoryResource.hpp"
 #include "SceneNode.hpp"
 #include "SceneObject.hpp"
 
 namespace My {
 class Scene {
    private:
+    // the containers below and the transforms of the nodes live in this
+    // arena. nodes share its ownership, so it is released in one go once
+    // the scene and the last of its nodes are gone. not thread safe.
+    std::shared_ptr<ArenaMemoryResource> m_pArena{
+        std::make_shared<ArenaMemoryResource>(MemoryTag::kScene)};
+
     std::shared_ptr<SceneObjectMaterial> m_pDefaultMaterial;
 
    public:
-    std::shared_ptr<BaseSceneNode> SceneGraph;
-
-    std::unordered_map<std::string, std::shared_ptr<SceneObjectCamera>> Cameras;
-    std::unordered_map<std::string, std::shared_ptr<SceneObjectLight>> Lights;
-    std::unordered_map<std::string, std::shared_ptr<SceneObjectMaterial>>
-        Materials;
-    std::unordered_map<std::string, std::shared_ptr<SceneObjectGeometry>>
-        Geometries;
-
-    std::unordered_multimap<std::string, std::weak_ptr<SceneCameraNode>>
-        CameraNodes;
-    std::unordered_multimap<std::string, std::weak_ptr<SceneLightNode>>
-        LightNodes;
-    std::unordered_multimap<std::string, std::weak_ptr<SceneGeometryNode>>
-        GeometryNodes;
-    std::unordered_map<std::string, std::weak_ptr<SceneBoneNode>> BoneNodes;
+    // names are kept in the arena too
+    using Key = std::pmr::string;
 
-    std::vector<std::weak_ptr<BaseSceneNode>> AnimatableNodes;
+    std::shared_ptr<BaseSceneNode> SceneGraph;
 
-    std::unordered_map<std::string, std::weak_ptr<SceneGeometryNode>>
-        LUT_Name_GeometryNode;
+    std::pmr::unordered_map<Key, std::shared_ptr<SceneObjectCamera>>
+        Cameras{m_pArena.get()};
+    std::pmr::unordered_map<Key, std::shared_ptr<SceneObjectLight>>
+        Lights{m_pArena.get()};
+    std::pmr::unordered_map<Key, std::shared_ptr<SceneObjectMaterial>>
+        Materials{m_pArena.get()};
+    std::pmr::unordered_map<Key, std::shared_ptr<SceneObjectGeometry>>
+        Geometries{m_pArena.get()};
+
+    std::pmr::unordered_multimap<Key, std::weak_ptr<SceneCameraNode>>
+        CameraNodes{m_pArena.get()};
+    std::pmr::unordered_multimap<Key, std::weak_ptr<SceneLightNode>>
+        LightNodes{m_pArena.get()};
+    std::pmr::unordered_multimap<Key, std::weak_ptr<SceneGeometryNode>>
+        GeometryNodes{m_pArena.get()};
+    std::pmr::unordered_map<Key, std::weak_ptr<SceneBoneNode>>
+        BoneNodes{m_pArena.get()};
+
+    std::pmr::vector<std::weak_ptr<BaseSceneNode>> AnimatableNodes{
+        m_pArena.get()};
+
+    std::pmr::unordered_map<Key, std::weak_ptr<SceneGeometryNode>>
+        LUT_Name_GeometryNode{m_pArena.get()};
 
     std::shared_ptr<SceneObjectSkyBox> SkyBox;
 
@@ -48,11 +64,16 @@ class Scene {
     }
 
     explicit Scene(const std::string& scene_name) : Scene() {
-        SceneGraph = std::make_shared<BaseSceneNode>(scene_name);
+        SceneGraph = std::make_shared<BaseSceneNode>(scene_name, m_pArena);
     }
 
     ~Scene() { std::cerr << "Scene destroyed" << std::endl; }
 
+    // nodes of this scene should allocate from here
+    [[nodiscard]] std::shared_ptr<std::pmr::memory_resource> GetArena() const {
+        return m_pArena;
+    }
+
     [[nodiscard]] std::shared_ptr<SceneObjectCamera> GetCamera(
         const std::string& key) const;
     [[nodiscard]] std::shared_ptr<SceneCameraNode> GetFirstCameraNode() const;
@@ -14,7 +14,11 @@ int SceneManager::Initialize() {
     return result;
 }
 
-void SceneManager::Finalize() {}
+void SceneManager::Finalize() {
+    // the scene arena takes its pages from the memory manager, it must be
+    // gone before the memory manager finalizes
+    m_pScene.reset();
+}
 
 void SceneManager::Tick() {}
 
@@ -61,7 +65,7 @@ weak_ptr<BaseSceneNode> SceneManager::GetRootNode() const {
 
 weak_ptr<SceneGeometryNode> SceneManager::GetSceneGeometryNode(
     const string& name) const {
-    auto it = m_pScene->LUT_Name_GeometryNode.find(name);
+    auto it = m_pScene->LUT_Name_GeometryNode.find(Scene::Key(name));
     if (it != m_pScene->LUT_Name_GeometryNode.end()) {
         return it->second;
     }
@@ -71,5 +75,5 @@ weak_ptr<SceneGeometryNode> SceneManager::GetSceneGeometryNode(
 
 weak_ptr<SceneObjectGeometry> SceneManager::GetSceneGeometryObject(
     const string& key) const {
-    return m_pScene->Geometries.find(key)->second;
+    return m_pScene->Geometries.find(Scene::Key(key))->second;
 }
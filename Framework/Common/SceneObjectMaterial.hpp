@@ -95,54 +95,21 @@ class SceneObjectMaterial : public BaseSceneObject {
     }
 
     void SetTexture(const std::string& attrib, const std::string& textureName) {
-        if (attrib == "diffuse") {
-            m_BaseColor = std::make_shared<SceneObjectTexture>(textureName);
-        }
-
-        else if (attrib == "specular") {
-            m_Specular = std::make_shared<SceneObjectTexture>(textureName);
-        }
-
-        else if (attrib == "specular_power") {
-            m_SpecularPower = std::make_shared<SceneObjectTexture>(textureName);
-        }
-
-        else if (attrib == "emission") {
-            m_Emission = std::make_shared<SceneObjectTexture>(textureName);
-        }
-
-        else if (attrib == "opacity") {
-            m_Opacity = std::make_shared<SceneObjectTexture>(textureName);
-        }
-
-        else if (attrib == "transparency") {
-            m_Transparency = std::make_shared<SceneObjectTexture>(textureName);
-        }
-
-        else if (attrib == "normal") {
-            m_Normal = std::make_shared<SceneObjectTexture>(textureName);
-        }
-
-        else if (attrib == "metallic") {
-            m_Metallic = std::make_shared<SceneObjectTexture>(textureName);
-        }
-
-        else if (attrib == "roughness") {
-            m_Roughness = std::make_shared<SceneObjectTexture>(textureName);
-        }
-
-        else if (attrib == "ao") {
-            m_AmbientOcclusion =
-                std::make_shared<SceneObjectTexture>(textureName);
-        }
-
-        else if (attrib == "height") {
-            m_Height = std::make_shared<SceneObjectTexture>(textureName);
-        }
+        SetTexture(attrib, std::make_shared<SceneObjectTexture>(textureName));
     }
 
     void SetTexture(const std::string& attrib,
                     const std::shared_ptr<SceneObjectTexture>& texture) {
+        // color maps are sRGB, the others hold data. maps of a single
+        // value are decoded to one channel, the shaders read only red.
+        if (attrib == "diffuse" || attrib == "specular" ||
+            attrib == "emission") {
+            texture->SetSRGB(true);
+        } else if (attrib == "metallic" || attrib == "roughness" ||
+                   attrib == "ao") {
+            texture->SetSingleChannel(true);
+        }
+
         if (attrib == "diffuse") {
             m_BaseColor = texture;
         }
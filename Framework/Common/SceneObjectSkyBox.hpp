@@ -7,7 +7,14 @@ namespace My {
 class SceneObjectSkyBox : public BaseSceneObject {
    public:
     SceneObjectSkyBox()
-        : BaseSceneObject(SceneObjectType::kSceneObjectTypeSkyBox) {}
+        : BaseSceneObject(SceneObjectType::kSceneObjectTypeSkyBox) {
+        // the irradiance faces are uploaded as the second level of the sky
+        // box faces and the radiance faces bring their own levels, none of
+        // them get a chain built at load time
+        for (auto& texture : m_Textures) {
+            texture.SetMipChain(false);
+        }
+    }
     SceneObjectSkyBox(const SceneObjectSkyBox& rhs) = delete;
     SceneObjectSkyBox(SceneObjectSkyBox&& rhs) noexcept = delete;
     SceneObjectSkyBox& operator=(const SceneObjectSkyBox& rhs) = delete;
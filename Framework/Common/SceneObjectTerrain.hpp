@@ -29,12 +29,18 @@ class SceneObjectTerrain : public BaseSceneObject {
         return m_Textures[index];
     }
 
-   private:
+    // the height maps of the grid, area_i_j covering the patch i across and
+    // j down, a patch wide
     static const int32_t nMaxTerrainGridWidth = 16;
     static const int32_t nMaxTerrainGridHeight = 16;
     static const int32_t nMaxTerrainHeightMapCount =
         nMaxTerrainGridWidth * nMaxTerrainGridHeight;
+    static constexpr float kPatchSize = 32.0f;
+    // the corner of area_0_0 in world space, on both axes. the terrain is
+    // drawn from there and its pages are asked for from there.
+    static constexpr float kGridOrigin = -5 * kPatchSize;
 
+   private:
     SceneObjectTexture m_Textures[nMaxTerrainHeightMapCount];
 };
 }  // namespace My
\ No newline at end of file
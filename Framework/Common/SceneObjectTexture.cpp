@@ -1,36 +1,386 @@
 #include "SceneObjectTexture.hpp"
 
-#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <unordered_map>
+
+#include "MipChain.hpp"
+#include "PakArchive.hpp"
+#include "PixelConversion.hpp"
+#include "TextureCache.hpp"
+#include "WorkerPool.hpp"
 
 using namespace My;
 using namespace std;
 
-void SceneObjectTexture::LoadTextureAsync() {
-    if (!m_asyncLoadFuture.valid()) {
-        m_asyncLoadFuture =
-            async(launch::async, &SceneObjectTexture::LoadTexture, this);
+struct SceneObjectTexture::Registry {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::weak_ptr<SharedImage>> images;
+
+    std::atomic<size_t> residentBytes{0};
+    std::atomic<size_t> budget{kDefaultResidencyBudget};
+    std::atomic<uint64_t> frame{0};
+    // an image was uploaded since the last trim
+    std::atomic<bool> trimPending{false};
+
+    std::atomic<uint32_t> tailMips{kDefaultStreamingTailMips};
+    std::atomic<size_t> streamingBudget{kDefaultStreamingBudget};
+    std::atomic<size_t> streamedBytes{0};
+};
+
+// the decoding options an image is kept apart by, in the registry and in
+// the texture cache
+static string DecodeVariant(bool srgb, bool single_channel, bool mip_chain) {
+    string variant;
+    if (srgb) variant += "+srgb";
+    if (single_channel) variant += "+r8";
+    if (!mip_chain) variant += "+nomips";
+    return variant.empty() ? variant : variant.substr(1);
+}
+
+SceneObjectTexture::Registry& SceneObjectTexture::GetRegistry() {
+    // never destroyed, textures held by static objects outlive it otherwise
+    static auto* s_pRegistry = new Registry;
+    return *s_pRegistry;
+}
+
+size_t SceneObjectTexture::GetSharedImageCount() {
+    auto& registry = GetRegistry();
+    lock_guard<mutex> lock(registry.mutex);
+    return registry.images.size();
+}
+
+void SceneObjectTexture::SetResidencyBudget(size_t bytes) {
+    GetRegistry().budget = bytes;
+    TrimResidency();
+}
+
+size_t SceneObjectTexture::GetResidentBytes() {
+    return GetRegistry().residentBytes;
+}
+
+void SceneObjectTexture::SetStreamingTailMips(uint32_t count) {
+    GetRegistry().tailMips = max(count, 1u);
+}
+
+void SceneObjectTexture::SetStreamingBudget(size_t bytes) {
+    GetRegistry().streamingBudget = bytes;
+}
+
+size_t SceneObjectTexture::GetStreamedBytes() {
+    return GetRegistry().streamedBytes;
+}
+
+void SceneObjectTexture::AdvanceFrame() {
+    auto& registry = GetRegistry();
+
+    UpdateStreaming();
+    registry.frame++;
+
+    if (registry.trimPending.exchange(false) ||
+        registry.residentBytes > registry.budget) {
+        TrimResidency();
+    }
+}
+
+vector<shared_ptr<SceneObjectTexture::SharedImage>>
+SceneObjectTexture::GetSharedImages() {
+    auto& registry = GetRegistry();
+
+    // the last reference to an image may be dropped by the caller, and
+    // that takes the lock again
+    vector<shared_ptr<SharedImage>> images;
+    lock_guard<mutex> lock(registry.mutex);
+    images.reserve(registry.images.size());
+    for (const auto& entry : registry.images) {
+        if (auto image = entry.second.lock()) {
+            images.push_back(std::move(image));
+        }
+    }
+
+    return images;
+}
+
+// the level whose size is closest above the pixels it is drawn across
+static uint32_t LevelForScreenSize(uint32_t size, float pixels) {
+    if (pixels >= size) return 0;
+    return static_cast<uint32_t>(floor(log2(size / pixels)));
+}
+
+void SceneObjectTexture::UpdateStreaming() {
+    auto& registry = GetRegistry();
+    auto images = GetSharedImages();
+
+    // a step streams one level more of an image. the levels the frame
+    // asked for go before those only kept from earlier frames, coarse
+    // levels before fine ones, so that every image gets some detail before
+    // any gets all of it, and the largest on screen first.
+    struct Step {
+        bool asked;
+        uint32_t level;
+        float demand;
+        size_t image;
+    };
+
+    vector<uint32_t> chosen(images.size(), 0);
+    vector<Step> steps;
+    size_t streamed = 0;
+    for (size_t i = 0; i < images.size(); i++) {
+        auto& image = *images[i];
+        lock_guard<mutex> lock(image.loadMutex);
+        auto levels = static_cast<uint32_t>(image.levelBytes.size());
+        if (!levels) continue;
+
+        // the tails are always held, whatever the budget
+        uint32_t tail =
+            (levels > registry.tailMips) ? levels - registry.tailMips : 0;
+        for (uint32_t level = tail; level < levels; level++) {
+            streamed += image.levelBytes[level];
+        }
+        chosen[i] = tail;
+
+        uint32_t wanted = tail;
+        if (image.demand > 0.0f) {
+            wanted =
+                min(tail, LevelForScreenSize(image.size, image.demand));
+        }
+        for (uint32_t level = min(wanted, image.streamedMip); level < tail;
+             level++) {
+            steps.push_back({level >= wanted, level, image.demand, i});
+        }
+    }
+
+    sort(steps.begin(), steps.end(), [](const Step& a, const Step& b) {
+        if (a.asked != b.asked) return a.asked;
+        if (a.level != b.level) return a.level > b.level;
+        return a.demand > b.demand;
+    });
+
+    for (const auto& step : steps) {
+        // a level is only streamed with the coarser ones
+        if (chosen[step.image] != step.level + 1) continue;
+
+        size_t bytes = images[step.image]->levelBytes[step.level];
+        if (streamed + bytes > registry.streamingBudget) continue;
+
+        streamed += bytes;
+        chosen[step.image] = step.level;
+    }
+
+    for (size_t i = 0; i < images.size(); i++) {
+        auto& image = *images[i];
+        lock_guard<mutex> lock(image.loadMutex);
+        if (image.levelBytes.empty()) continue;
+        image.streamedMip = chosen[i];
+        image.demand = 0.0f;
+    }
+
+    registry.streamedBytes = streamed;
+}
+
+void SceneObjectTexture::TrimResidency() {
+    auto& registry = GetRegistry();
+    auto images = GetSharedImages();
+
+    struct Candidate {
+        bool uploaded;
+        uint64_t lastUse;
+        SharedImage* image;
+    };
+
+    uint64_t frame = registry.frame;
+    vector<Candidate> candidates;
+    for (const auto& image : images) {
+        lock_guard<mutex> lock(image->loadMutex);
+        if (image->residentBytes && image->lastUse < frame) {
+            candidates.push_back(
+                {image->uploaded, image->lastUse, image.get()});
+        }
+    }
+
+    // uploaded images go first, then the least recently used
+    sort(candidates.begin(), candidates.end(),
+         [](const Candidate& a, const Candidate& b) {
+             if (a.uploaded != b.uploaded) return a.uploaded;
+             return a.lastUse < b.lastUse;
+         });
+
+    for (const auto& candidate : candidates) {
+        if (!candidate.uploaded && registry.residentBytes <= registry.budget) {
+            break;
+        }
+
+        registry.residentBytes -= candidate.image->Evict();
+    }
+}
+
+SceneObjectTexture::SharedImage::~SharedImage() {
+    // a read or decode still in flight finishes on its own, its result is
+    // dropped with the state
+    if (state) {
+        state->abandoned.store(true, std::memory_order_relaxed);
+        g_pAssetLoader->CancelAsyncRead(readId);
+    }
+
+    auto& registry = GetRegistry();
+    registry.residentBytes -= residentBytes;
+
+    // the slot may hold the image of a texture naming the asset again
+    lock_guard<mutex> lock(registry.mutex);
+    auto it = registry.images.find(key);
+    if (it != registry.images.end() && it->second.expired()) {
+        registry.images.erase(it);
+    }
+}
+
+void SceneObjectTexture::SharedImage::StartLoad() {
+    state = make_shared<LoadState>();
+    state->name = name;
+    state->srgb = srgb;
+    state->singleChannel = singleChannel;
+    state->mipChain = mipChain;
+    auto pending = make_shared<promise<bool>>();
+    loaded = pending->get_future().share();
+    started = true;
+
+    // decoded by an earlier run, mapping it is all there is to do
+    auto cached = TextureCache::Load(
+        name, DecodeVariant(srgb, singleChannel, mipChain));
+    if (cached) {
+        state->image = cached;
+        pending->set_value(true);
+        return;
     }
+
+    // the file is read on the asset loader I/O threads and decoded on the
+    // decode pool, so no more textures are decoded at once than there are
+    // cores
+    readId = g_pAssetLoader->AsyncReadBinary(
+        name.c_str(), 0, [state = state, pending](Buffer buf) {
+            WorkerPool::GetDecodePool().Submit(
+                [state, pending, buf = std::move(buf)]() mutable {
+                    pending->set_value(LoadTexture(*state, buf));
+                });
+        });
+}
+
+size_t SceneObjectTexture::SharedImage::Evict() {
+    lock_guard<mutex> lock(loadMutex);
+
+    // a load in flight is left alone
+    if (!started ||
+        loaded.wait_for(chrono::seconds(0)) != future_status::ready) {
+        return 0;
+    }
+
+    size_t bytes = residentBytes;
+    state.reset();
+    loaded = shared_future<bool>();
+    readId = 0;
+    started = false;
+    residentBytes = 0;
+    uploaded = false;
+
+    return bytes;
+}
+
+void SceneObjectTexture::SharedImage::LearnLevels(const Image& image) {
+    if (!levelBytes.empty()) return;
+
+    for (const auto& mip : image.mipmaps) {
+        levelBytes.push_back(mip.data_size);
+    }
+    if (levelBytes.empty()) levelBytes.push_back(image.data_size);
+    size = max(image.Width, image.Height);
+
+    auto levels = static_cast<uint32_t>(levelBytes.size());
+    uint32_t tail_mips = GetRegistry().tailMips;
+    streamedMip = (levels > tail_mips) ? levels - tail_mips : 0;
 }
 
-bool SceneObjectTexture::LoadTexture() {
-    if (!g_pAssetLoader->FileExists(m_Name.c_str())) return false;
+void SceneObjectTexture::AcquireSharedImage() {
+    if (m_Name.empty()) {
+        m_pSharedImage.reset();
+        return;
+    }
+
+    string key = NormalizePakName(m_Name.c_str());
+    string variant = DecodeVariant(m_bSRGB, m_bSingleChannel, m_bMipChain);
+    if (!variant.empty()) key += "#" + variant;
+    if (m_pSharedImage && m_pSharedImage->key == key) return;
 
-    cerr << "Start async loading of " << m_Name << endl;
+    shared_ptr<SharedImage> shared;
+    {
+        auto& registry = GetRegistry();
+        lock_guard<mutex> lock(registry.mutex);
+        auto& slot = registry.images[key];
+        shared = slot.lock();
+        if (!shared) {
+            shared = make_shared<SharedImage>();
+            shared->key = key;
+            shared->name = m_Name;
+            shared->srgb = m_bSRGB;
+            shared->singleChannel = m_bSingleChannel;
+            shared->mipChain = m_bMipChain;
+            slot = shared;
+        }
+    }
+
+    // the image named before, if any, is let go outside the lock
+    m_pSharedImage = std::move(shared);
+}
+
+void SceneObjectTexture::SetSRGB(bool srgb) {
+    m_bSRGB = srgb;
+    AcquireSharedImage();
+}
+
+void SceneObjectTexture::SetSingleChannel(bool single_channel) {
+    m_bSingleChannel = single_channel;
+    AcquireSharedImage();
+}
+
+void SceneObjectTexture::SetMipChain(bool mip_chain) {
+    m_bMipChain = mip_chain;
+    AcquireSharedImage();
+}
+
+shared_future<bool> SceneObjectTexture::StartLoadIfNeeded(
+    shared_ptr<LoadState>& state) {
+    auto& shared = *m_pSharedImage;
+    lock_guard<mutex> lock(shared.loadMutex);
+
+    if (!shared.started) {
+        shared.StartLoad();
+    }
+
+    shared.lastUse = GetRegistry().frame;
+    state = shared.state;
+    return shared.loaded;
+}
+
+bool SceneObjectTexture::LoadTexture(LoadState& state, Buffer& buf) {
+    if (!buf.GetDataSize()) return false;
+    if (state.abandoned.load(std::memory_order_relaxed)) return false;
+
+    const string& name = state.name;
+    cerr << "Start async loading of " << name << endl;
 
     Image image;
-    Buffer buf = g_pAssetLoader->SyncOpenAndReadBinary(m_Name.c_str());
-    string ext = m_Name.substr(m_Name.find_last_of('.'));
+    string ext = name.substr(name.find_last_of('.'));
     if (ext == ".jpg" || ext == ".jpeg") {
         JfifParser jfif_parser;
         image = jfif_parser.Parse(buf);
     } else if (ext == ".png") {
-        PngParser png_parser;
+        PngParser png_parser(PixelLayout::kRGBA);
         image = png_parser.Parse(buf);
     } else if (ext == ".bmp") {
         BmpParser bmp_parser;
         image = bmp_parser.Parse(buf);
     } else if (ext == ".tga") {
-        TgaParser tga_parser;
+        TgaParser tga_parser(PixelLayout::kRGBA);
         image = tga_parser.Parse(buf);
     } else if (ext == ".dds") {
         DdsParser dds_parser;
@@ -40,27 +390,19 @@ bool SceneObjectTexture::LoadTexture() {
         image = hdr_parser.Parse(buf);
     }
 
-    // GPU does not support 24bit and 48bit textures, so adjust it
+    // GPU does not support 24bit and 48bit textures, so adjust what the
+    // parsers could not write as RGBA themselves
     if (image.bitcount == 24) {
         // DXGI does not have 24bit formats so we have to extend it to 32bit
         auto new_pitch = image.pitch / 3 * 4;
         auto data_size = (size_t)new_pitch * image.Height;
         auto* data = new uint8_t[data_size];
-        uint8_t* buf;
-        uint8_t* src;
         for (decltype(image.Height) row = 0; row < image.Height; row++) {
-            buf = data + (ptrdiff_t)row * new_pitch;
-            src = image.data + (ptrdiff_t)row * image.pitch;
-            for (decltype(image.Width) col = 0; col < image.Width; col++) {
-                memcpy(buf, src, 3);
-                memset(buf + 3, 0x00, 1);  // set alpha to 0
-                buf += 4;
-                src += 3;
-            }
+            ExpandRGB8ToRGBA8(image.data + (ptrdiff_t)row * image.pitch,
+                              data + (ptrdiff_t)row * new_pitch, image.Width);
         }
 
-        delete[] image.data;
-        image.data = data;
+        image.AdoptData(data);
         image.data_size = data_size;
         image.pitch = new_pitch;
         image.bitcount = 32;
@@ -76,21 +418,15 @@ bool SceneObjectTexture::LoadTexture() {
         auto new_pitch = image.pitch / 3 * 4;
         auto data_size = new_pitch * image.Height;
         auto* data = new uint8_t[data_size];
-        uint8_t* buf;
-        uint8_t* src;
         for (decltype(image.Height) row = 0; row < image.Height; row++) {
-            buf = data + (ptrdiff_t)row * new_pitch;
-            src = image.data + (ptrdiff_t)row * image.pitch;
-            for (decltype(image.Width) col = 0; col < image.Width; col++) {
-                memcpy(buf, src, 6);
-                memset(buf + 6, 0x00, 2);  // set alpha to 0
-                buf += 8;
-                src += 6;
-            }
+            ExpandRGB16ToRGBA16(
+                reinterpret_cast<uint16_t*>(image.data +
+                                            (ptrdiff_t)row * image.pitch),
+                reinterpret_cast<uint16_t*>(data + (ptrdiff_t)row * new_pitch),
+                image.Width);
         }
 
-        delete[] image.data;
-        image.data = data;
+        image.AdoptData(data);
         image.data_size = data_size;
         image.pitch = new_pitch;
         image.bitcount = 64;
@@ -103,21 +439,122 @@ bool SceneObjectTexture::LoadTexture() {
         }
     }
 
-    cerr << "End async loading of " << m_Name << endl;
+    // maps of a single value keep only it, before the mips are built
+    if (state.singleChannel && !image.compressed && !image.is_float &&
+        image.bitcount == 32 && image.mipmaps.size() == 1) {
+        auto pitch = static_cast<size_t>(image.Width);
+        auto data_size = pitch * image.Height;
+        auto* data = new uint8_t[data_size];
+        for (decltype(image.Height) row = 0; row < image.Height; row++) {
+            ExtractRedFromRGBA8(image.data + (ptrdiff_t)row * image.pitch,
+                                data + (ptrdiff_t)row * pitch, image.Width);
+        }
 
-    atomic_store_explicit(&m_pImage, make_shared<Image>(std::move(image)),
-                          std::memory_order::memory_order_release);
+        image.AdoptData(data);
+        image.data_size = data_size;
+        image.pitch = pitch;
+        image.bitcount = 8;
+        image.mipmaps[0] = Image::Mipmap(image.Width, image.Height, pitch, 0,
+                                         data_size);
+    }
+
+    // the levels the drivers would otherwise build at upload, they are
+    // cached with the image
+    if (state.mipChain && !image.compressed && image.mipmaps.size() == 1) {
+        MipChainSettings settings;
+        settings.srgb = state.srgb;
+        GenerateMipChain(image, settings);
+    }
+
+    cerr << "End async loading of " << name << endl;
+
+    // dds files are used as they are, decoding them costs nothing
+    if (ext != ".dds") {
+        TextureCache::Store(
+            name, image,
+            DecodeVariant(state.srgb, state.singleChannel, state.mipChain));
+    }
+
+    // published by the promise the caller fulfills
+    state.image = make_shared<Image>(std::move(image));
 
     return true;
 }
 
+void SceneObjectTexture::RequestImage() {
+    if (!m_pSharedImage) return;
+
+    shared_ptr<LoadState> state;
+    StartLoadIfNeeded(state);
+}
+
 std::shared_ptr<Image> SceneObjectTexture::GetTextureImage() {
-    if (m_asyncLoadFuture.valid()) {
-        m_asyncLoadFuture.wait();
-        assert(m_asyncLoadFuture.get());
-        return atomic_load_explicit(&m_pImage,
-                                    std::memory_order::memory_order_acquire);
-    } else {
-        return m_pImage;
+    if (!m_pSharedImage) return nullptr;
+
+    shared_ptr<LoadState> state;
+    auto loaded = StartLoadIfNeeded(state);
+    loaded.wait();
+    assert(loaded.get());
+
+    return HandOut(state);
+}
+
+std::shared_ptr<Image> SceneObjectTexture::TryGetTextureImage() {
+    if (!m_pSharedImage) return nullptr;
+
+    shared_ptr<LoadState> state;
+    auto loaded = StartLoadIfNeeded(state);
+    if (loaded.wait_for(chrono::seconds(0)) != future_status::ready ||
+        !loaded.get()) {
+        return nullptr;
+    }
+
+    return HandOut(state);
+}
+
+std::shared_ptr<Image> SceneObjectTexture::HandOut(
+    const shared_ptr<LoadState>& state) {
+    // resident from now on, unless it was evicted meanwhile
+    auto& registry = GetRegistry();
+    size_t resident = 0;
+    {
+        auto& shared = *m_pSharedImage;
+        lock_guard<mutex> lock(shared.loadMutex);
+        if (state->image) shared.LearnLevels(*state->image);
+        if (shared.state == state && !shared.residentBytes && state->image) {
+            shared.residentBytes = max<size_t>(state->image->data_size, 1);
+            resident = registry.residentBytes += shared.residentBytes;
+        }
+    }
+
+    if (resident > registry.budget) {
+        TrimResidency();
     }
+
+    return state->image;
+}
+
+void SceneObjectTexture::MarkUploaded() {
+    if (!m_pSharedImage) return;
+
+    {
+        lock_guard<mutex> lock(m_pSharedImage->loadMutex);
+        m_pSharedImage->uploaded = true;
+    }
+
+    GetRegistry().trimPending = true;
+}
+
+void SceneObjectTexture::RequestScreenSize(float pixels) {
+    if (!m_pSharedImage) return;
+
+    lock_guard<mutex> lock(m_pSharedImage->loadMutex);
+    m_pSharedImage->demand = max(m_pSharedImage->demand, pixels);
+}
+
+uint32_t SceneObjectTexture::GetStreamedMip() const {
+    if (!m_pSharedImage) return 0;
+
+    lock_guard<mutex> lock(m_pSharedImage->loadMutex);
+    return m_pSharedImage->streamedMip;
 }
@@ -1,5 +1,7 @@
 #pragma once
+#include <atomic>
 #include <future>
+#include <mutex>
 #include <utility>
 
 #include "AssetLoader.hpp"
@@ -18,8 +20,72 @@ class SceneObjectTexture : public BaseSceneObject {
     std::string m_Name;
     uint32_t m_nTexCoordIndex{0};
     std::vector<Matrix4X4f> m_Transforms;
-    std::shared_ptr<Image> m_pImage;
-    std::future<bool> m_asyncLoadFuture;
+    bool m_bSRGB{false};
+    bool m_bSingleChannel{false};
+    bool m_bMipChain{true};
+
+    // shared with the read and the decode of an asset, which may still be
+    // queued when the last texture naming it is gone
+    struct LoadState {
+        std::string name;
+        bool srgb{false};
+        bool singleChannel{false};
+        bool mipChain{true};
+        std::shared_ptr<Image> image;
+        std::atomic<bool> abandoned{false};
+    };
+
+    // one per asset and decoding of it, shared by every texture naming it
+    // with the same options, the file is read and decoded once for all of
+    // them. the last texture letting go of it abandons a load in flight
+    // and drops the asset from the registry.
+    struct SharedImage {
+        std::string key;
+        std::string name;
+        // the options the image is decoded with, part of the key
+        bool srgb{false};
+        bool singleChannel{false};
+        bool mipChain{true};
+
+        std::mutex loadMutex;
+        // a new load starts over with a new state and future, the first
+        // one when the image is asked for, another after it was evicted
+        std::shared_ptr<LoadState> state;
+        std::shared_future<bool> loaded;
+        AssetLoader::AsyncRequestId readId{0};
+        bool started{false};
+
+        // counted from the first time the image is handed out
+        size_t residentBytes{0};
+        uint64_t lastUse{0};
+        bool uploaded{false};
+
+        // mip streaming, the levels are known once the image was first
+        // handed out. the bytes of each level, finest first.
+        std::vector<size_t> levelBytes;
+        uint32_t size{0};
+        // the most pixels any texture naming the image is drawn across
+        // during the current frame
+        float demand{0.0f};
+        // the finest level the GPU is to hold
+        uint32_t streamedMip{0};
+
+        ~SharedImage();
+        // maps the image cached by an earlier run, or queues the read.
+        // called with loadMutex held.
+        void StartLoad();
+        // drops a loaded image, returns the bytes no longer resident
+        size_t Evict();
+        // records the levels of the image handed out first, with only the
+        // smallest of them streamed. called with loadMutex held.
+        void LearnLevels(const Image& image);
+    };
+    std::shared_ptr<SharedImage> m_pSharedImage;
+
+    // the shared images by normalized asset name and decoding options,
+    // and their residency
+    struct Registry;
+    static Registry& GetRegistry();
 
    public:
     SceneObjectTexture()
@@ -27,25 +93,98 @@ class SceneObjectTexture : public BaseSceneObject {
     explicit SceneObjectTexture(const std::string& name)
         : BaseSceneObject(SceneObjectType::kSceneObjectTypeTexture),
           m_Name(name) {
-        LoadTextureAsync();
+        AcquireSharedImage();
     }
 
     void AddTransform(Matrix4X4f& matrix) { m_Transforms.push_back(matrix); }
     void SetName(const std::string& name) {
         m_Name = name;
-        LoadTextureAsync();
+        AcquireSharedImage();
     }
     void SetName(std::string&& name) {
         m_Name = std::forward<std::string>(name);
-        LoadTextureAsync();
+        AcquireSharedImage();
     }
     [[nodiscard]] const std::string& GetName() const { return m_Name; }
+    // the normalized name and the decode options, the same for textures
+    // sharing an image and different for the other decodings of a file
+    [[nodiscard]] const std::string& GetKey() const {
+        return m_pSharedImage ? m_pSharedImage->key : m_Name;
+    }
+
+    // the texture holds color encoded as sRGB, its mips are filtered in
+    // linear space. textures naming the same file as sRGB and as linear
+    // get images of their own.
+    void SetSRGB(bool srgb);
+    [[nodiscard]] bool IsSRGB() const { return m_bSRGB; }
 
+    // the texture holds one value per pixel in its red channel, such as a
+    // roughness, metallic or ao map. 8 bit RGBA images are kept as 8 bit
+    // single channel ones, a quarter of the size. like sRGB, an image of
+    // its own.
+    void SetSingleChannel(bool single_channel);
+    [[nodiscard]] bool IsSingleChannel() const { return m_bSingleChannel; }
+
+    // the texture keeps the levels its file has, without a chain built at
+    // load time. the faces of a sky box are placed as levels of a cube map
+    // by the renderers. like sRGB, an image of its own.
+    void SetMipChain(bool mip_chain);
+    [[nodiscard]] bool HasMipChain() const { return m_bMipChain; }
+
+    // images are loaded when first asked for, this waits for the load
     std::shared_ptr<Image> GetTextureImage();
+    // the image if it is loaded, otherwise starts loading it and gives
+    // nullptr
+    std::shared_ptr<Image> TryGetTextureImage();
+    // starts loading the image without waiting for it
+    void RequestImage();
+    // the GPU holds a copy, the image is evicted with the next frame
+    void MarkUploaded();
+
+    // the assets some texture refers to, each decoded at most once
+    static size_t GetSharedImageCount();
+
+    // images are evicted least recently used first once their bytes
+    // exceed the budget, except those used during the current frame
+    static constexpr size_t kDefaultResidencyBudget = 512 * 1024 * 1024;
+    static void SetResidencyBudget(size_t bytes);
+    static size_t GetResidentBytes();
+
+    // mip streaming. the GPU holds the smallest mips of every texture from
+    // the start, finer levels are streamed in as the size the texture is
+    // drawn at asks for them, within a budget shared by all textures.
+    // textures drawn large and close to the camera get their levels first.
+
+    // the texture is drawn across about this many pixels this frame
+    void RequestScreenSize(float pixels);
+    // the finest level the GPU should hold, 0 until the image was loaded
+    [[nodiscard]] uint32_t GetStreamedMip() const;
+
+    // the mips every texture keeps whatever the budget
+    static constexpr uint32_t kDefaultStreamingTailMips = 7;
+    static void SetStreamingTailMips(uint32_t count);
+    // the bytes of the levels the GPU is to hold, the tails included
+    static constexpr size_t kDefaultStreamingBudget = 256 * 1024 * 1024;
+    static void SetStreamingBudget(size_t bytes);
+    static size_t GetStreamedBytes();
+
+    // call once per frame, evicts the uploaded images and trims the rest
+    // to the budget, then picks the levels to stream for the demand of the
+    // frame
+    static void AdvanceFrame();
 
    private:
-    bool LoadTexture();
-    void LoadTextureAsync();
+    static bool LoadTexture(LoadState& state, Buffer& buf);
+    static void TrimResidency();
+    static void UpdateStreaming();
+    // every image in the registry, held while the registry is not locked
+    static std::vector<std::shared_ptr<SharedImage>> GetSharedImages();
+    void AcquireSharedImage();
+    // the current load of the image, started if there is none
+    std::shared_future<bool> StartLoadIfNeeded(
+        std::shared_ptr<LoadState>& state);
+    // the image of a finished load, counted as resident
+    std::shared_ptr<Image> HandOut(const std::shared_ptr<LoadState>& state);
 
     friend std::ostream& operator<<(std::ostream& out,
                                     const SceneObjectTexture& obj);
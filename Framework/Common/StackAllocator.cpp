@@ -1,15 +1,125 @@
 #include "StackAllocator.hpp"
 
+#include <cassert>
+
+#include "IMemoryManager.hpp"
+#include "portable.hpp"
+
 using namespace My;
 
 StackAllocator::StackAllocator() = default;
 
-StackAllocator::StackAllocator(size_t page_size, size_t alignment) {}
+StackAllocator::StackAllocator(size_t page_size, size_t alignment,
+                               MemoryTag tag) {
+    Reset(page_size, alignment, tag);
+}
+
+StackAllocator::~StackAllocator() { FreeAll(); }
+
+void StackAllocator::Reset(size_t page_size, size_t alignment,
+                           MemoryTag tag) {
+    FreeAll();
+
+    m_Tag = tag;
+#if defined(_DEBUG)
+    assert(alignment > 0 && ((alignment & (alignment - 1))) == 0);
+    assert(page_size > sizeof(StackPageHeader));
+#endif
+    m_szPageSize = page_size;
+    m_szAlignment = alignment;
+}
+
+void* StackAllocator::Allocate(size_t size) {
+    return Allocate(size, m_szAlignment);
+}
+
+void* StackAllocator::Allocate(size_t size, size_t alignment) {
+    assert(m_szPageSize);
+    assert(alignment > 0 && ((alignment & (alignment - 1))) == 0);
+
+    if (alignment < m_szAlignment) alignment = m_szAlignment;
+
+    if (m_pCurrentPage) {
+        auto base = reinterpret_cast<uintptr_t>(m_pCurrentPage->Data());
+        size_t top = ALIGN(base + m_szStackTop, alignment) - base;
+        size_t capacity =
+            m_pCurrentPage->szPageSize - sizeof(StackPageHeader);
+        if (top + size <= capacity) {
+            m_szStackTop = top + size;
+            m_szAllocated += size;
+            return m_pCurrentPage->Data() + top;
+        }
+    }
+
+    NextPage(size + alignment - m_szAlignment);
 
-StackAllocator::~StackAllocator() = default;
+    auto base = reinterpret_cast<uintptr_t>(m_pCurrentPage->Data());
+    size_t top = ALIGN(base, alignment) - base;
+    m_szStackTop = top + size;
+    m_szAllocated += size;
 
-void* StackAllocator::Allocate(size_t size) { return nullptr; }
+    return m_pCurrentPage->Data() + top;
+}
 
 void StackAllocator::Free(void* p) {}
 
-void StackAllocator::FreeAll() {}
+void StackAllocator::FreeAll() {
+    StackPageHeader* pPage = m_pPageList;
+    while (pPage) {
+        StackPageHeader* _p = pPage;
+        pPage = pPage->pNext;
+
+        g_pMemoryManager->FreePage(reinterpret_cast<void*>(_p));
+    }
+
+    m_pPageList = nullptr;
+    m_pCurrentPage = nullptr;
+    m_szStackTop = 0;
+    m_szAllocated = 0;
+}
+
+void StackAllocator::Rewind() {
+    // oversized pages are only kept for the allocation which asked for them
+    StackPageHeader** ppPage = &m_pPageList;
+    while (*ppPage) {
+        StackPageHeader* pPage = *ppPage;
+        if (pPage->szPageSize != m_szPageSize) {
+            *ppPage = pPage->pNext;
+            g_pMemoryManager->FreePage(reinterpret_cast<void*>(pPage));
+        } else {
+            ppPage = &pPage->pNext;
+        }
+    }
+
+    m_pCurrentPage = m_pPageList;
+    m_szStackTop = 0;
+    m_szAllocated = 0;
+}
+
+void StackAllocator::NextPage(size_t size) {
+    size_t required = sizeof(StackPageHeader) + size + m_szAlignment;
+
+    // reuse the pages kept by Rewind first
+    StackPageHeader* pNext =
+        m_pCurrentPage ? m_pCurrentPage->pNext : m_pPageList;
+    if (pNext && pNext->szPageSize >= required) {
+        m_pCurrentPage = pNext;
+        return;
+    }
+
+    size_t page_size = (required > m_szPageSize) ? required : m_szPageSize;
+    auto* pNewPage = reinterpret_cast<StackPageHeader*>(
+        g_pMemoryManager->AllocatePage(page_size, m_Tag));
+    pNewPage->szPageSize = page_size;
+
+    // link the new page right after the current one
+    if (m_pCurrentPage) {
+        pNewPage->pNext = m_pCurrentPage->pNext;
+        m_pCurrentPage->pNext = pNewPage;
+    } else {
+        pNewPage->pNext = m_pPageList;
+        m_pPageList = pNewPage;
+    }
+
+    m_pCurrentPage = pNewPage;
+}
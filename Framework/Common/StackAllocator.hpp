@@ -1,29 +1,70 @@
+#pragma once
 #include <cstddef>
 #include <cstdint>
-#include <list>
-#include <memory>
 
 #include "IAllocator.hpp"
+#include "IMemoryManager.hpp"
 
 namespace My {
+// linear (bump) allocator. allocations are never freed one by one, the
+// whole stack is rewound at once. not thread safe.
 class StackAllocator : _implements_ IAllocator {
    public:
     StackAllocator();
-    StackAllocator(size_t page_size, size_t alignment);
+    StackAllocator(size_t page_size, size_t alignment,
+                   MemoryTag tag = MemoryTag::kGeneral);
     ~StackAllocator() override;
     // disable copy & assignment
     StackAllocator(const StackAllocator& clone) = delete;
     StackAllocator& operator=(const StackAllocator& rhs) = delete;
 
+    // resets the allocator to a new configuration
+    void Reset(size_t page_size, size_t alignment,
+               MemoryTag tag = MemoryTag::kGeneral);
+
     // alloc and free blocks
     void* Allocate(size_t size) override;
+    // alignment overrides the one given at Reset when it is stricter
+    void* Allocate(size_t size, size_t alignment);
+    // no-op, memory is reclaimed by Rewind or FreeAll
     void Free(void* p) override;
+    // returns all pages to the memory manager
     void FreeAll() override;
 
+    // invalidates all allocations but keeps the pages for reuse
+    void Rewind();
+
+    template <typename T>
+    T* AllocateArray(size_t count) {
+        return reinterpret_cast<T*>(Allocate(sizeof(T) * count));
+    }
+
+    [[nodiscard]] size_t GetAllocatedSize() const { return m_szAllocated; }
+
    protected:
-    std::list<uint8_t*> m_pPages;
-    std::list<std::shared_ptr<void>> m_pAllocatedPointers;
-    int64_t m_StackTop;
-    size_t m_MaxSize;
+    struct StackPageHeader {
+        StackPageHeader* pNext;
+        size_t szPageSize;
+        uint8_t* Data() { return reinterpret_cast<uint8_t*>(this + 1); }
+    };
+
+    // grows the stack by a page which can hold at least size bytes
+    void NextPage(size_t size);
+
+    // the page list, in allocation order
+    StackPageHeader* m_pPageList{nullptr};
+    // the page we are currently bumping in
+    StackPageHeader* m_pCurrentPage{nullptr};
+    // offset of the stack top in the current page
+    size_t m_szStackTop{0};
+
+    // pages are accounted to this tag
+    MemoryTag m_Tag{MemoryTag::kGeneral};
+
+    size_t m_szPageSize{0};
+    size_t m_szAlignment{0};
+
+    // statistics
+    size_t m_szAllocated{0};
 };
 }  // namespace My
@@ -0,0 +1,294 @@
+#include "TextureCache.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+
+#include "AssetLoader.hpp"
+#include "PakArchive.hpp"
+
+#if defined(OS_LINUX) || defined(OS_ANDROID) || defined(OS_BSD) || \
+    defined(OS_MACOS)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MYGE_MAPPED_READS 1
+#elif defined(OS_WINDOWS)
+#include <process.h>
+#define getpid _getpid
+#endif
+
+using namespace My;
+using namespace std;
+
+namespace {
+const uint32_t kTextureCacheMagic = 0x4354594d;  // "MYTC"
+// bump whenever the layout or the decoding of any format changes
+const uint32_t kTextureCacheVersion = 6;
+const size_t kTextureCacheAlignment = 4096;
+// a 2^31 wide image has 32 levels
+const uint32_t kTextureCacheMaxMips = 32;
+
+struct TextureCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t sourceSize;
+    int64_t sourceModified;
+    uint32_t nameLength;
+    uint32_t mipCount;
+    uint32_t width;
+    uint32_t height;
+    uint32_t bitcount;
+    uint32_t compressFormat;
+    uint32_t compressed;
+    uint32_t isFloat;
+    uint64_t pitch;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+};
+
+struct TextureCacheMip {
+    uint32_t width;
+    uint32_t height;
+    uint64_t pitch;
+    uint64_t offset;
+    uint64_t dataSize;
+};
+
+mutex s_DirectoryMutex;
+string s_strDirectory;
+bool s_bDefaultDirectory = true;
+
+string GetDirectory(const AssetLoader::FileStamp& stamp, const string& name) {
+    {
+        lock_guard<mutex> lock(s_DirectoryMutex);
+        if (!s_bDefaultDirectory) return s_strDirectory;
+    }
+
+    // stamp.path is the Asset directory the source was found in followed
+    // by name, one level up per component of name
+    filesystem::path asset(stamp.path);
+    for (const auto& component : filesystem::path(name).lexically_normal()) {
+        (void)component;
+        asset = asset.parent_path();
+    }
+    return (asset.parent_path() / "Cache" / "Textures").string();
+}
+
+// the asset name and the variant it was decoded as
+string GetEntryKey(const string& name, const string& variant) {
+    string key = NormalizePakName(name.c_str());
+    if (!variant.empty()) key += "#" + variant;
+    return key;
+}
+
+// the entry name is the hash of the key, the key itself is kept in the
+// entry to tell colliding hashes apart
+string GetEntryPath(const AssetLoader::FileStamp& stamp, const string& name,
+                    const string& key) {
+    string directory = GetDirectory(stamp, name);
+    if (directory.empty()) return string();
+
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx",
+             static_cast<unsigned long long>(HashPakName(key)));
+    return directory + "/" + hex + ".img";
+}
+
+Buffer ReadEntry(const string& path) {
+#if defined(MYGE_MAPPED_READS)
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return Buffer();
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size == 0) {
+        close(fd);
+        return Buffer();
+    }
+
+    // private and writable, like the mappings of the asset loader
+    auto length = static_cast<size_t>(status.st_size);
+    void* p =
+        mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return Buffer();
+
+    return Buffer(static_cast<uint8_t*>(p), length,
+                  [length](uint8_t* data) { munmap(data, length); });
+#else
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (!fp) return Buffer();
+
+    fseek(fp, 0, SEEK_END);
+    auto length = static_cast<size_t>(ftell(fp));
+    fseek(fp, 0, SEEK_SET);
+
+    Buffer buf(length, kTextureCacheAlignment);
+    if (fread(buf.GetData(), length, 1, fp) != 1) buf = Buffer();
+    fclose(fp);
+    return buf;
+#endif
+}
+}  // namespace
+
+void TextureCache::SetDirectory(const string& path) {
+    lock_guard<mutex> lock(s_DirectoryMutex);
+    s_strDirectory = path;
+    s_bDefaultDirectory = false;
+}
+
+void TextureCache::SetDefaultDirectory() {
+    lock_guard<mutex> lock(s_DirectoryMutex);
+    s_strDirectory.clear();
+    s_bDefaultDirectory = true;
+}
+
+string TextureCache::GetDirectory(const string& name) {
+    AssetLoader::FileStamp stamp;
+    if (!g_pAssetLoader->GetFileStamp(name.c_str(), stamp)) return string();
+
+    return ::GetDirectory(stamp, name);
+}
+
+shared_ptr<Image> TextureCache::Load(const string& name,
+                                     const string& variant) {
+    AssetLoader::FileStamp stamp;
+    if (!g_pAssetLoader->GetFileStamp(name.c_str(), stamp)) return nullptr;
+
+    string key = GetEntryKey(name, variant);
+    string path = GetEntryPath(stamp, name, key);
+    if (path.empty()) return nullptr;
+
+    Buffer entry = ReadEntry(path);
+    size_t size = entry.GetDataSize();
+    if (size < sizeof(TextureCacheHeader)) return nullptr;
+
+    TextureCacheHeader header;
+    memcpy(&header, entry.GetData(), sizeof(header));
+
+    size_t mips_offset = sizeof(header) + header.nameLength;
+    if (header.magic != kTextureCacheMagic ||
+        header.version != kTextureCacheVersion ||
+        header.sourceSize != stamp.size ||
+        header.sourceModified != stamp.modified ||
+        header.mipCount > kTextureCacheMaxMips ||
+        mips_offset + uint64_t(header.mipCount) * sizeof(TextureCacheMip) >
+            size ||
+        header.dataOffset > size ||
+        header.dataSize > size - header.dataOffset) {
+        return nullptr;
+    }
+
+    if (key.compare(0, string::npos,
+                     reinterpret_cast<const char*>(entry.GetData()) +
+                         sizeof(header),
+                     header.nameLength) != 0) {
+        return nullptr;
+    }
+
+    auto image = make_shared<Image>();
+    image->Width = header.width;
+    image->Height = header.height;
+    image->bitcount = header.bitcount;
+    image->pitch = header.pitch;
+    image->data_size = header.dataSize;
+    image->compressed = header.compressed;
+    image->is_float = header.isFloat;
+    image->compress_format = header.compressFormat;
+
+    for (uint32_t i = 0; i < header.mipCount; i++) {
+        TextureCacheMip mip;
+        memcpy(&mip, entry.GetData() + mips_offset + i * sizeof(mip),
+               sizeof(mip));
+        // a level past the pixels would be read out of bounds on upload
+        if (mip.offset > header.dataSize ||
+            mip.dataSize > header.dataSize - mip.offset) {
+            return nullptr;
+        }
+        image->mipmaps.emplace_back(mip.width, mip.height, mip.pitch,
+                                    mip.offset, mip.dataSize);
+    }
+
+    // the pixels stay in the mapping
+    image->storage = entry.Slice(header.dataOffset, header.dataSize);
+    image->data = image->storage.GetData();
+
+    return image;
+}
+
+bool TextureCache::Store(const string& name, const Image& image,
+                         const string& variant) {
+    if (!image.data) return false;
+
+    AssetLoader::FileStamp stamp;
+    if (!g_pAssetLoader->GetFileStamp(name.c_str(), stamp)) return false;
+
+    string key = GetEntryKey(name, variant);
+    string path = GetEntryPath(stamp, name, key);
+    if (path.empty()) return false;
+
+    error_code error;
+    filesystem::create_directories(filesystem::path(path).parent_path(),
+                                   error);
+
+    TextureCacheHeader header;
+    memset(&header, 0x00, sizeof(header));
+    header.magic = kTextureCacheMagic;
+    header.version = kTextureCacheVersion;
+    header.sourceSize = stamp.size;
+    header.sourceModified = stamp.modified;
+    header.nameLength = static_cast<uint32_t>(key.size());
+    header.mipCount = static_cast<uint32_t>(image.mipmaps.size());
+    header.width = image.Width;
+    header.height = image.Height;
+    header.bitcount = image.bitcount;
+    header.compressFormat = image.compress_format;
+    header.compressed = image.compressed;
+    header.isFloat = image.is_float;
+    header.pitch = image.pitch;
+    header.dataSize = image.data_size;
+
+    size_t metadata_size = sizeof(header) + key.size() +
+                           image.mipmaps.size() * sizeof(TextureCacheMip);
+    header.dataOffset = (metadata_size + kTextureCacheAlignment - 1) /
+                        kTextureCacheAlignment * kTextureCacheAlignment;
+
+    vector<uint8_t> metadata(header.dataOffset, 0);
+    memcpy(metadata.data(), &header, sizeof(header));
+    memcpy(metadata.data() + sizeof(header), key.data(), key.size());
+    uint8_t* p = metadata.data() + sizeof(header) + key.size();
+    for (const auto& mipmap : image.mipmaps) {
+        TextureCacheMip mip = {mipmap.Width, mipmap.Height, mipmap.pitch,
+                               mipmap.offset, mipmap.data_size};
+        memcpy(p, &mip, sizeof(mip));
+        p += sizeof(mip);
+    }
+
+    // written aside and renamed into place, a reader never maps a half
+    // written entry. textures of the same name may be stored concurrently,
+    // by this process or another one sharing the cache.
+    static atomic<uint32_t> s_nSequence{0};
+    string temporary = path + "." + to_string(getpid()) + "." +
+                       to_string(s_nSequence.fetch_add(1)) + ".tmp";
+
+    FILE* fp = fopen(temporary.c_str(), "wb");
+    if (!fp) return false;
+
+    bool ok = fwrite(metadata.data(), metadata.size(), 1, fp) == 1 &&
+              (image.data_size == 0 ||
+               fwrite(image.data, image.data_size, 1, fp) == 1);
+    ok = (fclose(fp) == 0) && ok;
+
+    if (ok) {
+        filesystem::rename(temporary, path, error);
+        ok = !error;
+    }
+
+    if (!ok) {
+        remove(temporary.c_str());
+    }
+
+    return ok;
+}
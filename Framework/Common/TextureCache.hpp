@@ -0,0 +1,33 @@
+#pragma once
+#include <memory>
+#include <string>
+
+#include "Image.hpp"
+
+namespace My {
+// decoded images kept on disk between runs. an entry is named after the
+// asset and remembers the size and modification time of the file it was
+// decoded from, a changed file misses the cache. the pixels start on a
+// page boundary and the entry is mapped as is.
+class TextureCache {
+   public:
+    // where entries are kept, an empty path disables the cache
+    static void SetDirectory(const std::string& path);
+    // entries are kept in Cache/Textures beside the Asset directory their
+    // source was found in, whatever the working directory. the default.
+    static void SetDefaultDirectory();
+    // where the entry of name is kept, empty if the cache is disabled or
+    // name is not a loose file
+    static std::string GetDirectory(const std::string& name);
+
+    // the image decoded from name by an earlier run, null if there is
+    // none or the file changed since. variant names the options the image
+    // was decoded with, the same asset decoded otherwise is another entry.
+    static std::shared_ptr<Image> Load(const std::string& name,
+                                       const std::string& variant = "");
+
+    // remembers image as the decoded content of name
+    static bool Store(const std::string& name, const Image& image,
+                      const std::string& variant = "");
+};
+}  // namespace My
@@ -0,0 +1,720 @@
+#include "TextureCompression.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "Float4.hpp"
+#include "WorkerPool.hpp"
+#include "portable.hpp"
+
+using namespace My;
+using namespace std;
+
+namespace {
+// the pixels of a 4x4 block, a channel to an array so that four pixels
+// load into one Float4
+struct Block {
+    float channels[4][16];
+};
+
+size_t GetBlockBytes(BlockFormat format) {
+    return (format == BlockFormat::kBC1 || format == BlockFormat::kBC4) ? 8
+                                                                        : 16;
+}
+
+// the nearest palette entry for every pixel, over count channels from
+// first. palette holds an array of entries per channel. returns the summed
+// squared error.
+float FitIndices(const Block& block, uint32_t first, uint32_t count,
+                 const float palette[][16], uint32_t palette_size,
+                 uint8_t indices[16]) {
+    float error = 0.0f;
+    for (uint32_t i = 0; i < 16; i += 4) {
+        Float4 best = Float4::Splat(FLT_MAX);
+        Float4 best_index = Float4::Splat(0.0f);
+        for (uint32_t k = 0; k < palette_size; k++) {
+            Float4 distance = Float4::Splat(0.0f);
+            for (uint32_t c = 0; c < count; c++) {
+                Float4 d = Float4::Load(&block.channels[first + c][i]) -
+                           Float4::Splat(palette[c][k]);
+                distance = distance + d * d;
+            }
+            best_index = SelectLess(distance, best,
+                                    Float4::Splat(float(k)), best_index);
+            best = Min(distance, best);
+        }
+
+        float lanes[4];
+        float lane_indices[4];
+        best.Store(lanes);
+        best_index.Store(lane_indices);
+        for (uint32_t j = 0; j < 4; j++) {
+            indices[i + j] = static_cast<uint8_t>(lane_indices[j]);
+            error += lanes[j];
+        }
+    }
+    return error;
+}
+
+// the ends of the pixels along their principal axis, over the first three
+// channels
+void PrincipalEndpoints(const Block& block, float e0[3], float e1[3]) {
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    float lo[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float hi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (uint32_t c = 0; c < 3; c++) {
+        for (float v : block.channels[c]) {
+            mean[c] += v;
+            lo[c] = min(lo[c], v);
+            hi[c] = max(hi[c], v);
+        }
+        mean[c] /= 16.0f;
+    }
+
+    float covariance[3][3] = {};
+    for (uint32_t i = 0; i < 16; i++) {
+        float d[3];
+        for (uint32_t c = 0; c < 3; c++) d[c] = block.channels[c][i] - mean[c];
+        for (uint32_t r = 0; r < 3; r++) {
+            for (uint32_t c = 0; c < 3; c++) covariance[r][c] += d[r] * d[c];
+        }
+    }
+
+    // power iteration, from the diagonal of the bounding box
+    float axis[3] = {hi[0] - lo[0], hi[1] - lo[1], hi[2] - lo[2]};
+    for (int32_t iteration = 0; iteration < 8; iteration++) {
+        float next[3];
+        for (uint32_t r = 0; r < 3; r++) {
+            next[r] = covariance[r][0] * axis[0] + covariance[r][1] * axis[1] +
+                      covariance[r][2] * axis[2];
+        }
+        float length = max(fabs(next[0]), max(fabs(next[1]), fabs(next[2])));
+        if (length < FLT_MIN) break;
+        for (uint32_t r = 0; r < 3; r++) axis[r] = next[r] / length;
+    }
+
+    float length_squared =
+        axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+    if (length_squared < FLT_MIN) {
+        // a flat block
+        copy(mean, mean + 3, e0);
+        copy(mean, mean + 3, e1);
+        return;
+    }
+
+    float t_lo = FLT_MAX;
+    float t_hi = -FLT_MAX;
+    for (uint32_t i = 0; i < 16; i++) {
+        float t = 0.0f;
+        for (uint32_t c = 0; c < 3; c++) {
+            t += (block.channels[c][i] - mean[c]) * axis[c];
+        }
+        t_lo = min(t_lo, t);
+        t_hi = max(t_hi, t);
+    }
+
+    for (uint32_t c = 0; c < 3; c++) {
+        e0[c] = mean[c] + axis[c] * t_hi / length_squared;
+        e1[c] = mean[c] + axis[c] * t_lo / length_squared;
+    }
+}
+
+// BC1 color
+
+uint16_t Pack565(const float color[3]) {
+    auto quantize = [](float v, float levels) {
+        return static_cast<uint32_t>(
+            min(max(v, 0.0f), 255.0f) * levels / 255.0f + 0.5f);
+    };
+    return static_cast<uint16_t>((quantize(color[0], 31.0f) << 11) |
+                                 (quantize(color[1], 63.0f) << 5) |
+                                 quantize(color[2], 31.0f));
+}
+
+// the colors a block decodes to, as 8 bit RGBA
+void BuildColorPalette(uint16_t c0, uint16_t c1, bool four_colors,
+                       uint8_t palette[4][4]) {
+    for (uint32_t i = 0; i < 2; i++) {
+        uint16_t c = i ? c1 : c0;
+        uint32_t r = (c >> 11) & 0x1F;
+        uint32_t g = (c >> 5) & 0x3F;
+        uint32_t b = c & 0x1F;
+        palette[i][0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+        palette[i][1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+        palette[i][2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+        palette[i][3] = 0xFF;
+    }
+
+    for (uint32_t c = 0; c < 3; c++) {
+        uint32_t a = palette[0][c];
+        uint32_t b = palette[1][c];
+        if (four_colors) {
+            palette[2][c] = static_cast<uint8_t>((2 * a + b) / 3);
+            palette[3][c] = static_cast<uint8_t>((a + 2 * b) / 3);
+        } else {
+            palette[2][c] = static_cast<uint8_t>((a + b) / 2);
+            palette[3][c] = 0;
+        }
+    }
+    palette[2][3] = 0xFF;
+    palette[3][3] = four_colors ? 0xFF : 0;
+}
+
+float FitColor(const Block& block, uint16_t c0, uint16_t c1,
+               uint8_t indices[16]) {
+    uint8_t colors[4][4];
+    BuildColorPalette(c0, c1, true, colors);
+
+    float palette[3][16];
+    for (uint32_t k = 0; k < 4; k++) {
+        for (uint32_t c = 0; c < 3; c++) palette[c][k] = colors[k][c];
+    }
+    return FitIndices(block, 0, 3, palette, 4, indices);
+}
+
+// least squares endpoints for the chosen indices, weights holds how much
+// of e0 each index takes
+bool RefitEndpoints(const Block& block, const uint8_t indices[16],
+                    const float* weights, float e0[3], float e1[3]) {
+    float aa = 0.0f;
+    float ab = 0.0f;
+    float bb = 0.0f;
+    float ax[3] = {0.0f, 0.0f, 0.0f};
+    float bx[3] = {0.0f, 0.0f, 0.0f};
+    for (uint32_t i = 0; i < 16; i++) {
+        float a = weights[indices[i]];
+        float b = 1.0f - a;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (uint32_t c = 0; c < 3; c++) {
+            ax[c] += a * block.channels[c][i];
+            bx[c] += b * block.channels[c][i];
+        }
+    }
+
+    float determinant = aa * bb - ab * ab;
+    if (fabs(determinant) < 1e-6f) return false;
+
+    for (uint32_t c = 0; c < 3; c++) {
+        e0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+        e1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+    }
+    return true;
+}
+
+void EncodeColorBlock(const Block& block, uint8_t* out) {
+    static const float kColorWeights[4] = {1.0f, 0.0f, 2.0f / 3.0f,
+                                           1.0f / 3.0f};
+
+    float e0[3];
+    float e1[3];
+    PrincipalEndpoints(block, e0, e1);
+    uint16_t c0 = Pack565(e0);
+    uint16_t c1 = Pack565(e1);
+    uint8_t indices[16];
+    float error = FitColor(block, c0, c1, indices);
+
+    // one more pass with the endpoints fit to the indices chosen
+    if (RefitEndpoints(block, indices, kColorWeights, e0, e1)) {
+        uint16_t refit0 = Pack565(e0);
+        uint16_t refit1 = Pack565(e1);
+        uint8_t refit_indices[16];
+        if (FitColor(block, refit0, refit1, refit_indices) < error) {
+            c0 = refit0;
+            c1 = refit1;
+            copy(refit_indices, refit_indices + 16, indices);
+        }
+    }
+
+    // c0 > c1 selects four colors in BC1, equal ends leave one color
+    if (c0 < c1) {
+        swap(c0, c1);
+        for (auto& index : indices) index ^= 1;
+    } else if (c0 == c1) {
+        fill(indices, indices + 16, 0);
+    }
+
+    uint32_t bits = 0;
+    for (uint32_t i = 0; i < 16; i++) bits |= uint32_t(indices[i]) << (2 * i);
+
+    out[0] = c0 & 0xFF;
+    out[1] = c0 >> 8;
+    out[2] = c1 & 0xFF;
+    out[3] = c1 >> 8;
+    for (uint32_t i = 0; i < 4; i++) out[4 + i] = (bits >> (8 * i)) & 0xFF;
+}
+
+void DecodeColorBlock(const uint8_t* in, bool always_four_colors,
+                      uint8_t out[16][4]) {
+    uint16_t c0 = static_cast<uint16_t>(in[0] | (in[1] << 8));
+    uint16_t c1 = static_cast<uint16_t>(in[2] | (in[3] << 8));
+    uint8_t palette[4][4];
+    BuildColorPalette(c0, c1, always_four_colors || c0 > c1, palette);
+
+    uint32_t bits =
+        in[4] | (in[5] << 8) | (in[6] << 16) | (uint32_t(in[7]) << 24);
+    for (uint32_t i = 0; i < 16; i++) {
+        memcpy(out[i], palette[(bits >> (2 * i)) & 3], 4);
+    }
+}
+
+// BC4 channel
+
+void BuildAlphaPalette(uint8_t a0, uint8_t a1, uint8_t palette[8]) {
+    palette[0] = a0;
+    palette[1] = a1;
+    if (a0 > a1) {
+        for (uint32_t i = 2; i < 8; i++) {
+            palette[i] = static_cast<uint8_t>(
+                ((8 - i) * a0 + (i - 1) * a1 + 3) / 7);
+        }
+    } else {
+        for (uint32_t i = 2; i < 6; i++) {
+            palette[i] = static_cast<uint8_t>(
+                ((6 - i) * a0 + (i - 1) * a1 + 2) / 5);
+        }
+        palette[6] = 0;
+        palette[7] = 0xFF;
+    }
+}
+
+void EncodeAlphaBlock(const Block& block, uint32_t channel, uint8_t* out) {
+    float lo = 255.0f;
+    float hi = 0.0f;
+    for (float v : block.channels[channel]) {
+        lo = min(lo, v);
+        hi = max(hi, v);
+    }
+
+    auto a0 = static_cast<uint8_t>(min(max(hi, 0.0f), 255.0f) + 0.5f);
+    auto a1 = static_cast<uint8_t>(min(max(lo, 0.0f), 255.0f) + 0.5f);
+
+    uint8_t indices[16] = {};
+    if (a0 > a1) {
+        uint8_t levels[8];
+        BuildAlphaPalette(a0, a1, levels);
+        float palette[1][16];
+        for (uint32_t k = 0; k < 8; k++) palette[0][k] = levels[k];
+        FitIndices(block, channel, 1, palette, 8, indices);
+    }
+
+    uint64_t bits = 0;
+    for (uint32_t i = 0; i < 16; i++) {
+        bits |= uint64_t(indices[i]) << (3 * i);
+    }
+
+    out[0] = a0;
+    out[1] = a1;
+    for (uint32_t i = 0; i < 6; i++) out[2 + i] = (bits >> (8 * i)) & 0xFF;
+}
+
+void DecodeAlphaBlock(const uint8_t* in, uint8_t out[16]) {
+    uint8_t palette[8];
+    BuildAlphaPalette(in[0], in[1], palette);
+
+    uint64_t bits = 0;
+    for (uint32_t i = 0; i < 6; i++) bits |= uint64_t(in[2 + i]) << (8 * i);
+    for (uint32_t i = 0; i < 16; i++) out[i] = palette[(bits >> (3 * i)) & 7];
+}
+
+// BC6H, the single region mode 11 with 10 bit endpoints and 4 bit indices.
+// endpoints are kept as half float bits, which the format interpolates.
+
+const uint32_t kBC6HMode11 = 0x03;
+const int32_t kBC6HWeights[16] = {0,  4,  9,  13, 17, 21, 26, 30,
+                                  34, 38, 43, 47, 51, 55, 60, 64};
+const float kMaxHalf = 0x7BFF;
+
+uint16_t FloatToHalf(float f) {
+    // unsigned, negatives and NaN are black
+    if (!(f > 0.0f)) return 0;
+    if (f >= 65504.0f) return 0x7BFF;
+
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (exponent <= 0) {
+        if (exponent < -10) return 0;
+        mantissa |= 0x800000;
+        uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1) half++;
+        return static_cast<uint16_t>(half);
+    }
+
+    uint32_t half = (uint32_t(exponent) << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000) half++;
+    return static_cast<uint16_t>(min(half, 0x7BFFu));
+}
+
+float HalfToFloat(uint16_t half) {
+    int32_t exponent = (half >> 10) & 0x1F;
+    int32_t mantissa = half & 0x3FF;
+    if (exponent == 0) return ldexpf(static_cast<float>(mantissa), -24);
+    if (exponent == 31) return mantissa ? NAN : INFINITY;
+    return ldexpf(static_cast<float>(mantissa | 0x400), exponent - 25);
+}
+
+int32_t UnquantizeBC6H(int32_t q) {
+    if (q == 0) return 0;
+    if (q == 0x3FF) return 0xFFFF;
+    return ((q << 16) + 0x8000) >> 10;
+}
+
+// interpolated between the unquantized ends, as half float bits
+uint16_t InterpolateBC6H(int32_t a, int32_t b, int32_t weight) {
+    int32_t v = (a * (64 - weight) + b * weight + 32) >> 6;
+    return static_cast<uint16_t>((v * 31) >> 6);
+}
+
+int32_t QuantizeBC6H(float half) {
+    auto q = static_cast<int32_t>(half / 31.0f + 0.5f);
+    int32_t best = 0;
+    float best_error = FLT_MAX;
+    for (int32_t c = max(q - 1, 0); c <= min(q + 1, 0x3FF); c++) {
+        float error = fabs(InterpolateBC6H(UnquantizeBC6H(c), 0, 0) - half);
+        if (error < best_error) {
+            best = c;
+            best_error = error;
+        }
+    }
+    return best;
+}
+
+// the 128 bits of a block, least significant first
+class BlockBits {
+   public:
+    BlockBits() = default;
+    explicit BlockBits(const uint8_t* in) { memcpy(m_Bytes, in, 16); }
+
+    void Put(uint32_t value, uint32_t count) {
+        for (uint32_t i = 0; i < count; i++, m_Position++) {
+            if ((value >> i) & 1) {
+                m_Bytes[m_Position >> 3] |= 1 << (m_Position & 7);
+            }
+        }
+    }
+
+    uint32_t Get(uint32_t count) {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < count; i++, m_Position++) {
+            value |= ((m_Bytes[m_Position >> 3] >> (m_Position & 7)) & 1u)
+                     << i;
+        }
+        return value;
+    }
+
+    [[nodiscard]] const uint8_t* GetBytes() const { return m_Bytes; }
+
+   private:
+    uint8_t m_Bytes[16] = {};
+    uint32_t m_Position{0};
+};
+
+// the block channels hold half float bits
+void EncodeHdrBlock(const Block& block, uint8_t* out) {
+    float e0[3];
+    float e1[3];
+    PrincipalEndpoints(block, e0, e1);
+
+    int32_t q0[3];
+    int32_t q1[3];
+    float palette[3][16];
+    for (uint32_t c = 0; c < 3; c++) {
+        q0[c] = QuantizeBC6H(min(max(e0[c], 0.0f), kMaxHalf));
+        q1[c] = QuantizeBC6H(min(max(e1[c], 0.0f), kMaxHalf));
+        for (uint32_t k = 0; k < 16; k++) {
+            palette[c][k] = InterpolateBC6H(UnquantizeBC6H(q0[c]),
+                                            UnquantizeBC6H(q1[c]),
+                                            kBC6HWeights[k]);
+        }
+    }
+
+    uint8_t indices[16];
+    FitIndices(block, 0, 3, palette, 16, indices);
+
+    // the first index is stored without its top bit, which must be clear.
+    // the weights are symmetric, swapped ends give the same palette
+    // backwards.
+    if (indices[0] & 8) {
+        swap(q0, q1);
+        for (auto& index : indices) index = 15 - index;
+    }
+
+    BlockBits bits;
+    bits.Put(kBC6HMode11, 5);
+    for (int32_t q : q0) bits.Put(q, 10);
+    for (int32_t q : q1) bits.Put(q, 10);
+    bits.Put(indices[0], 3);
+    for (uint32_t i = 1; i < 16; i++) bits.Put(indices[i], 4);
+    memcpy(out, bits.GetBytes(), 16);
+}
+
+void DecodeHdrBlock(const uint8_t* in, float out[16][4]) {
+    BlockBits bits(in);
+    if (bits.Get(5) != kBC6HMode11) {
+        for (uint32_t i = 0; i < 16; i++) {
+            out[i][0] = out[i][1] = out[i][2] = 0.0f;
+            out[i][3] = 1.0f;
+        }
+        return;
+    }
+
+    int32_t ends[2][3];
+    for (auto& end : ends) {
+        for (auto& q : end) {
+            q = UnquantizeBC6H(static_cast<int32_t>(bits.Get(10)));
+        }
+    }
+
+    for (uint32_t i = 0; i < 16; i++) {
+        uint32_t index = bits.Get(i ? 4 : 3);
+        for (uint32_t c = 0; c < 3; c++) {
+            out[i][c] = HalfToFloat(InterpolateBC6H(ends[0][c], ends[1][c],
+                                                    kBC6HWeights[index]));
+        }
+        out[i][3] = 1.0f;
+    }
+}
+
+// pixels past the right or bottom edge repeat the last column or row
+void LoadBlock(const Image& image, const Image::Mipmap& level, uint32_t bx,
+               uint32_t by, Block& block) {
+    const uint8_t* data = image.data + level.offset;
+    for (uint32_t i = 0; i < 16; i++) {
+        uint32_t x = min(bx * 4 + (i & 3), level.Width - 1);
+        uint32_t y = min(by * 4 + (i >> 2), level.Height - 1);
+        if (image.is_float) {
+            uint32_t floats = image.bitcount / 32;
+            const auto* pixel = reinterpret_cast<const float*>(
+                                    data + level.pitch * y) +
+                                x * floats;
+            for (uint32_t c = 0; c < 3; c++) {
+                block.channels[c][i] = FloatToHalf(pixel[c]);
+            }
+            block.channels[3][i] = 0.0f;
+        } else {
+            const uint8_t* pixel = data + level.pitch * y + x * 4;
+            for (uint32_t c = 0; c < 4; c++) block.channels[c][i] = pixel[c];
+        }
+    }
+}
+
+void EncodeBlock(BlockFormat format, const Block& block, uint8_t* out) {
+    switch (format) {
+        case BlockFormat::kBC1:
+            EncodeColorBlock(block, out);
+            break;
+        case BlockFormat::kBC3:
+            EncodeAlphaBlock(block, 3, out);
+            EncodeColorBlock(block, out + 8);
+            break;
+        case BlockFormat::kBC4:
+            EncodeAlphaBlock(block, 0, out);
+            break;
+        case BlockFormat::kBC5:
+            EncodeAlphaBlock(block, 0, out);
+            EncodeAlphaBlock(block, 1, out + 8);
+            break;
+        case BlockFormat::kBC6H:
+            EncodeHdrBlock(block, out);
+            break;
+    }
+}
+
+// writes the decoded block at bx, by, leaving out what is past the edges
+void DecodeBlock(BlockFormat format, const uint8_t* in, Image& image,
+                 const Image::Mipmap& level, uint32_t bx, uint32_t by) {
+    uint8_t pixels[16][4];
+    float hdr_pixels[16][4];
+    switch (format) {
+        case BlockFormat::kBC1:
+            DecodeColorBlock(in, false, pixels);
+            break;
+        case BlockFormat::kBC3: {
+            uint8_t alpha[16];
+            DecodeAlphaBlock(in, alpha);
+            DecodeColorBlock(in + 8, true, pixels);
+            for (uint32_t i = 0; i < 16; i++) pixels[i][3] = alpha[i];
+        } break;
+        case BlockFormat::kBC4:
+        case BlockFormat::kBC5: {
+            uint8_t red[16];
+            uint8_t green[16] = {};
+            DecodeAlphaBlock(in, red);
+            if (format == BlockFormat::kBC5) DecodeAlphaBlock(in + 8, green);
+            for (uint32_t i = 0; i < 16; i++) {
+                pixels[i][0] = red[i];
+                pixels[i][1] = green[i];
+                pixels[i][2] = 0;
+                pixels[i][3] = 0xFF;
+            }
+        } break;
+        case BlockFormat::kBC6H:
+            DecodeHdrBlock(in, hdr_pixels);
+            break;
+    }
+
+    uint8_t* data = image.data + level.offset;
+    for (uint32_t i = 0; i < 16; i++) {
+        uint32_t x = bx * 4 + (i & 3);
+        uint32_t y = by * 4 + (i >> 2);
+        if (x >= level.Width || y >= level.Height) continue;
+
+        uint8_t* pixel = data + level.pitch * y + x * (image.bitcount >> 3);
+        if (format == BlockFormat::kBC6H) {
+            memcpy(pixel, hdr_pixels[i], sizeof(hdr_pixels[i]));
+        } else {
+            memcpy(pixel, pixels[i], sizeof(pixels[i]));
+        }
+    }
+}
+
+bool GetBlockFormat(uint32_t compress_format, BlockFormat& format) {
+    switch (compress_format) {
+        case "DXT1"_u32:
+            format = BlockFormat::kBC1;
+            return true;
+        case "DXT5"_u32:
+            format = BlockFormat::kBC3;
+            return true;
+        case "ATI1"_u32:
+            format = BlockFormat::kBC4;
+            return true;
+        case "ATI2"_u32:
+            format = BlockFormat::kBC5;
+            return true;
+        case "BC6H"_u32:
+            format = BlockFormat::kBC6H;
+            return true;
+        default:
+            return false;
+    }
+}
+
+uint32_t CountBlocks(uint32_t pixels) { return max(1u, (pixels + 3) / 4); }
+}  // namespace
+
+namespace My {
+uint32_t GetCompressFormat(BlockFormat format) {
+    switch (format) {
+        case BlockFormat::kBC1:
+            return "DXT1"_u32;
+        case BlockFormat::kBC3:
+            return "DXT5"_u32;
+        case BlockFormat::kBC4:
+            return "ATI1"_u32;
+        case BlockFormat::kBC5:
+            return "ATI2"_u32;
+        case BlockFormat::kBC6H:
+            return "BC6H"_u32;
+    }
+    return 0;
+}
+
+Image CompressImage(const Image& image, BlockFormat format) {
+    Image result;
+    if (image.compressed || !image.data) return result;
+
+    if (format == BlockFormat::kBC6H) {
+        if (!image.is_float ||
+            (image.bitcount != 96 && image.bitcount != 128)) {
+            return result;
+        }
+    } else if (image.is_float || image.bitcount != 32) {
+        return result;
+    }
+
+    // the levels of the source, or its only one
+    vector<Image::Mipmap> levels = image.mipmaps;
+    if (levels.empty()) {
+        levels.emplace_back(image.Width, image.Height, image.pitch, 0,
+                            image.pitch * image.Height);
+    }
+
+    const size_t block_bytes = GetBlockBytes(format);
+    for (const auto& level : levels) {
+        size_t pitch = CountBlocks(level.Width) * block_bytes;
+        size_t size = pitch * CountBlocks(level.Height);
+        result.mipmaps.emplace_back(level.Width, level.Height, pitch,
+                                    result.data_size, size);
+        result.data_size += size;
+    }
+
+    result.Width = image.Width;
+    result.Height = image.Height;
+    result.compressed = true;
+    result.is_float = (format == BlockFormat::kBC6H);
+    result.compress_format = GetCompressFormat(format);
+    result.bitcount = (block_bytes == 8) ? 4 : 8;
+    result.pitch = result.mipmaps[0].pitch;
+    result.data = new uint8_t[result.data_size];
+
+    for (size_t i = 0; i < levels.size(); i++) {
+        const auto& level = levels[i];
+        const auto& mip = result.mipmaps[i];
+        uint32_t blocks_x = CountBlocks(level.Width);
+        WorkerPool::GetDecodePool().ParallelFor(
+            CountBlocks(level.Height), [&](size_t by) {
+                uint8_t* out = result.data + mip.offset + mip.pitch * by;
+                for (uint32_t bx = 0; bx < blocks_x; bx++) {
+                    Block block;
+                    LoadBlock(image, level, bx, static_cast<uint32_t>(by),
+                              block);
+                    EncodeBlock(format, block, out + bx * block_bytes);
+                }
+            });
+    }
+
+    return result;
+}
+
+Image DecompressImage(const Image& image) {
+    Image result;
+    BlockFormat format;
+    if (!image.compressed || !image.data ||
+        !GetBlockFormat(image.compress_format, format)) {
+        return result;
+    }
+
+    result.Width = image.Width;
+    result.Height = image.Height;
+    result.is_float = (format == BlockFormat::kBC6H);
+    result.bitcount = result.is_float ? 128 : 32;
+    const size_t pixel_size = result.bitcount >> 3;
+    for (const auto& level : image.mipmaps) {
+        size_t pitch = level.Width * pixel_size;
+        result.mipmaps.emplace_back(level.Width, level.Height, pitch,
+                                    result.data_size, pitch * level.Height);
+        result.data_size += pitch * level.Height;
+    }
+    if (result.mipmaps.empty()) return Image();
+
+    result.pitch = result.mipmaps[0].pitch;
+    result.data = new uint8_t[result.data_size];
+
+    const size_t block_bytes = GetBlockBytes(format);
+    for (size_t i = 0; i < image.mipmaps.size(); i++) {
+        const auto& level = image.mipmaps[i];
+        const auto& mip = result.mipmaps[i];
+        uint32_t blocks_x = CountBlocks(level.Width);
+        WorkerPool::GetDecodePool().ParallelFor(
+            CountBlocks(level.Height), [&](size_t by) {
+                const uint8_t* in =
+                    image.data + level.offset + level.pitch * by;
+                for (uint32_t bx = 0; bx < blocks_x; bx++) {
+                    DecodeBlock(format, in + bx * block_bytes, result, mip,
+                                bx, static_cast<uint32_t>(by));
+                }
+            });
+    }
+
+    return result;
+}
+}  // namespace My
@@ -0,0 +1,32 @@
+#pragma once
+#include "Image.hpp"
+
+namespace My {
+// block compressed formats, every 4x4 block of pixels in 8 or 16 bytes
+enum class BlockFormat {
+    // RGB in 4 bits a pixel, for opaque color
+    kBC1,
+    // BC1 color and BC4 alpha in 8 bits a pixel, for color with alpha
+    kBC3,
+    // one channel in 4 bits a pixel, for roughness, metallic and ao maps
+    kBC4,
+    // two BC4 channels in 8 bits a pixel, for the x and y of normal maps
+    kBC5,
+    // unsigned half float RGB in 8 bits a pixel, for .hdr images
+    kBC6H,
+};
+
+// the compress_format of images in the format, as DdsParser sets it
+uint32_t GetCompressFormat(BlockFormat format);
+
+// encodes an uncompressed image with all of its mips. BC1 to BC5 take
+// 32 bit RGBA, BC6H takes 96 or 128 bit float RGB(A). rows of blocks are
+// spread over the decode pool. any other image gives an empty image.
+Image CompressImage(const Image& image, BlockFormat format);
+
+// decodes BC1 to BC5 into 32 bit RGBA and BC6H into 128 bit float RGBA,
+// mips included. BC6H blocks are decoded in the single region mode the
+// encoder writes, blocks in the other modes come out black. any other
+// image gives an empty image.
+Image DecompressImage(const Image& image);
+}  // namespace My
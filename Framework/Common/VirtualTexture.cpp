@@ -0,0 +1,228 @@
+#include "VirtualTexture.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace My;
+using namespace std;
+
+VirtualTexture::VirtualTexture(uint32_t width, uint32_t height,
+                               const VirtualTextureSettings& settings)
+    : m_nWidth(width),
+      m_nHeight(height),
+      m_Settings(settings),
+      m_Pages(static_cast<size_t>(width) * height),
+      m_PageTable(static_cast<size_t>(width) * height, kNotResident),
+      m_Slots(static_cast<size_t>(settings.cacheWidth) *
+              settings.cacheHeight) {}
+
+void VirtualTexture::SetPageName(uint32_t x, uint32_t y,
+                                 const std::string& name) {
+    assert(x < m_nWidth && y < m_nHeight);
+    m_Pages[static_cast<size_t>(y) * m_nWidth + x].texture.SetName(name);
+}
+
+void VirtualTexture::Feedback(float x, float y, float radius) {
+    m_nFrame++;
+
+    struct Need {
+        float distance;
+        uint32_t page;
+    };
+
+    // the pages overlapping the circle, those whose centers are in it kept
+    vector<Need> needs;
+    auto first_x = static_cast<int32_t>(max(0.0f, x - radius - 0.5f));
+    auto first_y = static_cast<int32_t>(max(0.0f, y - radius - 0.5f));
+    auto last_x = min(static_cast<int32_t>(x + radius + 0.5f),
+                      static_cast<int32_t>(m_nWidth) - 1);
+    auto last_y = min(static_cast<int32_t>(y + radius + 0.5f),
+                      static_cast<int32_t>(m_nHeight) - 1);
+    for (int32_t py = first_y; py <= last_y; py++) {
+        for (int32_t px = first_x; px <= last_x; px++) {
+            float dx = px + 0.5f - x;
+            float dy = py + 0.5f - y;
+            float distance = dx * dx + dy * dy;
+            if (distance <= radius * radius) {
+                needs.push_back(
+                    {distance, static_cast<uint32_t>(py) * m_nWidth +
+                                   static_cast<uint32_t>(px)});
+            }
+        }
+    }
+
+    // no more than the cache holds, the farthest are left out
+    sort(needs.begin(), needs.end(), [](const Need& a, const Need& b) {
+        return a.distance < b.distance;
+    });
+    if (needs.size() > m_Slots.size()) needs.resize(m_Slots.size());
+
+    for (const auto& need : needs) {
+        auto& page = m_Pages[need.page];
+        page.lastNeeded = m_nFrame;
+        page.distance = need.distance;
+
+        int32_t slot = m_PageTable[need.page];
+        if (slot != kNotResident) {
+            m_Slots[slot].lastNeeded = m_nFrame;
+        } else if (!page.pending) {
+            page.texture.RequestImage();
+            page.pending = true;
+            m_Pending.push_back(need.page);
+        }
+    }
+
+    // pages no longer needed stop waiting, the nearest are filled first
+    m_Pending.erase(remove_if(m_Pending.begin(), m_Pending.end(),
+                              [this](uint32_t page) {
+                                  if (m_Pages[page].lastNeeded == m_nFrame) {
+                                      return false;
+                                  }
+                                  m_Pages[page].pending = false;
+                                  return true;
+                              }),
+                    m_Pending.end());
+    sort(m_Pending.begin(), m_Pending.end(), [this](uint32_t a, uint32_t b) {
+        return m_Pages[a].distance < m_Pages[b].distance;
+    });
+}
+
+bool VirtualTexture::Update() {
+    bool filled = false;
+    uint32_t fills = 0;
+
+    for (auto it = m_Pending.begin();
+         it != m_Pending.end() && fills < m_Settings.fillsPerFrame;) {
+        auto& page = m_Pages[*it];
+
+        // loaded in the background, nothing waits for it here
+        auto image = page.texture.TryGetTextureImage();
+        if (!image) {
+            ++it;
+            continue;
+        }
+
+        // every slot holds a page of this frame, the rest wait for one
+        // to be let go
+        if (FindSlot() < 0) break;
+
+        if (Fill(*it, *image)) {
+            filled = true;
+            fills++;
+        }
+
+        // the cache holds a copy now, or never will
+        page.texture.MarkUploaded();
+        page.pending = false;
+        it = m_Pending.erase(it);
+    }
+
+    return filled;
+}
+
+std::vector<uint32_t> VirtualTexture::TakeDirtySlots() {
+    vector<uint32_t> slots;
+    slots.swap(m_DirtySlots);
+    return slots;
+}
+
+size_t VirtualTexture::GetResidentPageCount() const {
+    return count_if(m_Slots.begin(), m_Slots.end(),
+                    [](const Slot& slot) { return slot.page >= 0; });
+}
+
+bool VirtualTexture::AllocateCache(const Image& image) {
+    if (image.compressed || !image.bitcount || image.bitcount % 8) {
+        return false;
+    }
+
+    m_Cache.Width = m_Settings.cacheWidth * m_Settings.pageSize;
+    m_Cache.Height = m_Settings.cacheHeight * m_Settings.pageSize;
+    m_Cache.bitcount = image.bitcount;
+    m_Cache.is_float = image.is_float;
+    m_Cache.pitch = static_cast<size_t>(m_Cache.Width) * (image.bitcount >> 3);
+    m_Cache.data_size = m_Cache.pitch * m_Cache.Height;
+    m_Cache.AdoptData(new uint8_t[m_Cache.data_size]());
+    m_Cache.mipmaps.clear();
+    m_Cache.mipmaps.emplace_back(m_Cache.Width, m_Cache.Height, m_Cache.pitch,
+                                 0, m_Cache.data_size);
+
+    return true;
+}
+
+int32_t VirtualTexture::FindSlot() const {
+    int32_t slot = -1;
+    for (size_t i = 0; i < m_Slots.size(); i++) {
+        if (m_Slots[i].page < 0) {
+            return static_cast<int32_t>(i);
+        }
+        if (m_Slots[i].lastNeeded < m_nFrame &&
+            (slot < 0 || m_Slots[i].lastNeeded < m_Slots[slot].lastNeeded)) {
+            slot = static_cast<int32_t>(i);
+        }
+    }
+
+    return slot;
+}
+
+bool VirtualTexture::Fill(uint32_t page, const Image& image) {
+    if (!image.data || image.compressed) return false;
+    if (!m_Cache.data && !AllocateCache(image)) return false;
+    if (image.bitcount != m_Cache.bitcount ||
+        image.is_float != m_Cache.is_float) {
+        cerr << "Virtual texture page " << page
+             << " differs in format from the others" << endl;
+        return false;
+    }
+
+    int32_t slot = FindSlot();
+    if (slot < 0) return false;
+
+    auto& target = m_Slots[slot];
+    if (target.page >= 0) m_PageTable[target.page] = kNotResident;
+
+    // the finest level that fits the page
+    Image::Mipmap level(image.Width, image.Height, image.pitch, 0,
+                        image.data_size);
+    for (const auto& mip : image.mipmaps) {
+        level = mip;
+        if (mip.Width <= m_Settings.pageSize &&
+            mip.Height <= m_Settings.pageSize) {
+            break;
+        }
+    }
+
+    const uint32_t size = m_Settings.pageSize;
+    const size_t pixel_size = m_Cache.bitcount >> 3;
+    uint8_t* origin =
+        m_Cache.data +
+        static_cast<size_t>(slot / m_Settings.cacheWidth) * size *
+            m_Cache.pitch +
+        static_cast<size_t>(slot % m_Settings.cacheWidth) * size * pixel_size;
+    for (uint32_t y = 0; y < size; y++) {
+        const uint8_t* src = image.data + level.offset +
+                             level.pitch * (static_cast<size_t>(y) *
+                                            level.Height / size);
+        uint8_t* dst = origin + m_Cache.pitch * y;
+        if (level.Width == size) {
+            memcpy(dst, src, size * pixel_size);
+            continue;
+        }
+
+        // nearest, pages are rarely of another size
+        for (uint32_t x = 0; x < size; x++) {
+            memcpy(dst + x * pixel_size,
+                   src + static_cast<size_t>(x) * level.Width / size *
+                             pixel_size,
+                   pixel_size);
+        }
+    }
+
+    target.page = static_cast<int32_t>(page);
+    target.lastNeeded = m_Pages[page].lastNeeded;
+    m_PageTable[page] = slot;
+    m_DirtySlots.push_back(static_cast<uint32_t>(slot));
+    m_bPageTableDirty = true;
+
+    return true;
+}
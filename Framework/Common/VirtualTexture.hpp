@@ -0,0 +1,103 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "Image.hpp"
+#include "SceneObjectTexture.hpp"
+
+namespace My {
+struct VirtualTextureSettings {
+    // pixels across a page in the cache, pages of another size are
+    // resampled to it from their closest mip
+    uint32_t pageSize{256};
+    // pages across and down the physical cache
+    uint32_t cacheWidth{8};
+    uint32_t cacheHeight{8};
+    // pages copied into the cache by one Update, the others wait
+    uint32_t fillsPerFrame{4};
+};
+
+// one large logical texture made of pages, each page an image of its own.
+// only the pages the camera needs are kept, in a physical cache of fixed
+// size, so memory follows the view distance instead of the size of the
+// world. the page table tells where in the cache each page is.
+//
+// every frame Feedback decides which pages are needed and starts loading
+// those missing, on the asset loader and decode pool threads. Update then
+// copies the pages done loading into the cache, over the least recently
+// needed ones once it is full.
+class VirtualTexture {
+   public:
+    // page table entries of pages not in the cache
+    static constexpr int32_t kNotResident = -1;
+
+    VirtualTexture(uint32_t width, uint32_t height,
+                   const VirtualTextureSettings& settings = {});
+
+    // the image of page (x, y)
+    void SetPageName(uint32_t x, uint32_t y, const std::string& name);
+
+    // the pages whose centers lie within radius pages of (x, y), in page
+    // units, nearest first, as many as the cache holds
+    void Feedback(float x, float y, float radius);
+    // copies the pages done loading into the cache, true if any was
+    bool Update();
+
+    [[nodiscard]] uint32_t GetWidth() const { return m_nWidth; }
+    [[nodiscard]] uint32_t GetHeight() const { return m_nHeight; }
+    [[nodiscard]] const VirtualTextureSettings& GetSettings() const {
+        return m_Settings;
+    }
+
+    // the cache slot of every page, row by row, or kNotResident
+    [[nodiscard]] const std::vector<int32_t>& GetPageTable() const {
+        return m_PageTable;
+    }
+    // the physical cache, slot s at pixel (s % cacheWidth, s / cacheWidth)
+    // times the page size. empty until the first page is filled, its
+    // format is that of the first page.
+    [[nodiscard]] const Image& GetCache() const { return m_Cache; }
+    // the slots filled since the last call, and if the page table changed
+    std::vector<uint32_t> TakeDirtySlots();
+    [[nodiscard]] bool IsPageTableDirty() const { return m_bPageTableDirty; }
+    void ClearPageTableDirty() { m_bPageTableDirty = false; }
+
+    [[nodiscard]] size_t GetResidentPageCount() const;
+
+   private:
+    struct Page {
+        SceneObjectTexture texture;
+        // the frame it was last needed in, and how far it was then
+        uint64_t lastNeeded{0};
+        float distance{0.0f};
+        bool pending{false};
+    };
+
+    struct Slot {
+        int32_t page{-1};
+        uint64_t lastNeeded{0};
+    };
+
+    // a free slot, or else the one needed least recently, though not by
+    // this frame. -1 if every slot holds a page of this frame.
+    [[nodiscard]] int32_t FindSlot() const;
+    // copies an image into the slot FindSlot picks
+    bool Fill(uint32_t page, const Image& image);
+    bool AllocateCache(const Image& image);
+
+    uint32_t m_nWidth;
+    uint32_t m_nHeight;
+    VirtualTextureSettings m_Settings;
+
+    std::vector<Page> m_Pages;
+    std::vector<int32_t> m_PageTable;
+    std::vector<Slot> m_Slots;
+    // the pages loading, nearest first
+    std::vector<uint32_t> m_Pending;
+    std::vector<uint32_t> m_DirtySlots;
+    bool m_bPageTableDirty{false};
+
+    Image m_Cache;
+    uint64_t m_nFrame{0};
+};
+}  // namespace My
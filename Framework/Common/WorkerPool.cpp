@@ -0,0 +1,104 @@
+#include "WorkerPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+using namespace My;
+using namespace std;
+
+WorkerPool::WorkerPool(size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = max(1u, thread::hardware_concurrency());
+    }
+
+    m_Threads.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        m_Threads.emplace_back(&WorkerPool::ThreadMain, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        lock_guard<mutex> lock(m_Mutex);
+        m_bStopping = true;
+    }
+    m_Condition.notify_all();
+
+    for (auto& thread : m_Threads) {
+        thread.join();
+    }
+}
+
+WorkerPool& WorkerPool::GetDecodePool() {
+    static WorkerPool s_DecodePool;
+    return s_DecodePool;
+}
+
+void WorkerPool::ParallelFor(size_t count,
+                             const function<void(size_t)>& body) {
+    if (count == 0) return;
+
+    // helpers left in the queue after the work is done find nothing to
+    // take and only touch this, which they share
+    struct Loop {
+        const function<void(size_t)>* body;
+        size_t count;
+        atomic<size_t> next{0};
+        atomic<size_t> done{0};
+        mutex doneMutex;
+        condition_variable doneCondition;
+    };
+
+    auto loop = make_shared<Loop>();
+    loop->body = &body;
+    loop->count = count;
+
+    auto run = [loop]() {
+        size_t i;
+        while ((i = loop->next.fetch_add(1)) < loop->count) {
+            (*loop->body)(i);
+            if (loop->done.fetch_add(1) + 1 == loop->count) {
+                lock_guard<mutex> lock(loop->doneMutex);
+                loop->doneCondition.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = min(count, m_Threads.size() + 1) - 1;
+    for (size_t i = 0; i < helpers; i++) {
+        Enqueue(run);
+    }
+
+    run();
+
+    unique_lock<mutex> lock(loop->doneMutex);
+    loop->doneCondition.wait(lock,
+                             [&loop]() { return loop->done == loop->count; });
+}
+
+void WorkerPool::Enqueue(function<void()>&& task) {
+    {
+        lock_guard<mutex> lock(m_Mutex);
+        m_Tasks.push_back(std::move(task));
+    }
+    m_Condition.notify_one();
+}
+
+void WorkerPool::ThreadMain() {
+    while (true) {
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(m_Mutex);
+            m_Condition.wait(
+                lock, [this] { return m_bStopping || !m_Tasks.empty(); });
+            // the queue is drained before stopping, no future is left
+            // without a value
+            if (m_Tasks.empty()) return;
+
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop_front();
+        }
+
+        task();
+    }
+}
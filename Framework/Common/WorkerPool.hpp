@@ -0,0 +1,59 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace My {
+// a fixed set of threads running tasks in the order they are submitted.
+// work spread over the pool never runs more threads than the pool owns,
+// however many tasks are queued.
+class WorkerPool {
+   public:
+    // zero threads gives one per hardware thread
+    explicit WorkerPool(size_t threadCount = 0);
+    // runs the tasks still queued, then joins the threads
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    [[nodiscard]] size_t GetThreadCount() const { return m_Threads.size(); }
+
+    // the future is ready once task has run on one of the threads
+    template <typename Task>
+    std::future<std::invoke_result_t<Task>> Submit(Task&& task) {
+        using Result = std::invoke_result_t<Task>;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(
+            std::forward<Task>(task));
+        auto future = packaged->get_future();
+        Enqueue([packaged]() { (*packaged)(); });
+        return future;
+    }
+
+    // runs body(0) .. body(count - 1) spread over the pool and returns when
+    // all have run. the calling thread takes part and never waits on a
+    // queued task, so a task of this pool may call it too. body must not
+    // throw.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    // textures and other assets are decoded here, one thread per core
+    static WorkerPool& GetDecodePool();
+
+   private:
+    void Enqueue(std::function<void()>&& task);
+    void ThreadMain();
+
+    std::mutex m_Mutex;
+    std::condition_variable m_Condition;
+    std::deque<std::function<void()>> m_Tasks;
+    bool m_bStopping{false};
+    std::vector<std::thread> m_Threads;
+};
+}  // namespace My
@@ -73,9 +73,11 @@ int main(int argc, char** argv) {
 #endif
 
 #if !defined(OS_WEBASSEMBLY)
-    // Finalize Runtime Modules
-    for (auto& module : run_time_modules) {
-        module->Finalize();
+    // Finalize Runtime Modules, in reverse order so that the memory manager
+    // outlives its clients
+    for (auto it = run_time_modules.rbegin(); it != run_time_modules.rend();
+         it++) {
+        (*it)->Finalize();
     }
 
     // Finalize App
@@ -12,7 +12,7 @@ _Interface_ IAllocator {
     const uint8_t PATTERN_ALLOC = 0xFD;
     const uint8_t PATTERN_FREE = 0xFE;
 
-    virtual ~IAllocator();
+    virtual ~IAllocator() = default;
 
     virtual void* Allocate(size_t size) = 0;
     virtual void Free(void* p) = 0;
@@ -1,18 +1,64 @@
 #pragma once
 #include <cstddef>
+#include <new>
+#include <ostream>
+#include <utility>
 
 #include "IRuntimeModule.hpp"
+#include "portable.hpp"
 
 namespace My {
+// who owns an allocation, used for accounting and budgets
+ENUM(MemoryTag){kGeneral, kScene,   kTexture, kMesh,
+                kPhysics, kParser,  kDebug,   kFrame,
+                // pages backing the size classes of the memory manager
+                kSmallObjectPool,
+                kCount};
+
+std::ostream& operator<<(std::ostream& out, MemoryTag tag);
+
+struct MemoryStatistics {
+    size_t inUse{0};            ///< bytes currently allocated
+    size_t peak{0};             ///< high water mark of inUse
+    size_t allocationCount{0};  ///< allocations made since start
+    float allocationRate{0.0f};  ///< allocations per second, sampled in Tick
+    size_t budget{0};           ///< warning threshold in bytes, 0 = none
+};
+
 _Interface_ IMemoryManager : _inherits_ IRuntimeModule {
    public:
     int Initialize() override = 0;
     void Finalize() override = 0;
     void Tick() override = 0;
 
-    virtual void* AllocatePage(size_t size) = 0;
+    virtual void* AllocatePage(size_t size,
+                               MemoryTag tag = MemoryTag::kGeneral) = 0;
     virtual void FreePage(void* p) = 0;
+
+    // small-object allocation, served from size classes
+    virtual void* Allocate(size_t size,
+                           MemoryTag tag = MemoryTag::kGeneral) = 0;
+    virtual void Free(void* p, size_t size,
+                      MemoryTag tag = MemoryTag::kGeneral) = 0;
+
+    // accounting
+    [[nodiscard]] virtual MemoryStatistics GetStatistics(MemoryTag tag)
+        const = 0;
+    virtual void SetBudget(MemoryTag tag, size_t bytes) = 0;
+
+    template <class T, MemoryTag tag = MemoryTag::kGeneral,
+              typename... Arguments>
+    T* New(Arguments&&... parameters) {
+        return new (Allocate(sizeof(T), tag))
+            T(std::forward<Arguments>(parameters)...);
+    }
+
+    template <class T, MemoryTag tag = MemoryTag::kGeneral>
+    void Delete(T* p) {
+        p->~T();
+        Free(p, sizeof(T), tag);
+    }
 };
 
 extern IMemoryManager* g_pMemoryManager;
-}  // namespace My
\ No newline at end of file
+}  // namespace My
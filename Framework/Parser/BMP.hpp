@@ -2,6 +2,7 @@
 #include <iostream>
 
 #include "ImageParser.hpp"
+#include "PixelConversion.hpp"
 
 namespace My {
 #pragma pack(push, 1)
@@ -29,6 +30,7 @@ typedef struct _BITMAP_HEADER {
 } BITMAP_HEADER;
 #pragma pack(pop)
 
+// true color bitmaps always come out as 32 bit RGBA
 class BmpParser : _implements_ ImageParser {
    public:
     Image Parse(Buffer& buf) override {
@@ -62,27 +64,26 @@ class BmpParser : _implements_ ImageParser {
             img.data_size = (size_t)img.pitch * img.Height;
             img.data = new uint8_t[img.data_size];
 
-            if (img.bitcount < 24) {
+            if (pBmpHeader->BitCount != 24 && pBmpHeader->BitCount != 32) {
                 std::cerr << "Sorry, only true color BMP is supported at now."
                           << std::endl;
             } else {
                 const uint8_t* pSourceData =
                     reinterpret_cast<const uint8_t*>(buf.GetData()) +
                     pFileHeader->BitsOffset;
+                // source rows are stored bottom up, padded to 4 bytes
+                uint32_t source_pitch =
+                    (img.Width * (pBmpHeader->BitCount >> 3) + 3) & ~3u;
                 for (int32_t y = img.Height - 1; y >= 0; y--) {
-                    for (uint32_t x = 0; x < img.Width; x++) {
-                        auto dst = reinterpret_cast<R8G8B8A8Unorm*>(
-                            reinterpret_cast<uint8_t*>(img.data) +
-                            (ptrdiff_t)img.pitch *
-                                ((ptrdiff_t)img.Height - y - 1) +
-                            (ptrdiff_t)x * byte_count);
-                        auto src = reinterpret_cast<const R8G8B8A8Unorm*>(
-                            pSourceData + (ptrdiff_t)img.pitch * y +
-                            (ptrdiff_t)x * byte_count);
-                        dst->data[2] = src->data[0];
-                        dst->data[1] = src->data[1];
-                        dst->data[0] = src->data[2];
-                        dst->data[3] = src->data[3];
+                    auto* dst = reinterpret_cast<uint8_t*>(img.data) +
+                                (ptrdiff_t)img.pitch *
+                                    ((ptrdiff_t)img.Height - y - 1);
+                    const uint8_t* src =
+                        pSourceData + (ptrdiff_t)source_pitch * y;
+                    if (pBmpHeader->BitCount == 24) {
+                        ExpandBGR8ToRGBA8(src, dst, img.Width);
+                    } else {
+                        SwizzleBGRA8ToRGBA8(src, dst, img.Width);
                     }
                 }
             }
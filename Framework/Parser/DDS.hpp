@@ -206,7 +206,8 @@ class DdsParser : _implements_ ImageParser {
         if (pHeader->ddspf.dwFlags & 0x4 /* DDPF_FOURCC */) {
             const uint32_t* pdwFourCC = &pHeader->ddspf.dwFourCC;
             const char* pCC = reinterpret_cast<const char*>(pdwFourCC);
-            if (pCC[0] != 'D') {
+            // D3DFMT values are small numbers, FourCCs are characters
+            if (*pdwFourCC < 0x100) {
                 auto format = (MY_D3DFMT)*pdwFourCC;
                 img.bitcount = pHeader->ddspf.dwRGBBitCount;
 
@@ -259,6 +260,16 @@ class DdsParser : _implements_ ImageParser {
                 img.compress_format = "DXT5"_u32;
                 img.pitch = std::max(1u, ALIGN(img.Width, 4)) * 4;
                 img.bitcount = 8;
+            } else if (*pdwFourCC == endian_net_unsigned_int("ATI1"_u32) ||
+                       *pdwFourCC == endian_net_unsigned_int("BC4U"_u32)) {
+                img.compress_format = "ATI1"_u32;
+                img.pitch = std::max(1u, ALIGN(img.Width, 4)) * 2;
+                img.bitcount = 4;
+            } else if (*pdwFourCC == endian_net_unsigned_int("ATI2"_u32) ||
+                       *pdwFourCC == endian_net_unsigned_int("BC5U"_u32)) {
+                img.compress_format = "ATI2"_u32;
+                img.pitch = std::max(1u, ALIGN(img.Width, 4)) * 4;
+                img.bitcount = 8;
             } else if (*pdwFourCC == endian_net_unsigned_int("DX10"_u32)) {
                 img.compress_format = "DX10"_u32;
                 const auto* pHeaderDXT10 =
@@ -266,28 +277,65 @@ class DdsParser : _implements_ ImageParser {
                 pData += sizeof(DDS_HEADER_DXT10);
                 std::cerr << "DXGI_FORMAT: " << pHeaderDXT10->dxgiFormat
                           << std::endl;
+
+                // block formats are named as their legacy FourCC would be
+                switch (pHeaderDXT10->dxgiFormat) {
+                    case DXGI_FORMAT_BC1_UNORM:
+                    case DXGI_FORMAT_BC1_UNORM_SRGB:
+                        img.compress_format = "DXT1"_u32;
+                        img.bitcount = 4;
+                        break;
+                    case DXGI_FORMAT_BC2_UNORM:
+                    case DXGI_FORMAT_BC2_UNORM_SRGB:
+                        img.compress_format = "DXT3"_u32;
+                        img.bitcount = 8;
+                        break;
+                    case DXGI_FORMAT_BC3_UNORM:
+                    case DXGI_FORMAT_BC3_UNORM_SRGB:
+                        img.compress_format = "DXT5"_u32;
+                        img.bitcount = 8;
+                        break;
+                    case DXGI_FORMAT_BC4_UNORM:
+                        img.compress_format = "ATI1"_u32;
+                        img.bitcount = 4;
+                        break;
+                    case DXGI_FORMAT_BC5_UNORM:
+                        img.compress_format = "ATI2"_u32;
+                        img.bitcount = 8;
+                        break;
+                    case DXGI_FORMAT_BC6H_UF16:
+                        img.compress_format = "BC6H"_u32;
+                        img.bitcount = 8;
+                        img.is_float = true;
+                        break;
+                    case DXGI_FORMAT_BC7_UNORM:
+                    case DXGI_FORMAT_BC7_UNORM_SRGB:
+                        img.compress_format = "BC7U"_u32;
+                        img.bitcount = 8;
+                        break;
+                    default:
+                        break;
+                }
+                img.pitch = std::max(1u, (ALIGN(img.Width, 4)) >> 2) *
+                            img.bitcount * 2;
             }
 
-            if (mipmap_count > 0) {
-                uint32_t width = img.Width;
-                uint32_t height = img.Height;
+            // a missing count is a single level
+            mipmap_count = std::max(1u, mipmap_count);
+            uint32_t width = img.Width;
+            uint32_t height = img.Height;
 
-                for (decltype(mipmap_count) i = 0; i < mipmap_count; i++) {
-                    if (width > 0 && height > 0) {
-                        auto pitch = std::max(1u, (ALIGN(width, 4)) >> 2) *
-                                     img.bitcount *
-                                     2;  //  img.bitcount / 8 * 16
-                        img.mipmaps.emplace_back(
-                            width, height, pitch,
-                            pitch * (ALIGN(height, 4) >> 2), img.data_size);
-                        img.data_size += img.mipmaps[i].data_size;
+            for (decltype(mipmap_count) i = 0; i < mipmap_count; i++) {
+                auto pitch = std::max(1u, (ALIGN(width, 4)) >> 2) *
+                             img.bitcount * 2;  //  img.bitcount / 8 * 16
+                img.mipmaps.emplace_back(
+                    width, height, pitch, img.data_size /* as offset */,
+                    pitch * std::max(1u, ALIGN(height, 4) >> 2));
+                img.data_size += img.mipmaps[i].data_size;
 
-                        width >>= 1;   // /2
-                        height >>= 1;  // /2
-                    } else {
-                        break;
-                    }
-                }
+                if (width == 1 && height == 1) break;
+                width = std::max(1u, width >> 1);
+                height = std::max(1u, height >> 1);
             }
         } else {
             img.pitch = ALIGN(img.Width * img.bitcount, 8) / 8;
@@ -315,11 +363,73 @@ class DdsParser : _implements_ ImageParser {
 
         assert(img.data_size < buf.GetDataSize());
 
-        img.data = new uint8_t[img.data_size];
-
-        memcpy(img.data, pData, img.data_size);
+        // the payload is used as stored, share it instead of copying
+        img.storage = buf.Slice(pData - buf.GetData(), img.data_size);
+        img.data = img.storage.GetData();
 
         return img;
     }
 };
+
+// writes block compressed images with their mips, as DdsParser reads them
+class DdsWriter {
+   public:
+    static bool Write(const Image& img, std::ostream& out) {
+        if (!img.compressed || !img.data || img.mipmaps.empty()) return false;
+
+        DDS_HEADER header = {};
+        header.dwSize = sizeof(DDS_HEADER);
+        // CAPS | HEIGHT | WIDTH | PIXELFORMAT | MIPMAPCOUNT | LINEARSIZE
+        header.dwFlags = 0x1 | 0x2 | 0x4 | 0x1000 | 0x20000 | 0x80000;
+        header.dwHeight = img.Height;
+        header.dwWidth = img.Width;
+        header.dwPitchOrLinearSize =
+            static_cast<uint32_t>(img.mipmaps[0].data_size);
+        header.dwMipMapCount = static_cast<uint32_t>(img.mipmaps.size());
+        header.ddspf.dwSize = sizeof(DDS_PIXELFORMAT);
+        header.ddspf.dwFlags = 0x4;  // DDPF_FOURCC
+        // TEXTURE | COMPLEX | MIPMAP
+        header.dwCaps = 0x1000 | 0x8 | 0x400000;
+
+        DDS_HEADER_DXT10 header10 = {};
+        switch (img.compress_format) {
+            case "DXT1"_u32:
+            case "DXT3"_u32:
+            case "DXT5"_u32:
+            case "ATI1"_u32:
+            case "ATI2"_u32:
+                header.ddspf.dwFourCC =
+                    endian_net_unsigned_int(img.compress_format);
+                break;
+            case "BC6H"_u32:
+                header10.dxgiFormat = DXGI_FORMAT_BC6H_UF16;
+                break;
+            case "BC7U"_u32:
+                header10.dxgiFormat = DXGI_FORMAT_BC7_UNORM;
+                break;
+            default:
+                return false;
+        }
+
+        uint32_t magic = endian_net_unsigned_int("DDS "_u32);
+        out.write(reinterpret_cast<const char*>(&magic), sizeof(magic));
+        if (header10.dxgiFormat != DXGI_FORMAT_UNKNOWN) {
+            header.ddspf.dwFourCC = endian_net_unsigned_int("DX10"_u32);
+            header10.resourceDimension = D3D10_RESOURCE_DIMENSION_TEXTURE2D;
+            header10.arraySize = 1;
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(&header10),
+                      sizeof(header10));
+        } else {
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+
+        for (const auto& mip : img.mipmaps) {
+            out.write(reinterpret_cast<const char*>(img.data + mip.offset),
+                      static_cast<std::streamsize>(mip.data_size));
+        }
+
+        return static_cast<bool>(out);
+    }
+};
 }  // namespace My
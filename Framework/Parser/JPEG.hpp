@@ -7,8 +7,8 @@
 #include <string>
 
 #include "ColorSpaceConversion.hpp"
-#include "HuffmanTree.hpp"
 #include "ImageParser.hpp"
+#include "JpegHuffman.hpp"
 #include "portable.hpp"
 
 // Enable this to print out very detailed decode information
@@ -127,7 +127,7 @@ class JfifParser : _implements_ ImageParser {
         58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
 
    protected:
-    HuffmanTree<uint8_t> m_treeHuffman[4];
+    JpegHuffmanTable m_tableHuffman[4];
     Matrix8X8f m_tableQuantization[4];
     std::vector<FRAME_COMPONENT_SPEC_PARAMS> m_tableFrameComponentsSpec;
     uint16_t m_nSamplePrecision;
@@ -144,55 +144,14 @@ class JfifParser : _implements_ ImageParser {
    protected:
     size_t parseScanData(const uint8_t* pScanData, const uint8_t* pDataEnd,
                          Image& img) {
-        std::vector<uint8_t> scan_data;
-        size_t scanLength = 0;
-
-        {
-            const uint8_t* p = pScanData;
-
-            // scan for scan data buffer size and remove bitstuff
-            bool bitstuff = false;
-            while (p < pDataEnd && (*p != 0xFF || *(p + 1) == 0x00)) {
-                if (!bitstuff) {
-                    scan_data.push_back(*p);
-                } else {
-                    // ignore it and reset the flag
-                    assert(*p == 0x00);
-                    bitstuff = false;
-                }
-
-                if (*(uint16_t*)p ==
-                    endian_net_unsigned_int((uint16_t)0xFF00)) {
-                    bitstuff = true;
-                }
-
-                p++;
-                scanLength++;
-            }
-
-            if (*p == 0xFF && *(p + 1) >= 0xD0 && *(p + 1) <= 0xD7) {
-                // found restart mark
-#if DUMP_DETAILS
-                std::cerr << "Found RST while scan the ECS." << std::endl;
-#endif
-            }
-
-#if DUMP_DETAILS
-            std::cerr << "Size Of Scan: " << scanLength << " bytes"
-                      << std::endl;
-            std::cerr << "Size Of Scan (after remove bitstuff): "
-                      << scan_data.size() << " bytes" << std::endl;
-#endif
-        }
+        // the bit stuffing is removed as the bits are read
+        JpegBitReader reader(pScanData, pDataEnd);
 
         int16_t
             previous_dc[4];  // 4 is max num of components defined by ITU-T81
         memset(previous_dc, 0x00, sizeof(previous_dc));
 
-        size_t byte_offset = 0;
-        uint8_t bit_offset = 0;
-
-        while (byte_offset < scan_data.size() && mcu_index < mcu_count) {
+        while (!reader.Empty() && mcu_index < mcu_count) {
 #if DUMP_DETAILS
             std::cerr << "MCU: " << mcu_index << std::endl;
 #endif
@@ -221,54 +180,13 @@ class JfifParser : _implements_ ImageParser {
 
                 // Decode DC
                 uint8_t dc_code =
-                    m_treeHuffman[pScsp[i].DcEntropyCodingTableDestSelector()]
-                        .DecodeSingleValue(scan_data.data(), scan_data.size(),
-                                           &byte_offset, &bit_offset);
+                    m_tableHuffman[pScsp[i].DcEntropyCodingTableDestSelector()]
+                        .Decode(reader);
                 uint8_t dc_bit_length = dc_code & 0x0F;
-                int16_t dc_value;
-                uint32_t tmp_value;
-
-                if (!dc_code) {
-#if DUMP_DETAILS
-                    std::cerr << "Found EOB when decode DC!" << std::endl;
-#endif
-                    dc_value = 0;
-                } else {
-                    if (dc_bit_length + bit_offset <= 8) {
-                        tmp_value = ((scan_data[byte_offset] &
-                                      ((0x01u << (8 - bit_offset)) - 1)) >>
-                                     (8 - dc_bit_length - bit_offset));
-                    } else {
-                        uint8_t bits_in_first_byte = 8 - bit_offset;
-                        uint8_t append_full_bytes =
-                            (dc_bit_length - bits_in_first_byte) / 8;
-                        uint8_t bits_in_last_byte = dc_bit_length -
-                                                    bits_in_first_byte -
-                                                    8 * append_full_bytes;
-                        tmp_value = (scan_data[byte_offset] &
-                                     ((0x01u << (8 - bit_offset)) - 1));
-                        for (int m = 1; m <= append_full_bytes; m++) {
-                            tmp_value <<= 8;
-                            tmp_value += scan_data[byte_offset + m];
-                        }
-                        tmp_value <<= bits_in_last_byte;
-                        tmp_value +=
-                            (scan_data[byte_offset + append_full_bytes + 1] >>
-                             (8 - bits_in_last_byte));
-                    }
-
-                    // decode dc value
-                    if ((tmp_value >> (dc_bit_length - 1)) == 0) {
-                        // MSB = 1, turn it to minus value
-                        dc_value = -(int16_t)(~tmp_value &
-                                              ((0x0001u << dc_bit_length) - 1));
-                    } else {
-                        dc_value = tmp_value;
-                    }
-                }
 
                 // add with previous DC value
-                dc_value += previous_dc[i];
+                auto dc_value = static_cast<int16_t>(
+                    reader.Receive(dc_bit_length) + previous_dc[i]);
                 // save the value for next DC
                 previous_dc[i] = dc_value;
 
@@ -280,22 +198,13 @@ class JfifParser : _implements_ ImageParser {
 
                 block[i][0][0] = dc_value;
 
-                // forward pointers to end of DC
-                bit_offset += dc_bit_length;
-                while (bit_offset >= 8) {
-                    bit_offset -= 8;
-                    byte_offset++;
-                }
-
                 // Decode AC
+                const auto& ac_table =
+                    m_tableHuffman[2 +
+                                   pScsp[i].AcEntropyCodingTableDestSelector()];
                 int ac_index = 1;
-                while (byte_offset < scan_data.size() && ac_index < 64) {
-                    uint8_t ac_code =
-                        m_treeHuffman
-                            [2 + pScsp[i].AcEntropyCodingTableDestSelector()]
-                                .DecodeSingleValue(scan_data.data(),
-                                                   scan_data.size(),
-                                                   &byte_offset, &bit_offset);
+                while (!reader.Empty() && ac_index < 64) {
+                    uint8_t ac_code = ac_table.Decode(reader);
 
                     if (!ac_code) {
 #if DUMP_DETAILS
@@ -315,39 +224,11 @@ class JfifParser : _implements_ ImageParser {
                     uint8_t ac_zero_length = ac_code >> 4;
                     ac_index += ac_zero_length;
                     uint8_t ac_bit_length = ac_code & 0x0F;
-                    int16_t ac_value;
-
-                    if (ac_bit_length + bit_offset <= 8) {
-                        tmp_value = ((scan_data[byte_offset] &
-                                      ((0x01u << (8 - bit_offset)) - 1)) >>
-                                     (8 - ac_bit_length - bit_offset));
-                    } else {
-                        uint8_t bits_in_first_byte = 8 - bit_offset;
-                        uint8_t append_full_bytes =
-                            (ac_bit_length - bits_in_first_byte) / 8;
-                        uint8_t bits_in_last_byte = ac_bit_length -
-                                                    bits_in_first_byte -
-                                                    8 * append_full_bytes;
-                        tmp_value = (scan_data[byte_offset] &
-                                     ((0x01u << (8 - bit_offset)) - 1));
-                        for (int m = 1; m <= append_full_bytes; m++) {
-                            tmp_value <<= 8;
-                            tmp_value += scan_data[byte_offset + m];
-                        }
-                        tmp_value <<= bits_in_last_byte;
-                        tmp_value +=
-                            (scan_data[byte_offset + append_full_bytes + 1] >>
-                             (8 - bits_in_last_byte));
-                    }
+                    auto ac_value =
+                        static_cast<int16_t>(reader.Receive(ac_bit_length));
 
-                    // decode ac value
-                    if ((tmp_value >> (ac_bit_length - 1)) == 0) {
-                        // MSB = 1, turn it to minus value
-                        ac_value = -(int16_t)(~tmp_value &
-                                              ((0x0001u << ac_bit_length) - 1));
-                    } else {
-                        ac_value = tmp_value;
-                    }
+                    // runs past the end of the block are corrupt data
+                    if (ac_index >= 64) break;
 
 #ifdef DUMP_DETAILS
                     printf("AC Code: %x\n", ac_code);
@@ -358,13 +239,6 @@ class JfifParser : _implements_ ImageParser {
                     int index = m_zigzagIndex[ac_index];
                     block[i][index >> 3][index & 0x07] = ac_value;
 
-                    // forward pointers to end of AC
-                    bit_offset += ac_bit_length;
-                    while (bit_offset >= 8) {
-                        bit_offset -= 8;
-                        byte_offset++;
-                    }
-
                     ac_index++;
                 }
 
@@ -420,17 +294,31 @@ class JfifParser : _implements_ ImageParser {
 
             if (m_nRestartInterval != 0 &&
                 (mcu_index % m_nRestartInterval == 0)) {
-                if (bit_offset) {
-                    // finish current byte
-                    bit_offset = 0;
-                    byte_offset++;
-                }
-                assert(byte_offset == scan_data.size());
                 break;
             }
         }
 
-        return scanLength;
+        // the scan ends at the next marker, the reader stops at it or
+        // short of it
+        const uint8_t* p = reader.GetPosition();
+        while (p < pDataEnd &&
+               (*p != 0xFF || (p + 1 < pDataEnd && *(p + 1) == 0x00))) {
+            p++;
+        }
+
+        if (p + 1 < pDataEnd && *(p + 1) >= 0xD0 && *(p + 1) <= 0xD7) {
+            // found restart mark
+#if DUMP_DETAILS
+            std::cerr << "Found RST while scan the ECS." << std::endl;
+#endif
+        }
+
+#if DUMP_DETAILS
+        std::cerr << "Size Of Scan: " << p - pScanData << " bytes"
+                  << std::endl;
+#endif
+
+        return p - pScanData;
     }
 
    public:
@@ -524,8 +412,7 @@ class JfifParser : _implements_ ImageParser {
                         img.Height = m_nLines;
                         img.bitcount = 32;
                         img.pitch = mcu_count_x * 8 * (img.bitcount >> 3);
-                        img.data_size = (size_t)img.pitch * mcu_count_y * 8 *
-                                        (img.bitcount >> 3);
+                        img.data_size = (size_t)img.pitch * mcu_count_y * 8;
                         img.data = new uint8_t[img.data_size];
 
                         pData += (ptrdiff_t)endian_net_unsigned_int(
@@ -542,11 +429,24 @@ class JfifParser : _implements_ ImageParser {
 
                         const uint8_t* pTmp =
                             pData + sizeof(JPEG_SEGMENT_HEADER);
+                        if (segmentLength >
+                            static_cast<size_t>(pDataEnd - pTmp)) {
+                            std::cerr << "Truncated Huffman table segment!"
+                                      << std::endl;
+                            return Image();
+                        }
 
                         while (segmentLength > 0) {
                             const auto* pHtable =
                                 reinterpret_cast<const HUFFMAN_TABLE_SPEC*>(
                                     pTmp);
+                            if (segmentLength < sizeof(HUFFMAN_TABLE_SPEC) ||
+                                pHtable->TableClass() > 1 ||
+                                pHtable->DestinationIdentifier() > 1) {
+                                std::cerr << "Malformed Huffman table!"
+                                          << std::endl;
+                                return Image();
+                            }
                             std::cerr
                                 << "Table Class: " << pHtable->TableClass()
                                 << std::endl;
@@ -558,21 +458,28 @@ class JfifParser : _implements_ ImageParser {
                                 reinterpret_cast<const uint8_t*>(pHtable) +
                                 sizeof(HUFFMAN_TABLE_SPEC);
 
-                            auto num_symbo =
-                                m_treeHuffman[(pHtable->TableClass() << 1) |
-                                              pHtable->DestinationIdentifier()]
-                                    .PopulateWithHuffmanTable(
-                                        pHtable->NumOfHuffmanCodes,
-                                        pCodeValueStart);
+                            // a corrupt table would decode garbage, or
+                            // write past its own arrays
+                            auto& table = m_tableHuffman
+                                [(pHtable->TableClass() << 1) |
+                                 pHtable->DestinationIdentifier()];
+                            if (!table.Populate(
+                                    pHtable->NumOfHuffmanCodes,
+                                    pCodeValueStart,
+                                    segmentLength -
+                                        sizeof(HUFFMAN_TABLE_SPEC))) {
+                                std::cerr << "Malformed Huffman table!"
+                                          << std::endl;
+                                return Image();
+                            }
 
 #ifdef DUMP_DETAILS
-                            m_treeHuffman[(pHtable->TableClass() << 1) |
-                                          pHtable->DestinationIdentifier()]
-                                .Dump();
+                            table.Dump();
 #endif
 
                             size_t processed_length =
-                                sizeof(HUFFMAN_TABLE_SPEC) + num_symbo;
+                                sizeof(HUFFMAN_TABLE_SPEC) +
+                                table.GetSymbolCount();
                             pTmp += processed_length;
                             segmentLength -= processed_length;
                         }
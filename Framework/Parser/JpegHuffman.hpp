@@ -0,0 +1,200 @@
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace My {
+// reads the entropy coded data of a scan most significant bit first, 64
+// bits at a time. the 0x00 stuffed after every 0xFF is dropped as the
+// bytes are read. at a marker, or the end of the data, it stops and reads
+// zeros from then on.
+class JpegBitReader {
+   public:
+    JpegBitReader(const uint8_t* data, const uint8_t* end)
+        : m_pData(data), m_pEnd(end) {
+        Refill();
+    }
+
+    // the next count bits, 1 to 16, without consuming them
+    uint32_t Peek(uint32_t count) {
+        if (m_nBits < static_cast<int32_t>(count)) Refill();
+        return static_cast<uint32_t>(m_Buffer >> (64 - count));
+    }
+
+    void Skip(uint32_t count) {
+        m_Buffer <<= count;
+        m_nBits -= static_cast<int32_t>(count);
+    }
+
+    // the next count bits, 0 to 16
+    uint32_t Get(uint32_t count) {
+        if (!count) return 0;
+        uint32_t value = Peek(count);
+        Skip(count);
+        return value;
+    }
+
+    // the next count bits as the signed value they code, EXTEND in T.81
+    int32_t Receive(uint32_t count) {
+        if (!count) return 0;
+        auto value = static_cast<int32_t>(Get(count));
+        if (value < (1 << (count - 1))) value -= (1 << count) - 1;
+        return value;
+    }
+
+    // every bit before the marker or the end of the data was consumed
+    bool Empty() {
+        if (!m_bMarker) Refill();
+        return m_bMarker && m_nBits <= m_nPadding;
+    }
+
+    // the first byte not yet read into the buffer, the marker once it was
+    // reached. never past the marker.
+    [[nodiscard]] const uint8_t* GetPosition() const { return m_pData; }
+
+   private:
+    void Refill() {
+        while (m_nBits <= 56) {
+            uint64_t byte = 0;
+            if (!m_bMarker) {
+                if (m_pData < m_pEnd && *m_pData != 0xFF) {
+                    byte = *m_pData++;
+                } else if (m_pData + 1 < m_pEnd && m_pData[1] == 0x00) {
+                    // a stuffed 0xFF
+                    byte = 0xFF;
+                    m_pData += 2;
+                } else {
+                    m_bMarker = true;
+                }
+            }
+            if (m_bMarker) m_nPadding += 8;
+
+            m_Buffer |= byte << (56 - m_nBits);
+            m_nBits += 8;
+        }
+    }
+
+    const uint8_t* m_pData;
+    const uint8_t* m_pEnd;
+    // the bits not consumed yet, from the most significant one
+    uint64_t m_Buffer{0};
+    int32_t m_nBits{0};
+    // the zeros appended past the marker, at the end of the buffer
+    int32_t m_nPadding{0};
+    bool m_bMarker{false};
+};
+
+// decodes the canonical codes of a DHT table. codes of up to kLookupBits
+// bits, nearly all of those in a scan, are found with one lookup of the
+// next kLookupBits bits. longer ones are compared against the largest code
+// of each length, as DECODE in T.81 does.
+class JpegHuffmanTable {
+   public:
+    static constexpr uint32_t kLookupBits = 9;
+
+    // builds the tables from the code counts of each length and the
+    // symbols, of which there are available bytes. false if the table is
+    // malformed: more symbols than 256 or than there are bytes, or more
+    // codes of a length than it can hold.
+    bool Populate(const uint8_t num_of_codes[16], const uint8_t* symbols,
+                  size_t available) {
+        size_t count = 0;
+        for (uint32_t length = 1; length <= 16; length++) {
+            count += num_of_codes[length - 1];
+        }
+        if (count > sizeof(m_Symbols) || count > available) return false;
+
+        // the codes of each length follow those of the shorter ones, they
+        // run out if a length has more than is left for it
+        uint32_t code = 0;
+        for (uint32_t length = 1; length <= 16; length++) {
+            code += num_of_codes[length - 1];
+            if (code > (1u << length)) return false;
+            code <<= 1;
+        }
+
+        m_nSymbolCount = count;
+        memcpy(m_Symbols, symbols, count);
+        memset(m_Lookup, 0, sizeof(m_Lookup));
+
+        code = 0;
+        size_t index = 0;
+        for (uint32_t length = 1; length <= 16; length++) {
+            uint32_t n = num_of_codes[length - 1];
+            m_ValueOffset[length] =
+                static_cast<int32_t>(index) - static_cast<int32_t>(code);
+
+            for (uint32_t i = 0; i < n; i++, code++, index++) {
+                if (length > kLookupBits) continue;
+
+                // every lookahead starting with the code
+                uint32_t shift = kLookupBits - length;
+                for (uint32_t fill = 0; fill < (1u << shift); fill++) {
+                    m_Lookup[(code << shift) | fill] = static_cast<uint16_t>(
+                        (length << 8) | m_Symbols[index]);
+                }
+            }
+
+            m_MaxCode[length] = n ? static_cast<int32_t>(code) - 1 : -1;
+            code <<= 1;
+        }
+
+        return true;
+    }
+
+    // the symbols of the last table populated
+    [[nodiscard]] size_t GetSymbolCount() const { return m_nSymbolCount; }
+
+    uint8_t Decode(JpegBitReader& reader) const {
+        uint16_t entry = m_Lookup[reader.Peek(kLookupBits)];
+        if (entry) {
+            reader.Skip(entry >> 8);
+            return static_cast<uint8_t>(entry);
+        }
+
+        uint32_t bits = reader.Peek(16);
+        for (uint32_t length = kLookupBits + 1; length <= 16; length++) {
+            auto code = static_cast<int32_t>(bits >> (16 - length));
+            if (code <= m_MaxCode[length]) {
+                reader.Skip(length);
+                return m_Symbols[code + m_ValueOffset[length]];
+            }
+        }
+
+        // no code matches, the data is corrupt. taken as the end of block.
+        reader.Skip(16);
+        return 0;
+    }
+
+    void Dump() const {
+        uint32_t code = 0;
+        size_t index = 0;
+        for (uint32_t length = 1; length <= 16; length++) {
+            for (; m_MaxCode[length] >= 0 &&
+                   static_cast<int32_t>(code) <= m_MaxCode[length];
+                 code++, index++) {
+                std::string bit_stream;
+                for (int32_t bit = length - 1; bit >= 0; bit--) {
+                    bit_stream += ((code >> bit) & 1) ? '1' : '0';
+                }
+                printf("%20s | %x\n", bit_stream.c_str(), m_Symbols[index]);
+            }
+            code <<= 1;
+        }
+        printf("\n");
+    }
+
+   private:
+    // the length of the code starting the lookahead in the high byte and
+    // its symbol in the low one, 0 for codes longer than the lookahead
+    uint16_t m_Lookup[1 << kLookupBits]{};
+    // the largest code of each length, -1 if there is none
+    int32_t m_MaxCode[17]{};
+    // what is added to a code of each length to index its symbol
+    int32_t m_ValueOffset[17]{};
+    uint8_t m_Symbols[256]{};
+    size_t m_nSymbolCount{0};
+};
+}  // namespace My
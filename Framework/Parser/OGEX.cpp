@@ -44,19 +44,20 @@ void OgexParser::ConvertOddlStructureToSceneNode(
         }
             return;
         case OGEX::kStructureNode: {
-            node =
-                std::make_shared<SceneEmptyNode>(structure.GetStructureName());
+            node = std::make_shared<SceneEmptyNode>(
+                structure.GetStructureName(), scene.GetArena());
         } break;
         case OGEX::kStructureBoneNode: {
-            auto _node =
-                std::make_shared<SceneBoneNode>(structure.GetStructureName());
+            auto _node = std::make_shared<SceneBoneNode>(
+                structure.GetStructureName(), scene.GetArena());
             std::string _key = structure.GetStructureName();
             scene.BoneNodes.emplace(_key, _node);
             node = _node;
         } break;
         case OGEX::kStructureGeometryNode: {
             std::string _key = structure.GetStructureName();
-            auto _node = std::make_shared<SceneGeometryNode>(_key);
+            auto _node =
+                std::make_shared<SceneGeometryNode>(_key, scene.GetArena());
             const auto& _structure =
                 dynamic_cast<const OGEX::GeometryNodeStructure&>(structure);
 
@@ -85,8 +86,8 @@ void OgexParser::ConvertOddlStructureToSceneNode(
             node = _node;
         } break;
         case OGEX::kStructureLightNode: {
-            auto _node =
-                std::make_shared<SceneLightNode>(structure.GetStructureName());
+            auto _node = std::make_shared<SceneLightNode>(
+                structure.GetStructureName(), scene.GetArena());
             const auto& _structure =
                 dynamic_cast<const OGEX::LightNodeStructure&>(structure);
 
@@ -102,8 +103,8 @@ void OgexParser::ConvertOddlStructureToSceneNode(
             node = _node;
         } break;
         case OGEX::kStructureCameraNode: {
-            auto _node =
-                std::make_shared<SceneCameraNode>(structure.GetStructureName());
+            auto _node = std::make_shared<SceneCameraNode>(
+                structure.GetStructureName(), scene.GetArena());
             const auto& _structure =
                 dynamic_cast<const OGEX::CameraNodeStructure&>(structure);
 
@@ -374,7 +375,7 @@ void OgexParser::ConvertOddlStructureToSceneNode(
                 }
             }
 
-            scene.Geometries[_key] = _object;
+            scene.Geometries[Scene::Key(_key)] = _object;
         }
             return;
         case OGEX::kStructureTransform: {
@@ -525,7 +526,7 @@ void OgexParser::ConvertOddlStructureToSceneNode(
 
                 _sub_structure = _sub_structure->Next();
             }
-            scene.Materials[_key] = material;
+            scene.Materials[Scene::Key(_key)] = material;
         }
             return;
         case OGEX::kStructureLightObject: {
@@ -674,7 +675,7 @@ void OgexParser::ConvertOddlStructureToSceneNode(
                 extension = extension->Next();
             }
 
-            scene.Lights[_key] = light;
+            scene.Lights[Scene::Key(_key)] = light;
         }
             return;
         case OGEX::kStructureCameraObject: {
@@ -723,7 +724,7 @@ void OgexParser::ConvertOddlStructureToSceneNode(
 
                 _sub_structure = _sub_structure->Next();
             }
-            scene.Cameras[_key] = camera;
+            scene.Cameras[Scene::Key(_key)] = camera;
         }
             return;
         case OGEX::kStructureAnimation: {
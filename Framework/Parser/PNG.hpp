@@ -5,8 +5,10 @@
 #include <iostream>
 #include <queue>
 #include <string>
+#include <vector>
 
 #include "ImageParser.hpp"
+#include "PixelConversion.hpp"
 #include "config.h"
 #include "portable.hpp"
 #include "zlib.h"
@@ -89,6 +91,9 @@ class PngParser : _implements_ ImageParser {
     uint8_t m_BytesPerPixel;
 
    public:
+    explicit PngParser(PixelLayout layout = PixelLayout::kNative)
+        : m_Layout(layout) {}
+
     Image Parse(Buffer& buf) override {
         Image img;
 
@@ -173,6 +178,10 @@ class PngParser : _implements_ ImageParser {
                         img.Width = m_Width;
                         img.Height = m_Height;
                         img.bitcount = m_BytesPerPixel * 8;
+                        if (m_ColorType == 2 &&
+                            m_Layout == PixelLayout::kRGBA) {
+                            img.bitcount = m_BitDepth * 4;
+                        }
                         img.pitch = (img.Width * (img.bitcount >> 3) + 3) &
                                     ~3u;  // for GPU address alignment
                         img.data_size = (size_t)img.pitch * img.Height;
@@ -282,6 +291,12 @@ class PngParser : _implements_ ImageParser {
                             img.data);  // point to the start of the input data
                                         // buffer
                         auto* pDecompressedBuffer = new uint8_t[kChunkSize];
+                        // the scan lines are de-filtered here and written
+                        // to the image in its final layout, the row above
+                        // starts as zeros
+                        std::vector<uint8_t> scanLines(2 * m_ScanLineSize, 0);
+                        uint8_t* pPrior = scanLines.data();
+                        uint8_t* pCurrent = pPrior + m_ScanLineSize;
                         uint8_t filter_type = 0;
                         int current_row = 0;
                         int current_col =
@@ -326,63 +341,33 @@ class PngParser : _implements_ ImageParser {
                                                 //  A  X
 
                                                 uint8_t A, B, C;
-                                                if (current_row == 0) {
-                                                    B = C = 0;
+                                                B = pPrior[current_col];
+                                                if (current_col <
+                                                    m_BytesPerPixel) {
+                                                    A = C = 0;
                                                 } else {
-                                                    B = *(pOut +
-                                                          (ptrdiff_t)img.pitch *
-                                                              ((ptrdiff_t)
-                                                                   current_row -
-                                                               1) +
-                                                          current_col);
-                                                    C = (current_col <
-                                                         m_BytesPerPixel)
-                                                            ? 0
-                                                            : *(pOut +
-                                                                (ptrdiff_t)img
-                                                                        .pitch *
-                                                                    ((ptrdiff_t)
-                                                                         current_row -
-                                                                     1) +
-                                                                current_col -
-                                                                m_BytesPerPixel);
+                                                    A = pCurrent
+                                                        [current_col -
+                                                         m_BytesPerPixel];
+                                                    C = pPrior
+                                                        [current_col -
+                                                         m_BytesPerPixel];
                                                 }
 
-                                                A = (current_col <
-                                                     m_BytesPerPixel)
-                                                        ? 0
-                                                        : *(pOut +
-                                                            (ptrdiff_t)
-                                                                    img.pitch *
-                                                                current_row +
-                                                            current_col -
-                                                            m_BytesPerPixel);
-
+                                                uint8_t& X =
+                                                    pCurrent[current_col];
                                                 switch (filter_type) {
                                                     case 0:
-                                                        *(pOut +
-                                                          (ptrdiff_t)img.pitch *
-                                                              current_row +
-                                                          current_col) = *p;
+                                                        X = *p;
                                                         break;
                                                     case 1:
-                                                        *(pOut +
-                                                          (ptrdiff_t)img.pitch *
-                                                              current_row +
-                                                          current_col) = *p + A;
+                                                        X = *p + A;
                                                         break;
                                                     case 2:
-                                                        *(pOut +
-                                                          (ptrdiff_t)img.pitch *
-                                                              current_row +
-                                                          current_col) = *p + B;
+                                                        X = *p + B;
                                                         break;
                                                     case 3:
-                                                        *(pOut +
-                                                          (ptrdiff_t)img.pitch *
-                                                              current_row +
-                                                          current_col) =
-                                                            *p + (A + B) / 2;
+                                                        X = *p + (A + B) / 2;
                                                         break;
                                                     case 4: {
                                                         int _p = A + B - C;
@@ -391,26 +376,11 @@ class PngParser : _implements_ ImageParser {
                                                         int pc = abs(_p - C);
                                                         if (pa <= pb &&
                                                             pa <= pc) {
-                                                            *(pOut +
-                                                              (ptrdiff_t)img
-                                                                      .pitch *
-                                                                  current_row +
-                                                              current_col) =
-                                                                *p + A;
+                                                            X = *p + A;
                                                         } else if (pb <= pc) {
-                                                            *(pOut +
-                                                              (ptrdiff_t)img
-                                                                      .pitch *
-                                                                  current_row +
-                                                              current_col) =
-                                                                *p + B;
+                                                            X = *p + B;
                                                         } else {
-                                                            *(pOut +
-                                                              (ptrdiff_t)img
-                                                                      .pitch *
-                                                                  current_row +
-                                                              current_col) =
-                                                                *p + C;
+                                                            X = *p + C;
                                                         }
                                                     } break;
                                                     default:
@@ -425,6 +395,15 @@ class PngParser : _implements_ ImageParser {
 
                                             current_col++;
                                             if (current_col == m_ScanLineSize) {
+                                                if (current_row < m_Height) {
+                                                    EmitScanLine(
+                                                        pCurrent,
+                                                        pOut +
+                                                            (ptrdiff_t)
+                                                                    img.pitch *
+                                                                current_row);
+                                                }
+                                                std::swap(pPrior, pCurrent);
                                                 current_col = -1;
                                                 current_row++;
                                             }
@@ -458,24 +437,28 @@ class PngParser : _implements_ ImageParser {
         img.mipmaps.emplace_back(img.Width, img.Height, img.pitch, 0,
                                  img.data_size);
 
-        // now swap the endian
-        if (img.bitcount > 32) {
-            if (img.bitcount <= 64) {
-                for (auto* p = reinterpret_cast<uint16_t*>(img.data);
-                     p < reinterpret_cast<uint16_t*>(img.data + img.data_size);
-                     p++) {
-                    *p = endian_net_unsigned_int(*p);
-                }
+        return img;
+    }
+
+   private:
+    // writes a de-filtered scan line to its row of the image, the 16 bit
+    // samples to native endian and RGB widened when kRGBA is asked for
+    void EmitScanLine(const uint8_t* pScanLine, uint8_t* pRow) const {
+        bool widen = (m_ColorType == 2 && m_Layout == PixelLayout::kRGBA);
+        auto* pRow16 = reinterpret_cast<uint16_t*>(pRow);
+        if (m_BitDepth == 16) {
+            if (widen) {
+                ExpandRGB16BEToRGBA16(pScanLine, pRow16, m_Width);
             } else {
-                for (auto* p = reinterpret_cast<uint32_t*>(img.data);
-                     p < reinterpret_cast<uint32_t*>(img.data + img.data_size);
-                     p++) {
-                    *p = endian_net_unsigned_int(*p);
-                }
+                LoadBigEndian16(pScanLine, pRow16, m_ScanLineSize >> 1);
             }
+        } else if (widen) {
+            ExpandRGB8ToRGBA8(pScanLine, pRow, m_Width);
+        } else {
+            memcpy(pRow, pScanLine, m_ScanLineSize);
         }
-
-        return img;
     }
+
+    PixelLayout m_Layout;
 };
 }  // namespace My
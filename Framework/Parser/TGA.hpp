@@ -7,6 +7,7 @@
 #include <string>
 
 #include "ImageParser.hpp"
+#include "PixelConversion.hpp"
 #include "config.h"
 #include "portable.hpp"
 
@@ -23,6 +24,9 @@ struct TGA_FILEHEADER {
 
 class TgaParser : _implements_ ImageParser {
    public:
+    explicit TgaParser(PixelLayout layout = PixelLayout::kNative)
+        : m_Layout(layout) {}
+
     Image Parse(Buffer& buf) override {
         Image img;
 
@@ -77,60 +81,61 @@ class TgaParser : _implements_ ImageParser {
         // nothing to skip
 
         // reading the pixel data
-        img.bitcount = (alpha_depth ? 32 : 24);
+        img.bitcount =
+            (alpha_depth || m_Layout == PixelLayout::kRGBA) ? 32 : 24;
         img.pitch = (img.Width * (img.bitcount >> 3) + 3) &
                     ~3u;  // for GPU address alignment
 
         img.data_size = (size_t)img.pitch * img.Height;
         img.data = new uint8_t[img.data_size];
 
+        const uint32_t byte_count = img.bitcount >> 3;
         auto* pOut = (uint8_t*)img.data;
         for (decltype(img.Height) i = 0; i < img.Height; i++) {
+            uint8_t* pRow = pOut + (ptrdiff_t)img.pitch * i;
+
+            // true color rows are converted whole
+            if (pixel_depth == 24 && byte_count == 4) {
+                ExpandBGR8ToRGBA8(pData, pRow, img.Width);
+                pData += (ptrdiff_t)img.Width * 3;
+                continue;
+            }
+
+            if (pixel_depth == 32) {
+                assert(alpha_depth == 8);
+                SwizzleBGRA8ToRGBA8(pData, pRow, img.Width);
+                pData += (ptrdiff_t)img.Width * 4;
+                continue;
+            }
+
             for (decltype(img.Width) j = 0; j < img.Width; j++) {
+                uint8_t* pPixel = pRow + (ptrdiff_t)j * byte_count;
                 switch (pixel_depth) {
                     case 15: {
                         assert(alpha_depth == 0);
                         uint16_t color = *(uint16_t*)pData;
                         pData += 2;
-                        *(pOut + (ptrdiff_t)img.pitch * i + (ptrdiff_t)j * 3) =
-                            ((color & 0x7C00) >> 10);  // R
-                        *(pOut + (ptrdiff_t)img.pitch * i + (ptrdiff_t)j * 3 +
-                          1) = ((color & 0x03E0) >> 5);  // G
-                        *(pOut + (ptrdiff_t)img.pitch * i + (ptrdiff_t)j * 3 +
-                          2) = (color & 0x001F);  // B
+                        pPixel[0] = ((color & 0x7C00) >> 10);  // R
+                        pPixel[1] = ((color & 0x03E0) >> 5);   // G
+                        pPixel[2] = (color & 0x001F);          // B
+                        if (byte_count == 4) {
+                            pPixel[3] = 0xFF;  // A
+                        }
                     } break;
                     case 16: {
                         assert(alpha_depth == 1);
                         uint16_t color = *(uint16_t*)pData;
                         pData += 2;
-                        *(pOut + (ptrdiff_t)img.pitch * i + (ptrdiff_t)j * 4) =
-                            ((color & 0x7C00) >> 10);  // R
-                        *(pOut + (ptrdiff_t)img.pitch * i + (ptrdiff_t)j * 4 +
-                          1) = ((color & 0x03E0) >> 5);  // G
-                        *(pOut + (ptrdiff_t)img.pitch * i + (ptrdiff_t)j * 4 +
-                          2) = (color & 0x001F);  // B
-                        *(pOut + (ptrdiff_t)img.pitch * i + (ptrdiff_t)j * 4 +
-                          3) = ((color & 0x8000) ? 0xFF : 0x00);  // A
+                        pPixel[0] = ((color & 0x7C00) >> 10);          // R
+                        pPixel[1] = ((color & 0x03E0) >> 5);           // G
+                        pPixel[2] = (color & 0x001F);                  // B
+                        pPixel[3] = ((color & 0x8000) ? 0xFF : 0x00);  // A
                     } break;
                     case 24: {
                         assert(alpha_depth == 0);
-                        *(pOut + (ptrdiff_t)img.pitch * i + (ptrdiff_t)j * 3 +
-                          2) = *pData++;  // B
-                        *(pOut + (ptrdiff_t)img.pitch * i + (ptrdiff_t)j * 3 +
-                          1) = *pData++;  // G
-                        *(pOut + (ptrdiff_t)img.pitch * i + (ptrdiff_t)j * 3) =
-                            *pData++;  // R
-                    } break;
-                    case 32: {
-                        assert(alpha_depth == 8);
-                        *(pOut + (ptrdiff_t)img.pitch * i + (ptrdiff_t)j * 4 +
-                          3) = *pData++;  // A
-                        *(pOut + (ptrdiff_t)img.pitch * i + (ptrdiff_t)j * 4 +
-                          2) = *pData++;  // B
-                        *(pOut + (ptrdiff_t)img.pitch * i + (ptrdiff_t)j * 4 +
-                          1) = *pData++;  // G
-                        *(pOut + (ptrdiff_t)img.pitch * i + (ptrdiff_t)j * 4) =
-                            *pData++;  // R
+                        pPixel[2] = *pData++;  // B
+                        pPixel[1] = *pData++;  // G
+                        pPixel[0] = *pData++;  // R
                     } break;
                     default:;
                 }
@@ -144,5 +149,8 @@ class TgaParser : _implements_ ImageParser {
 
         return img;
     }
+
+   private:
+    PixelLayout m_Layout;
 };
 }  // namespace My
@@ -705,11 +705,23 @@ static DXGI_FORMAT getDxgiFormat(const Image& img) {
                 format = ::DXGI_FORMAT_BC1_UNORM;
                 break;
             case "DXT3"_u32:
-                format = ::DXGI_FORMAT_BC3_UNORM;
+                format = ::DXGI_FORMAT_BC2_UNORM;
                 break;
             case "DXT5"_u32:
+                format = ::DXGI_FORMAT_BC3_UNORM;
+                break;
+            case "ATI1"_u32:
+                format = ::DXGI_FORMAT_BC4_UNORM;
+                break;
+            case "ATI2"_u32:
                 format = ::DXGI_FORMAT_BC5_UNORM;
                 break;
+            case "BC6H"_u32:
+                format = ::DXGI_FORMAT_BC6H_UF16;
+                break;
+            case "BC7U"_u32:
+                format = ::DXGI_FORMAT_BC7_UNORM;
+                break;
             default:
                 assert(0);
         }
@@ -750,8 +762,11 @@ int32_t D3d12GraphicsManager::CreateTextureBuffer(SceneObjectTexture& texture) {
 
     DXGI_FORMAT format = getDxgiFormat(*pImage);
 
+    // the levels built at load or cooked into the file
+    const auto mip_levels = static_cast<UINT16>(pImage->mipmaps.size());
+
     D3D12_RESOURCE_DESC textureDesc = {};
-    textureDesc.MipLevels = 1;
+    textureDesc.MipLevels = mip_levels;
     textureDesc.Format = format;
     textureDesc.Width = pImage->Width;
     textureDesc.Height = pImage->Height;
@@ -800,15 +815,21 @@ int32_t D3d12GraphicsManager::CreateTextureBuffer(SceneObjectTexture& texture) {
 
     // Copy data to the intermediate upload heap and then schedule a copy
     // from the upload heap to the Texture2D.
-    D3D12_SUBRESOURCE_DATA textureData = {};
-    textureData.pData = pImage->data;
-    textureData.RowPitch = pImage->pitch;
-    textureData.SlicePitch = static_cast<uint64_t>(pImage->pitch) *
-                             static_cast<uint64_t>(pImage->Height);
+    std::vector<D3D12_SUBRESOURCE_DATA> textureData(mip_levels);
+    for (UINT16 level = 0; level < mip_levels; level++) {
+        const auto& mip = pImage->mipmaps[level];
+        textureData[level].pData = pImage->data + mip.offset;
+        textureData[level].RowPitch = mip.pitch;
+        // rows of blocks for compressed images
+        textureData[level].SlicePitch = mip.data_size;
+    }
 
     UpdateSubresources(m_pCommandList[m_nFrameIndex], pTextureBuffer,
                        pTextureUploadHeap, 0, 0, subresourceCount,
-                       &textureData);
+                       textureData.data());
+    // copied to the upload heap, the CPU image is no longer needed
+    texture.MarkUploaded();
+
     D3D12_RESOURCE_BARRIER barrier = {};
     barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
     barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
@@ -1659,6 +1680,9 @@ void D3d12GraphicsManager::EndFrame(const Frame&) {
                                              ppCommandLists);
 
         WaitForPreviousFrame();
+
+        // the arena was last used kMaxInFlightFrameCount frames ago
+        m_FrameAllocators[m_nFrameIndex].Rewind();
     }
 
     ResetCommandList();
@@ -129,11 +129,23 @@ static MTLPixelFormat getMtlPixelFormat(const Image& img) {
                 format = MTLPixelFormatBC1_RGBA;
                 break;
             case "DXT3"_u32:
-                format = MTLPixelFormatBC3_RGBA;
+                format = MTLPixelFormatBC2_RGBA;
                 break;
             case "DXT5"_u32:
+                format = MTLPixelFormatBC3_RGBA;
+                break;
+            case "ATI1"_u32:
+                format = MTLPixelFormatBC4_RUnorm;
+                break;
+            case "ATI2"_u32:
                 format = MTLPixelFormatBC5_RGUnorm;
                 break;
+            case "BC6H"_u32:
+                format = MTLPixelFormatBC6H_RGBUfloat;
+                break;
+            case "BC7U"_u32:
+                format = MTLPixelFormatBC7_RGBAUnorm;
+                break;
             default:
                 std::cerr << img << std::endl;
                 assert(0);
@@ -175,21 +187,41 @@ static MTLPixelFormat getMtlPixelFormat(const Image& img) {
     id<MTLTexture> texture;
     MTLTextureDescriptor* textureDesc = [[MTLTextureDescriptor alloc] init];
 
+    // the levels built at load, compressed images upload their top one
+    const size_t mip_levels =
+        image.compressed ? 1 : std::max(image.mipmaps.size(), (size_t)1);
+
     textureDesc.pixelFormat = getMtlPixelFormat(image);
     textureDesc.width = image.Width;
     textureDesc.height = image.Height;
+    textureDesc.mipmapLevelCount = mip_levels;
 
     // create the texture obj
     texture = [_device newTextureWithDescriptor:textureDesc];
     [textureDesc release];
 
     // now upload the data
-    MTLRegion region = {
-        {0, 0, 0},                      // MTLOrigin
-        {image.Width, image.Height, 1}  // MTLSize
-    };
+    if (image.mipmaps.empty()) {
+        MTLRegion region = {
+            {0, 0, 0},                      // MTLOrigin
+            {image.Width, image.Height, 1}  // MTLSize
+        };
+
+        [texture replaceRegion:region mipmapLevel:0 withBytes:image.data bytesPerRow:image.pitch];
+    } else {
+        for (size_t level = 0; level < mip_levels; level++) {
+            const auto& mip = image.mipmaps[level];
+            MTLRegion region = {
+                {0, 0, 0},                      // MTLOrigin
+                {mip.Width, mip.Height, 1}      // MTLSize
+            };
 
-    [texture replaceRegion:region mipmapLevel:0 withBytes:image.data bytesPerRow:image.pitch];
+            [texture replaceRegion:region
+                       mipmapLevel:level
+                         withBytes:image.data + mip.offset
+                       bytesPerRow:mip.pitch];
+        }
+    }
 
     uint32_t index;
     if (!_texture_recycled_indexes.empty()) {
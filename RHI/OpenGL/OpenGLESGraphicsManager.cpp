@@ -70,6 +70,26 @@ void OpenGLESGraphicsManager::getOpenGLTextureFormat(const Image& img,
                 format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
                 internal_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
                 break;
+#ifdef GL_COMPRESSED_RED_RGTC1_EXT
+            case "ATI1"_u32:
+                format = GL_COMPRESSED_RED_RGTC1_EXT;
+                internal_format = GL_COMPRESSED_RED_RGTC1_EXT;
+                break;
+            case "ATI2"_u32:
+                format = GL_COMPRESSED_RED_GREEN_RGTC2_EXT;
+                internal_format = GL_COMPRESSED_RED_GREEN_RGTC2_EXT;
+                break;
+#endif
+#ifdef GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_EXT
+            case "BC6H"_u32:
+                format = GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_EXT;
+                internal_format = GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_EXT;
+                break;
+            case "BC7U"_u32:
+                format = GL_COMPRESSED_RGBA_BPTC_UNORM_EXT;
+                internal_format = GL_COMPRESSED_RGBA_BPTC_UNORM_EXT;
+                break;
+#endif
             default:
                 assert(0);
         }
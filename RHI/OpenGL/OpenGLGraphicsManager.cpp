@@ -173,6 +173,18 @@ void OpenGLGraphicsManager::getOpenGLTextureFormat(const Image& img,
             case "DXT5"_u32:
                 internal_format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
                 break;
+            case "ATI1"_u32:
+                internal_format = GL_COMPRESSED_RED_RGTC1;
+                break;
+            case "ATI2"_u32:
+                internal_format = GL_COMPRESSED_RG_RGTC2;
+                break;
+            case "BC6H"_u32:
+                internal_format = GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+                break;
+            case "BC7U"_u32:
+                internal_format = GL_COMPRESSED_RGBA_BPTC_UNORM;
+                break;
             default:
                 assert(0);
         }
@@ -296,121 +296,119 @@ void OpenGLGraphicsManagerCommonBase::initializeGeometries(const Scene& scene) {
                     pGeometryNode->GetMaterialRef(material_index);
                 const auto material = scene.GetMaterial(material_key);
                 if (material) {
-                    function<uint32_t(const string, const shared_ptr<Image>&)>
-                        upload_texture = [this](
-                                             const string& texture_key,
-                                             const shared_ptr<Image>& texture) {
-                            uint32_t texture_id;
-                            auto it = m_Textures.find(texture_key);
-                            if (it == m_Textures.end()) {
-                                glGenTextures(1, &texture_id);
-                                glBindTexture(GL_TEXTURE_2D, texture_id);
-                                uint32_t format, internal_format, type;
-                                getOpenGLTextureFormat(*texture, format,
-                                                       internal_format, type);
-                                if (texture->compressed) {
-                                    glCompressedTexImage2D(
-                                        GL_TEXTURE_2D, 0, internal_format,
-                                        texture->Width, texture->Height, 0,
-                                        static_cast<int32_t>(
-                                            texture->data_size),
-                                        texture->data);
+                    function<uint32_t(const shared_ptr<SceneObjectTexture>&)>
+                        upload_texture =
+                            [this](const shared_ptr<SceneObjectTexture>&
+                                       texture) {
+                                uint32_t texture_id;
+                                // one GL texture per decoding of a file,
+                                // sRGB, linear and R8 ones apart
+                                const auto& texture_key = texture->GetKey();
+                                auto it = m_Textures.find(texture_key);
+                                if (it == m_Textures.end()) {
+                                    const auto& image =
+                                        texture->GetTextureImage();
+                                    glGenTextures(1, &texture_id);
+                                    glBindTexture(GL_TEXTURE_2D, texture_id);
+                                    // only the levels streamed so far, the
+                                    // smallest ones at first
+                                    auto levels = static_cast<uint32_t>(
+                                        image->mipmaps.size());
+                                    auto first = min(texture->GetStreamedMip(),
+                                                     levels - 1);
+                                    uploadTextureLevels(*image, first, levels);
+
+                                    glTexParameteri(GL_TEXTURE_2D,
+                                                    GL_TEXTURE_WRAP_S,
+                                                    GL_REPEAT);
+                                    glTexParameteri(GL_TEXTURE_2D,
+                                                    GL_TEXTURE_WRAP_T,
+                                                    GL_REPEAT);
+                                    glTexParameteri(GL_TEXTURE_2D,
+                                                    GL_TEXTURE_MAG_FILTER,
+                                                    GL_LINEAR);
+                                    glTexParameteri(GL_TEXTURE_2D,
+                                                    GL_TEXTURE_MIN_FILTER,
+                                                    GL_LINEAR_MIPMAP_LINEAR);
+                                    // levels not built at load are left to
+                                    // the driver
+                                    if (levels == 1) {
+                                        glGenerateMipmap(GL_TEXTURE_2D);
+                                    } else {
+                                        glTexParameteri(GL_TEXTURE_2D,
+                                                        GL_TEXTURE_MAX_LEVEL,
+                                                        levels - 1);
+                                        StreamedTexture streamed;
+                                        streamed.texture = texture;
+                                        streamed.id = texture_id;
+                                        streamed.baseLevel = first;
+                                        streamed.compressed =
+                                            image->compressed;
+                                        getOpenGLTextureFormat(
+                                            *image, streamed.format,
+                                            streamed.internalFormat,
+                                            streamed.type);
+                                        m_StreamedTextures.push_back(
+                                            std::move(streamed));
+                                    }
+
+                                    glBindTexture(GL_TEXTURE_2D, 0);
+
+                                    // with only the tail up, the CPU image
+                                    // is kept for the finer levels, which
+                                    // streamTextures marks once they are up
+                                    if (first == 0) {
+                                        texture->MarkUploaded();
+                                    }
+
+                                    m_Textures[texture_key] = texture_id;
                                 } else {
-                                    glTexImage2D(
-                                        GL_TEXTURE_2D, 0, internal_format,
-                                        texture->Width, texture->Height, 0,
-                                        format, type, texture->data);
+                                    texture_id = it->second;
                                 }
 
-                                glTexParameteri(GL_TEXTURE_2D,
-                                                GL_TEXTURE_WRAP_S, GL_REPEAT);
-                                glTexParameteri(GL_TEXTURE_2D,
-                                                GL_TEXTURE_WRAP_T, GL_REPEAT);
-                                glTexParameteri(GL_TEXTURE_2D,
-                                                GL_TEXTURE_MAG_FILTER,
-                                                GL_LINEAR);
-                                glTexParameteri(GL_TEXTURE_2D,
-                                                GL_TEXTURE_MIN_FILTER,
-                                                GL_LINEAR_MIPMAP_LINEAR);
-                                glGenerateMipmap(GL_TEXTURE_2D);
-
-                                glBindTexture(GL_TEXTURE_2D, 0);
-
-                                m_Textures[texture_key] = texture_id;
-                            } else {
-                                texture_id = it->second;
-                            }
-
-                            return texture_id;
-                        };
+                                return texture_id;
+                            };
 
                     // base color / albedo
                     const auto& color = material->GetBaseColor();
                     if (color.ValueMap) {
-                        const auto& texture_key = color.ValueMap->GetName();
-                        const auto& texture = color.ValueMap->GetTextureImage();
-                        uint32_t texture_id =
-                            upload_texture(texture_key, texture);
-                        dbc->material.diffuseMap =
-                            static_cast<int32_t>(texture_id);
+                        dbc->material.diffuseMap = static_cast<int32_t>(
+                            upload_texture(color.ValueMap));
                     }
 
                     // normal
                     const auto& normal = material->GetNormal();
                     if (normal.ValueMap) {
-                        const auto& texture_key = normal.ValueMap->GetName();
-                        const auto& texture =
-                            normal.ValueMap->GetTextureImage();
-                        uint32_t texture_id =
-                            upload_texture(texture_key, texture);
-                        dbc->material.normalMap =
-                            static_cast<int32_t>(texture_id);
+                        dbc->material.normalMap = static_cast<int32_t>(
+                            upload_texture(normal.ValueMap));
                     }
 
                     // metallic
                     const auto& metallic = material->GetMetallic();
                     if (metallic.ValueMap) {
-                        const auto& texture_key = metallic.ValueMap->GetName();
-                        const auto& texture =
-                            metallic.ValueMap->GetTextureImage();
-                        uint32_t texture_id =
-                            upload_texture(texture_key, texture);
-                        dbc->material.metallicMap =
-                            static_cast<int32_t>(texture_id);
+                        dbc->material.metallicMap = static_cast<int32_t>(
+                            upload_texture(metallic.ValueMap));
                     }
 
                     // roughness
                     const auto& roughness = material->GetRoughness();
                     if (roughness.ValueMap) {
-                        const auto& texture_key = roughness.ValueMap->GetName();
-                        const auto& texture =
-                            roughness.ValueMap->GetTextureImage();
-                        uint32_t texture_id =
-                            upload_texture(texture_key, texture);
-                        dbc->material.roughnessMap =
-                            static_cast<int32_t>(texture_id);
+                        dbc->material.roughnessMap = static_cast<int32_t>(
+                            upload_texture(roughness.ValueMap));
                     }
 
                     // ao
                     const auto& ao = material->GetAO();
                     if (ao.ValueMap) {
-                        const auto& texture_key = ao.ValueMap->GetName();
-                        const auto& texture = ao.ValueMap->GetTextureImage();
-                        uint32_t texture_id =
-                            upload_texture(texture_key, texture);
-                        dbc->material.aoMap = static_cast<int32_t>(texture_id);
+                        dbc->material.aoMap = static_cast<int32_t>(
+                            upload_texture(ao.ValueMap));
                     }
 
                     // height map
                     const auto& heightmap = material->GetHeight();
                     if (heightmap.ValueMap) {
-                        const auto& texture_key = heightmap.ValueMap->GetName();
-                        const auto& texture =
-                            heightmap.ValueMap->GetTextureImage();
-                        uint32_t texture_id =
-                            upload_texture(texture_key, texture);
-                        dbc->material.heightMap =
-                            static_cast<int32_t>(texture_id);
+                        dbc->material.heightMap = static_cast<int32_t>(
+                            upload_texture(heightmap.ValueMap));
                     }
                 }
 
@@ -432,6 +430,88 @@ void OpenGLGraphicsManagerCommonBase::initializeGeometries(const Scene& scene) {
     }
 }
 
+void OpenGLGraphicsManagerCommonBase::uploadTextureLevels(const Image& image,
+                                                          uint32_t first,
+                                                          uint32_t end) {
+    uint32_t format, internal_format, type;
+    getOpenGLTextureFormat(image, format, internal_format, type);
+    // rows of single channel mips are not padded to 4 bytes
+    int32_t unpack_alignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_alignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    for (uint32_t level = first; level < end; level++) {
+        const auto& mip = image.mipmaps[level];
+        if (image.compressed) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<int32_t>(level),
+                                   internal_format, mip.Width, mip.Height, 0,
+                                   static_cast<int32_t>(mip.data_size),
+                                   image.data + mip.offset);
+        } else {
+            glTexImage2D(GL_TEXTURE_2D, static_cast<int32_t>(level),
+                         internal_format, mip.Width, mip.Height, 0, format,
+                         type, image.data + mip.offset);
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL,
+                    static_cast<int32_t>(first));
+}
+
+void OpenGLGraphicsManagerCommonBase::streamTextures() {
+    // what is uploaded in a frame, at least one level. the finer levels
+    // wait for the next frames.
+    size_t upload_budget = kStreamUploadBytesPerFrame;
+
+    for (auto& streamed : m_StreamedTextures) {
+        uint32_t wanted = streamed.texture->GetStreamedMip();
+        if (wanted > streamed.baseLevel) {
+            // levels no longer streamed give their memory back
+            glBindTexture(GL_TEXTURE_2D, streamed.id);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL,
+                            static_cast<int32_t>(wanted));
+            for (uint32_t level = streamed.baseLevel; level < wanted;
+                 level++) {
+                if (streamed.compressed) {
+                    glCompressedTexImage2D(
+                        GL_TEXTURE_2D, static_cast<int32_t>(level),
+                        streamed.internalFormat, 0, 0, 0, 0, nullptr);
+                } else {
+                    glTexImage2D(GL_TEXTURE_2D, static_cast<int32_t>(level),
+                                 streamed.internalFormat, 0, 0, 0,
+                                 streamed.format, streamed.type, nullptr);
+                }
+            }
+            glBindTexture(GL_TEXTURE_2D, 0);
+            streamed.baseLevel = wanted;
+        } else if (wanted < streamed.baseLevel && upload_budget) {
+            // read and decoded in the background, uploaded once it is done
+            auto image = streamed.texture->TryGetTextureImage();
+            if (!image) continue;
+
+            // coarse levels first, the texture sharpens over a few frames
+            uint32_t level = streamed.baseLevel;
+            while (level > wanted && upload_budget) {
+                level--;
+                upload_budget -=
+                    min(upload_budget, image->mipmaps[level].data_size);
+            }
+
+            glBindTexture(GL_TEXTURE_2D, streamed.id);
+            uploadTextureLevels(*image, level, streamed.baseLevel);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            streamed.baseLevel = level;
+
+            // the CPU image is kept until the levels wanted are all up,
+            // evicting it earlier would read and decode it again next frame
+            if (streamed.baseLevel == wanted) {
+                streamed.texture->MarkUploaded();
+            }
+        }
+    }
+}
+
 void OpenGLGraphicsManagerCommonBase::initializeSkyBox(const Scene& scene) {
     // load skybox, irradiance map and radiance map
     uint32_t texture_id;
@@ -482,6 +562,8 @@ void OpenGLGraphicsManagerCommonBase::initializeSkyBox(const Scene& scene) {
             glTexSubImage3D(target, level, 0, 0, zoffset, pImage->Width,
                             pImage->Height, 1, format, type, pImage->data);
         }
+
+        texture.MarkUploaded();
     }
 
     // radiance map
@@ -507,6 +589,8 @@ void OpenGLGraphicsManagerCommonBase::initializeSkyBox(const Scene& scene) {
                                 pImage->data + pImage->mipmaps[level].offset);
             }
         }
+
+        texture.MarkUploaded();
     }
 
     m_Textures["SkyBox"] = texture_id;
@@ -553,7 +637,7 @@ void OpenGLGraphicsManagerCommonBase::initializeTerrain(const Scene& scene) {
     glGenBuffers(2, terrainVBO);
     glBindVertexArray(terrainVAO);
 
-    static const float patch_size = 32.0f;
+    static const float patch_size = SceneObjectTerrain::kPatchSize;
     static const float _vertices[] = {0.0f, patch_size, 0.0f,       0.0f,
                                       0.0f, 0.0f,       patch_size, 0.0f,
                                       0.0f, patch_size, patch_size, 0.0f};
@@ -579,35 +663,93 @@ void OpenGLGraphicsManagerCommonBase::initializeTerrain(const Scene& scene) {
     m_TerrainDrawBatchContext.type = GL_UNSIGNED_BYTE;
     m_TerrainDrawBatchContext.count = sizeof(_index) / sizeof(_index[0]);
 
-    uint32_t texture_id;
-    glGenTextures(1, &texture_id);
-    glBindTexture(GL_TEXTURE_2D, texture_id);
-
-    auto& texture = scene.Terrain->GetTexture(0);
-    const auto& pImage = texture.GetTextureImage();
+    // the cache slot of every page of the height map, or -1. the cache
+    // itself is made once the first page is filled.
+    const auto& virtual_texture = *m_pTerrainVirtualTexture;
+    uint32_t page_table;
+    glGenTextures(1, &page_table);
+    glBindTexture(GL_TEXTURE_2D, page_table);
+    int32_t unpack_alignment;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_alignment);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32I, virtual_texture.GetWidth(),
+                 virtual_texture.GetHeight(), 0, GL_RED_INTEGER, GL_INT,
+                 virtual_texture.GetPageTable().data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
 
-    uint32_t format, internal_format, type;
-    getOpenGLTextureFormat(*pImage, format, internal_format, type);
-    if (pImage->compressed) {
-        glCompressedTexImage2D(
-            GL_TEXTURE_2D, 0, internal_format, pImage->Width, pImage->Height, 0,
-            static_cast<int32_t>(pImage->data_size), pImage->data);
-    } else {
-        glTexImage2D(GL_TEXTURE_2D, 0, internal_format, pImage->Width,
-                     pImage->Height, 0, format, type, pImage->data);
-    }
+    m_Textures["TerrainPageTable"] = page_table;
+}
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+void OpenGLGraphicsManagerCommonBase::updateTerrainTexture() {
+    if (!m_pTerrainVirtualTexture) return;
+    auto& virtual_texture = *m_pTerrainVirtualTexture;
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    auto slots = virtual_texture.TakeDirtySlots();
+    if (!slots.empty()) {
+        const auto& cache = virtual_texture.GetCache();
+        uint32_t format, internal_format, type;
+        getOpenGLTextureFormat(cache, format, internal_format, type);
+
+        uint32_t texture_id;
+        auto it = m_Textures.find("Terrain");
+        if (it == m_Textures.end()) {
+            glGenTextures(1, &texture_id);
+            glBindTexture(GL_TEXTURE_2D, texture_id);
+            glTexImage2D(GL_TEXTURE_2D, 0, internal_format, cache.Width,
+                         cache.Height, 0, format, type, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S,
+                            GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T,
+                            GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+            m_Textures["Terrain"] = texture_id;
+            for (auto& frame : m_Frames) {
+                frame.terrainHeightMap = static_cast<int32_t>(texture_id);
+            }
+        } else {
+            texture_id = it->second;
+            glBindTexture(GL_TEXTURE_2D, texture_id);
+        }
 
-    m_Textures["Terrain"] = texture_id;
+        // only the pages filled, out of the rows of the whole cache
+        const uint32_t page_size = virtual_texture.GetSettings().pageSize;
+        const uint32_t cache_width = virtual_texture.GetSettings().cacheWidth;
+        const size_t pixel_size = cache.bitcount >> 3;
+        int32_t unpack_alignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<int32_t>(cache.Width));
+        for (auto slot : slots) {
+            uint32_t x = slot % cache_width * page_size;
+            uint32_t y = slot / cache_width * page_size;
+            glTexSubImage2D(GL_TEXTURE_2D, 0, static_cast<int32_t>(x),
+                            static_cast<int32_t>(y), page_size, page_size,
+                            format, type,
+                            cache.data + y * cache.pitch + x * pixel_size);
+        }
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
 
-    for (int32_t i = 0; i < GfxConfiguration::kMaxInFlightFrameCount; i++) {
-        m_Frames[i].terrainHeightMap = texture_id;
+    if (virtual_texture.IsPageTableDirty()) {
+        glBindTexture(GL_TEXTURE_2D, m_Textures["TerrainPageTable"]);
+        int32_t unpack_alignment;
+        glGetIntegerv(GL_UNPACK_ALIGNMENT, &unpack_alignment);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, virtual_texture.GetWidth(),
+                        virtual_texture.GetHeight(), GL_RED_INTEGER, GL_INT,
+                        virtual_texture.GetPageTable().data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, unpack_alignment);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        virtual_texture.ClearPageTableDirty();
     }
 }
 
@@ -678,6 +820,7 @@ void OpenGLGraphicsManagerCommonBase::EndScene() {
 
     m_Buffers.clear();
     m_Textures.clear();
+    m_StreamedTextures.clear();
 
     GraphicsManager::EndScene();
 }
@@ -690,6 +833,9 @@ void OpenGLGraphicsManagerCommonBase::BeginFrame(const Frame& frame) {
 
     SetPerFrameConstants(frame.frameContext);
     SetLightInfo(frame.lightInfo);
+
+    streamTextures();
+    updateTerrainTexture();
 }
 
 void OpenGLGraphicsManagerCommonBase::EndFrame(const Frame& frame) {
@@ -1159,15 +1305,16 @@ void OpenGLGraphicsManagerCommonBase::DrawTerrain() {
 
     glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
-    const float patch_size = 32.0f;
+    const float patch_size = SceneObjectTerrain::kPatchSize;
+    const float origin = SceneObjectTerrain::kGridOrigin;
     const int32_t patch_num_row = 10;
     const int32_t patch_num_col = 10;
 
-    for (int32_t i = -patch_num_row / 2; i < patch_num_row / 2; i++)
+    for (int32_t i = 0; i < patch_num_row; i++)
     {
-        for (int32_t j = -patch_num_col / 2; j < patch_num_col / 2; j++)
+        for (int32_t j = 0; j < patch_num_col; j++)
         {
-            MatrixTranslation(m_TerrainDrawBatchContext.modelMatrix, patch_size * i, patch_size * j, 0.0f);
+            MatrixTranslation(m_TerrainDrawBatchContext.modelMatrix, origin + patch_size * i, origin + patch_size * j, 0.0f);
             glDrawElements(m_TerrainDrawBatchContext.mode, m_TerrainDrawBatchContext.count, m_TerrainDrawBatchContext.type, 0x00);
         }
     }
@@ -1374,22 +1521,20 @@ void OpenGLGraphicsManagerCommonBase::DrawPointSet(const PointSet& point_set,
                                                    const Matrix4X4f& trans,
                                                    const Vector3f& color) {
     const auto count = point_set.size();
-    auto* buffer = new Point[count];
+    auto* buffer = GetFrameAllocator().AllocateArray<Point>(count);
     int i = 0;
     for (const auto& point_ptr : point_set) {
-        buffer[i++] = *point_ptr;
+        new (&buffer[i++]) Point(*point_ptr);
     }
 
     drawPoints(buffer, count, trans, color);
-
-    delete[] buffer;
 }
 
 void OpenGLGraphicsManagerCommonBase::DrawLine(const PointList& vertices,
                                                const Matrix4X4f& trans,
                                                const Vector3f& color) {
     const auto count = vertices.size();
-    auto* _vertices = new GLfloat[3 * count];
+    auto* _vertices = GetFrameAllocator().AllocateArray<GLfloat>(3 * count);
 
     for (auto i = 0; i < count; i++) {
         _vertices[3 * i] = vertices[i]->data[0];
@@ -1415,8 +1560,6 @@ void OpenGLGraphicsManagerCommonBase::DrawLine(const PointList& vertices,
     glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 3 * count, _vertices,
                  GL_STATIC_DRAW);
 
-    delete[] _vertices;
-
     glEnableVertexAttribArray(0);
 
     glVertexAttribPointer(0, 3, GL_FLOAT, false, 0, nullptr);
@@ -1480,13 +1623,12 @@ void OpenGLGraphicsManagerCommonBase::DrawTriangle(const PointList& vertices,
     // Bind the vertex buffer and load the vertex (position and color) data into
     // the vertex buffer.
     glBindBuffer(GL_ARRAY_BUFFER, buffer_id);
-    auto* data = new Vector3f[count];
+    auto* data = GetFrameAllocator().AllocateArray<Vector3f>(count);
     for (auto i = 0; i < count; i++) {
-        data[i] = *vertices[i];
+        new (&data[i]) Vector3f(*vertices[i]);
     }
     glBufferData(GL_ARRAY_BUFFER, sizeof(Vector3f) * count, data,
                  GL_STATIC_DRAW);
-    delete[] data;
 
     glEnableVertexAttribArray(0);
 
@@ -1524,13 +1666,12 @@ void OpenGLGraphicsManagerCommonBase::DrawTriangleStrip(
     // Bind the vertex buffer and load the vertex (position and color) data into
     // the vertex buffer.
     glBindBuffer(GL_ARRAY_BUFFER, buffer_id);
-    auto* data = new Vector3f[count];
+    auto* data = GetFrameAllocator().AllocateArray<Vector3f>(count);
     for (auto i = 0; i < count; i++) {
-        data[i] = *vertices[i];
+        new (&data[i]) Vector3f(*vertices[i]);
     }
     glBufferData(GL_ARRAY_BUFFER, sizeof(Vector3f) * count, data,
                  GL_STATIC_DRAW);
-    delete[] data;
 
     glEnableVertexAttribArray(0);
 
@@ -120,6 +120,15 @@ class OpenGLGraphicsManagerCommonBase : public GraphicsManager {
                                         uint32_t& internal_format,
                                         uint32_t& type) = 0;
 
+    // uploads levels first to end - 1 to the bound texture, first becoming
+    // its base level
+    void uploadTextureLevels(const Image& image, uint32_t first,
+                             uint32_t end);
+    // brings the mips on the GPU to what the streaming asks for
+    void streamTextures();
+    // uploads the terrain pages filled since the last frame
+    void updateTerrainTexture();
+
    private:
     uint32_t m_ShadowMapFramebufferName;
     uint32_t m_CurrentShader;
@@ -150,6 +159,21 @@ class OpenGLGraphicsManagerCommonBase : public GraphicsManager {
 
     std::vector<uint32_t> m_Buffers;
 
+    // the material textures whose mips are streamed, and the finest level
+    // each holds
+    struct StreamedTexture {
+        std::shared_ptr<SceneObjectTexture> texture;
+        uint32_t id;
+        uint32_t baseLevel;
+        // what the levels freed are specified with
+        bool compressed;
+        uint32_t format;
+        uint32_t internalFormat;
+        uint32_t type;
+    };
+    std::vector<StreamedTexture> m_StreamedTextures;
+    static constexpr size_t kStreamUploadBytesPerFrame = 16 * 1024 * 1024;
+
 #ifdef DEBUG
     std::vector<DebugDrawBatchContext> m_DebugDrawBatchContext;
     std::vector<uint32_t> m_DebugBuffers;
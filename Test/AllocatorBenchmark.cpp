@@ -0,0 +1,337 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BlockAllocator.hpp"
+#include "MemoryManager.hpp"
+#include "StackAllocator.hpp"
+
+#if defined(OS_WINDOWS)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#define PSAPI_VERSION 2
+#include <psapi.h>
+#elif defined(OS_MACOS)
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace My;
+
+namespace My {
+IMemoryManager* g_pMemoryManager = new MemoryManager();
+}  // namespace My
+
+// usage: AllocatorBenchmark [--json <file>] [--quick]
+
+static size_t s_nCount = 1 << 16;
+static size_t s_nRounds = 16;
+static const size_t kThreadCount = 4;
+static const size_t kBlockSize = 64;
+static const size_t kPageSize = 32768;
+static const size_t kMaxMixedSize = 4096;
+
+// resident set size of the process in bytes
+static size_t GetResidentSize() {
+#if defined(OS_WINDOWS)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                             sizeof(counters))) {
+        return counters.WorkingSetSize;
+    }
+    return 0;
+#elif defined(OS_MACOS)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO,
+                  reinterpret_cast<task_info_t>(&info),
+                  &count) == KERN_SUCCESS) {
+        return info.resident_size;
+    }
+    return 0;
+#else
+    size_t pages = 0, resident = 0;
+    ifstream statm("/proc/self/statm");
+    if (statm >> pages >> resident) {
+        return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+    return 0;
+#endif
+}
+
+// an allocator under test
+struct Subject {
+    string name;
+    function<void*(size_t)> allocate;
+    function<void(void*, size_t)> free;
+    // true when allocate takes any size up to kMaxMixedSize
+    bool mixedSizes;
+    // true when allocate and free may be called from any thread
+    bool threadSafe;
+};
+
+struct Result {
+    string allocator;
+    string pattern;
+    double nsPerOp;
+    size_t operations;
+    size_t residentSize;
+};
+
+using Clock = chrono::steady_clock;
+
+static double Elapsed(Clock::time_point start) {
+    return chrono::duration<double, nano>(Clock::now() - start).count();
+}
+
+// allocates a block for each entry of order, then frees them in that
+// order
+static Result FreeInOrder(const Subject& subject, const string& pattern,
+                          const vector<size_t>& order,
+                          const vector<size_t>& sizes) {
+    size_t count = order.size();
+    vector<void*> blocks(count);
+
+    auto run = [&] {
+        for (size_t i = 0; i < count; i++) {
+            blocks[i] = subject.allocate(sizes[i]);
+            // touch it, an untouched block costs nothing
+            *static_cast<volatile uint8_t*>(blocks[i]) = 0;
+        }
+        for (size_t i : order) {
+            subject.free(blocks[i], sizes[i]);
+        }
+    };
+
+    // warm up, so the first pattern does not pay for the page faults
+    run();
+
+    auto start = Clock::now();
+    for (size_t round = 0; round < s_nRounds; round++) {
+        run();
+    }
+    double elapsed = Elapsed(start);
+
+    size_t operations = 2 * count * s_nRounds;
+    return {subject.name, pattern, elapsed / operations, operations,
+            GetResidentSize()};
+}
+
+// half of the threads allocate count blocks per round in batches, the
+// other half frees them
+static Result ProducerConsumer(const Subject& subject, size_t count,
+                               const vector<size_t>& sizes) {
+    mutex queue_mutex;
+    condition_variable queue_cv;
+    deque<vector<void*>> queue;
+    size_t producers_running = kThreadCount / 2;
+    const size_t batch_size = min<size_t>(1024, count);
+
+    auto start = Clock::now();
+
+    vector<thread> workers;
+    for (size_t t = 0; t < kThreadCount / 2; t++) {
+        workers.emplace_back([&] {
+            for (size_t round = 0; round < s_nRounds; round++) {
+                for (size_t i = 0; i + batch_size <= count;
+                     i += batch_size) {
+                    vector<void*> batch(batch_size);
+                    for (size_t j = 0; j < batch_size; j++) {
+                        batch[j] = subject.allocate(sizes[j]);
+                        *static_cast<volatile uint8_t*>(batch[j]) = 0;
+                    }
+
+                    lock_guard<mutex> lock(queue_mutex);
+                    queue.push_back(std::move(batch));
+                    queue_cv.notify_one();
+                }
+            }
+
+            lock_guard<mutex> lock(queue_mutex);
+            producers_running--;
+            queue_cv.notify_all();
+        });
+    }
+
+    for (size_t t = 0; t < kThreadCount / 2; t++) {
+        workers.emplace_back([&] {
+            while (true) {
+                vector<void*> batch;
+                {
+                    unique_lock<mutex> lock(queue_mutex);
+                    queue_cv.wait(lock, [&] {
+                        return !queue.empty() || producers_running == 0;
+                    });
+                    if (queue.empty()) break;
+                    batch = std::move(queue.front());
+                    queue.pop_front();
+                }
+
+                for (size_t j = 0; j < batch.size(); j++) {
+                    subject.free(batch[j], sizes[j]);
+                }
+            }
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    double elapsed = Elapsed(start);
+
+    size_t operations =
+        2 * (count / batch_size * batch_size) * s_nRounds * (kThreadCount / 2);
+    return {subject.name, "mt_producer_consumer", elapsed / operations,
+            operations, GetResidentSize()};
+}
+
+// the stack allocator has no individual free, it is rewound per round
+static Result StackRewind(const string& pattern, const vector<size_t>& sizes) {
+    StackAllocator allocator(256 * 1024, 8);
+
+    auto start = Clock::now();
+    for (size_t round = 0; round < s_nRounds; round++) {
+        for (size_t i = 0; i < s_nCount; i++) {
+            void* p = allocator.Allocate(sizes[i]);
+            *static_cast<volatile uint8_t*>(p) = 0;
+        }
+        allocator.Rewind();
+    }
+    double elapsed = Elapsed(start);
+
+    size_t operations = s_nCount * s_nRounds;
+    return {"StackAllocator", pattern, elapsed / operations, operations,
+            GetResidentSize()};
+}
+
+static void PrintTable(const vector<Result>& results) {
+    cout << left << setw(16) << "Allocator" << setw(24) << "Pattern" << right
+         << setw(12) << "ns/op" << setw(14) << "ops" << setw(14) << "RSS (KiB)"
+         << endl;
+    for (const auto& result : results) {
+        cout << left << setw(16) << result.allocator << setw(24)
+             << result.pattern << right << setw(12) << fixed
+             << setprecision(2) << result.nsPerOp << setw(14)
+             << result.operations << setw(14) << result.residentSize / 1024
+             << endl;
+    }
+}
+
+static void WriteJson(ostream& out, const vector<Result>& results) {
+    out << "{\n  \"count\": " << s_nCount << ",\n  \"rounds\": " << s_nRounds
+        << ",\n  \"threads\": " << kThreadCount << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& result = results[i];
+        out << "    {\"allocator\": \"" << result.allocator
+            << "\", \"pattern\": \"" << result.pattern
+            << "\", \"ns_per_op\": " << fixed << setprecision(3)
+            << result.nsPerOp << ", \"operations\": " << result.operations
+            << ", \"rss_bytes\": " << result.residentSize << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+int main(int argc, char** argv) {
+    const char* json_path = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--quick") == 0) {
+            s_nCount = 1 << 12;
+            s_nRounds = 2;
+        }
+    }
+
+    g_pMemoryManager->Initialize();
+
+    vector<Result> results;
+
+    {
+        BlockAllocator block_allocator(kBlockSize, kPageSize, 8);
+
+        vector<Subject> subjects = {
+            {"BlockAllocator",
+             [&](size_t) { return block_allocator.Allocate(); },
+             [&](void* p, size_t) { block_allocator.Free(p); }, false, true},
+            {"MemoryManager",
+             [](size_t size) { return g_pMemoryManager->Allocate(size); },
+             [](void* p, size_t size) { g_pMemoryManager->Free(p, size); },
+             true, true},
+            {"AllocatePage",
+             [](size_t) { return g_pMemoryManager->AllocatePage(kPageSize); },
+             [](void* p, size_t) { g_pMemoryManager->FreePage(p); }, false,
+             true},
+            {"malloc", [](size_t size) { return malloc(size); },
+             [](void* p, size_t) { free(p); }, true, true}};
+
+        mt19937 rng(42);
+
+        vector<size_t> fixed_sizes(s_nCount, kBlockSize);
+        vector<size_t> mixed_sizes(s_nCount);
+        uniform_int_distribution<size_t> size_distribution(1, kMaxMixedSize);
+        for (auto& size : mixed_sizes) size = size_distribution(rng);
+
+        for (const auto& subject : subjects) {
+            // a page per allocation, keep the working set sane
+            size_t count =
+                (subject.name == "AllocatePage") ? s_nCount / 16 : s_nCount;
+
+            vector<size_t> fifo(count);
+            for (size_t i = 0; i < count; i++) fifo[i] = i;
+            vector<size_t> lifo(fifo.rbegin(), fifo.rend());
+            vector<size_t> random(fifo);
+            shuffle(random.begin(), random.end(), rng);
+
+            results.push_back(FreeInOrder(subject, "lifo", lifo, fixed_sizes));
+            results.push_back(FreeInOrder(subject, "fifo", fifo, fixed_sizes));
+            results.push_back(
+                FreeInOrder(subject, "random", random, fixed_sizes));
+
+            if (subject.mixedSizes) {
+                results.push_back(
+                    FreeInOrder(subject, "mixed_random", random, mixed_sizes));
+            }
+
+            if (subject.threadSafe) {
+                results.push_back(ProducerConsumer(
+                    subject, count,
+                    subject.mixedSizes ? mixed_sizes : fixed_sizes));
+            }
+        }
+
+        results.push_back(StackRewind("rewind", fixed_sizes));
+        results.push_back(StackRewind("mixed_rewind", mixed_sizes));
+    }
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pMemoryManager;
+
+    PrintTable(results);
+
+    if (json_path) {
+        ofstream json(json_path);
+        WriteJson(json, results);
+        cout << "results written to " << json_path << endl;
+    }
+
+    return 0;
+}
@@ -1,5 +1,20 @@
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+
+#if !defined(OS_WINDOWS)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "AssetLoader.hpp"
 #include "MemoryManager.hpp"
@@ -24,6 +39,212 @@ int main(int, char**) {
 
     cout << shader_pgm;
 
+#if !defined(OS_WINDOWS)
+    {
+        // large files are mapped, they must read the same as in text mode
+        Buffer text = g_pAssetLoader->SyncOpenAndReadText("Scene/splash.ogex");
+        Buffer binary =
+            g_pAssetLoader->SyncOpenAndReadBinary("Scene/splash.ogex");
+        assert(binary.GetDataSize() + 1 == text.GetDataSize());
+        assert(memcmp(binary.GetData(), text.GetData(),
+                      binary.GetDataSize()) == 0);
+    }
+
+    {
+        // resolved paths are absolute, they outlive a change of the
+        // working directory
+        assert(g_pAssetLoader->FileExists("Scene/splash.ogex"));
+        char cwd[4096];
+        assert(getcwd(cwd, sizeof(cwd)));
+        assert(chdir("/") == 0);
+        Buffer moved =
+            g_pAssetLoader->SyncOpenAndReadBinary("Scene/splash.ogex");
+        assert(chdir(cwd) == 0);
+        assert(moved.GetDataSize() > 0);
+    }
+
+    {
+        // missing files are remembered until the cache is invalidated
+        const char* name = "AssetLoaderTest.tmp";
+        string root = "/tmp/AssetLoaderTest." + to_string(getpid());
+        string dir = root + "/Asset";
+        string path = dir + "/" + name;
+        mkdir(root.c_str(), 0755);
+        mkdir(dir.c_str(), 0755);
+
+        assert(!g_pAssetLoader->FileExists(name));
+        g_pAssetLoader->AddSearchPath(root.c_str());
+        assert(!g_pAssetLoader->FileExists(name));
+
+        FILE* fp = fopen(path.c_str(), "w");
+        fputs("cached", fp);
+        fclose(fp);
+        assert(!g_pAssetLoader->FileExists(name));
+
+        g_pAssetLoader->InvalidatePathCache();
+        assert(g_pAssetLoader->FileExists(name));
+        assert(g_pAssetLoader->SyncOpenAndReadTextFileToString(name) ==
+               "cached");
+
+        // resolved names survive until the search path changes
+        unlink(path.c_str());
+        assert(g_pAssetLoader->FileExists(name));
+        g_pAssetLoader->RemoveSearchPath(root.c_str());
+        assert(!g_pAssetLoader->FileExists(name));
+
+        rmdir(dir.c_str());
+        rmdir(root.c_str());
+    }
+
+    {
+        // async reads read what the sync ones do
+        auto future = g_pAssetLoader->AsyncReadBinary("Scene/splash.ogex");
+        Buffer async = future.get();
+        Buffer sync =
+            g_pAssetLoader->SyncOpenAndReadBinary("Scene/splash.ogex");
+        assert(async.GetDataSize() == sync.GetDataSize());
+        assert(memcmp(async.GetData(), sync.GetData(), sync.GetDataSize()) ==
+               0);
+
+        future = g_pAssetLoader->AsyncReadBinary("no/such/file");
+        assert(future.get().GetDataSize() == 0);
+    }
+
+    {
+        // park every I/O thread in a callback, so what is queued next
+        // stays queued until the gate opens
+        string root = "/tmp/AssetLoaderTest." + to_string(getpid());
+        string dir = root + "/Asset";
+        mkdir(root.c_str(), 0755);
+        mkdir(dir.c_str(), 0755);
+        g_pAssetLoader->AddSearchPath(root.c_str());
+
+        vector<string> names;
+        for (size_t i = 0; i < AssetLoader::kIoThreadCount + 3; i++) {
+            names.push_back("async" + to_string(i) + ".tmp");
+            FILE* fp = fopen((dir + "/" + names.back()).c_str(), "w");
+            fputs(names.back().c_str(), fp);
+            fclose(fp);
+        }
+
+        vector<promise<void>> gates(AssetLoader::kIoThreadCount);
+        mutex order_mutex;
+        vector<string> order;
+        vector<promise<void>> parked(AssetLoader::kIoThreadCount);
+
+        // one at a time, a thread may take several queued reads at once
+        for (size_t i = 0; i < AssetLoader::kIoThreadCount; i++) {
+            g_pAssetLoader->AsyncReadBinary(
+                names[i].c_str(), 0, [&, i](Buffer) {
+                    auto opened = gates[i].get_future();
+                    parked[i].set_value();
+                    opened.wait();
+                });
+            parked[i].get_future().wait();
+        }
+
+        // each waiter writes into its buffer, and must not see the others
+        auto record = [&](const string& name, string* content) {
+            return [&, name, content](Buffer buf) {
+                lock_guard<mutex> lock(order_mutex);
+                order.push_back(name);
+                if (content) {
+                    content->assign(reinterpret_cast<char*>(buf.GetData()),
+                                    buf.GetDataSize());
+                    memset(buf.GetData(), 'x', buf.GetDataSize());
+                }
+            };
+        };
+
+        const string& low = names[AssetLoader::kIoThreadCount];
+        const string& high = names[AssetLoader::kIoThreadCount + 1];
+        const string& cancelled = names[AssetLoader::kIoThreadCount + 2];
+
+        string first;
+        string second;
+        g_pAssetLoader->AsyncReadBinary(low.c_str(), 0, record(low, nullptr));
+        auto id = g_pAssetLoader->AsyncReadBinary(cancelled.c_str(), 5,
+                                                  record(cancelled, nullptr));
+        g_pAssetLoader->AsyncReadBinary(high.c_str(), 1, record(high, &first));
+        // a duplicate shares the queued read and raises its priority
+        g_pAssetLoader->AsyncReadBinary(high.c_str(), 10,
+                                        record(high, &second));
+
+        assert(g_pAssetLoader->CancelAsyncRead(id));
+        assert(!g_pAssetLoader->CancelAsyncRead(id));
+
+        // a single thread drains the queue, by priority
+        gates[0].set_value();
+        while (true) {
+            {
+                lock_guard<mutex> lock(order_mutex);
+                if (order.size() == 3) break;
+            }
+            this_thread::yield();
+        }
+
+        assert(order[0] == high && order[1] == high && order[2] == low);
+        assert(first == high && second == high);
+
+        for (size_t i = 1; i < gates.size(); i++) {
+            gates[i].set_value();
+        }
+
+        g_pAssetLoader->RemoveSearchPath(root.c_str());
+        for (auto& name : names) {
+            unlink((dir + "/" + name).c_str());
+        }
+        rmdir(dir.c_str());
+        rmdir(root.c_str());
+    }
+
+    {
+        // the first read of every asset goes to the manifest, in order
+        string manifest =
+            "/tmp/AssetLoaderTest." + to_string(getpid()) + ".manifest";
+
+        {
+            AssetLoader loader(manifest.c_str());
+            loader.Initialize();
+            loader.SyncOpenAndReadText("Shaders/HLSL/basic.vert.hlsl");
+            loader.SyncOpenAndReadBinary("Scene/splash.ogex");
+            loader.SyncOpenAndReadText("Shaders/HLSL/basic.vert.hlsl");
+            loader.AsyncReadBinary("Shaders/HLSL/basic.frag.hlsl").get();
+            loader.Finalize();
+        }
+
+        vector<string> names;
+        ifstream in(manifest);
+        string line;
+        while (getline(in, line)) {
+            if (line[0] == '#') continue;
+            names.push_back(line.substr(line.find('\t') + 1));
+        }
+        assert(names.size() == 3);
+        assert(names[0] == "Shaders/HLSL/basic.vert.hlsl");
+        assert(names[1] == "Scene/splash.ogex");
+        assert(names[2] == "Shaders/HLSL/basic.frag.hlsl");
+
+        {
+            // the next run prefetches them, and records its own reads
+            AssetLoader loader(manifest.c_str());
+            loader.Initialize();
+            loader.SyncOpenAndReadBinary("Scene/splash.ogex");
+            loader.Finalize();
+        }
+
+        in = ifstream(manifest);
+        names.clear();
+        while (getline(in, line)) {
+            if (line[0] == '#') continue;
+            names.push_back(line.substr(line.find('\t') + 1));
+        }
+        assert(names.size() == 1 && names[0] == "Scene/splash.ogex");
+
+        unlink(manifest.c_str());
+    }
+#endif
+
     g_pAssetLoader->Finalize();
     g_pMemoryManager->Finalize();
 
@@ -0,0 +1,189 @@
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BlockAllocator.hpp"
+#include "MemoryManager.hpp"
+
+using namespace std;
+using namespace My;
+
+namespace My {
+IMemoryManager* g_pMemoryManager = new MemoryManager();
+}  // namespace My
+
+struct Payload {
+    uint32_t thread;
+    uint32_t index;
+    uint64_t check;
+};
+
+static const uint32_t kThreadCount = 4;
+static const uint32_t kRounds = 64;
+static const uint32_t kBlocksPerRound = 4096;
+
+static uint64_t checksum(uint32_t thread, uint32_t index) {
+    return (static_cast<uint64_t>(thread) << 32 | index) *
+           0x9E3779B97F4A7C15ull;
+}
+
+// every thread allocates and frees its own blocks
+static double local_stress(BlockAllocator& allocator) {
+    auto start = chrono::steady_clock::now();
+
+    vector<thread> workers;
+    for (uint32_t t = 0; t < kThreadCount; t++) {
+        workers.emplace_back([&allocator, t] {
+            vector<Payload*> blocks(kBlocksPerRound);
+            for (uint32_t round = 0; round < kRounds; round++) {
+                for (uint32_t i = 0; i < kBlocksPerRound; i++) {
+                    auto* p = reinterpret_cast<Payload*>(allocator.Allocate());
+                    *p = {t, i, checksum(t, i)};
+                    blocks[i] = p;
+                }
+
+                for (uint32_t i = 0; i < kBlocksPerRound; i++) {
+                    auto* p = blocks[i];
+                    assert(p->thread == t && p->index == i &&
+                           p->check == checksum(t, i));
+                    allocator.Free(p);
+                }
+            }
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// producers allocate, consumers free, so every free is a remote free
+static double remote_stress(BlockAllocator& allocator) {
+    mutex queue_mutex;
+    condition_variable queue_cv;
+    deque<vector<Payload*>> queue;
+    uint32_t producers_running = kThreadCount / 2;
+
+    auto start = chrono::steady_clock::now();
+
+    vector<thread> workers;
+    for (uint32_t t = 0; t < kThreadCount / 2; t++) {
+        workers.emplace_back([&, t] {
+            for (uint32_t round = 0; round < kRounds; round++) {
+                vector<Payload*> batch(kBlocksPerRound);
+                for (uint32_t i = 0; i < kBlocksPerRound; i++) {
+                    auto* p = reinterpret_cast<Payload*>(allocator.Allocate());
+                    *p = {t, i, checksum(t, i)};
+                    batch[i] = p;
+                }
+
+                lock_guard<mutex> lock(queue_mutex);
+                queue.push_back(std::move(batch));
+                queue_cv.notify_one();
+            }
+
+            lock_guard<mutex> lock(queue_mutex);
+            producers_running--;
+            queue_cv.notify_all();
+        });
+    }
+
+    for (uint32_t t = 0; t < kThreadCount / 2; t++) {
+        workers.emplace_back([&] {
+            while (true) {
+                vector<Payload*> batch;
+                {
+                    unique_lock<mutex> lock(queue_mutex);
+                    queue_cv.wait(lock, [&] {
+                        return !queue.empty() || producers_running == 0;
+                    });
+                    if (queue.empty()) break;
+                    batch = std::move(queue.front());
+                    queue.pop_front();
+                }
+
+                for (uint32_t i = 0; i < batch.size(); i++) {
+                    auto* p = batch[i];
+                    assert(p->index == i &&
+                           p->check == checksum(p->thread, i));
+                    allocator.Free(p);
+                }
+            }
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+int main(int, char**) {
+    g_pMemoryManager->Initialize();
+
+    {
+        BlockAllocator allocator(sizeof(Payload), 16384, 8);
+
+        const double ops = 2.0 * kThreadCount * kRounds * kBlocksPerRound;
+
+        double elapsed = local_stress(allocator);
+        cout << "local alloc/free: " << elapsed << "s, "
+             << ops / elapsed / 1000000.0 << " Mops/s, "
+             << allocator.GetPageCount() << " pages" << endl;
+
+        elapsed = remote_stress(allocator);
+        cout << "remote free: " << elapsed << "s, "
+             << ops / 2.0 / elapsed / 1000000.0 << " Mops/s, "
+             << allocator.GetPageCount() << " pages" << endl;
+
+        // blocks freed remotely are reused, so a second pass should not
+        // grow the page count much
+        size_t pages = allocator.GetPageCount();
+        remote_stress(allocator);
+        cout << "pages after reuse pass: " << allocator.GetPageCount()
+             << endl;
+        assert(allocator.GetPageCount() <= pages * 2);
+    }
+
+    {
+        // pages emptied by the owning thread go back to the system
+        BlockAllocator allocator(sizeof(Payload), 16384, 8);
+
+        vector<void*> blocks(kBlocksPerRound);
+        for (auto& p : blocks) p = allocator.Allocate();
+        size_t pages = allocator.GetPageCount();
+
+        // keep one page alive through its last block
+        for (size_t i = 0; i < blocks.size(); i++) {
+            if (i != blocks.size() - 1) allocator.Free(blocks[i]);
+        }
+        size_t released = allocator.Trim();
+        cout << "trimmed " << released << " of " << pages << " pages" << endl;
+        assert(released == pages - 1);
+        assert(allocator.GetPageCount() == 1);
+
+        // the remaining page still serves allocations
+        void* p = allocator.Allocate();
+        assert(p);
+        allocator.Free(p);
+        allocator.Free(blocks.back());
+        assert(allocator.Trim() == 1);
+        assert(allocator.GetPageCount() == 0);
+    }
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pMemoryManager;
+
+    return 0;
+}
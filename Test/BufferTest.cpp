@@ -0,0 +1,88 @@
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#include "Buffer.hpp"
+
+using namespace std;
+using namespace My;
+
+int main(int, char**) {
+    {
+        // alignment is honored
+        Buffer simd(1000, Buffer::kSimdAlignment);
+        assert(simd.IsAligned(Buffer::kSimdAlignment));
+        Buffer page(5000, Buffer::kPageAlignment);
+        assert(page.IsAligned(Buffer::kPageAlignment));
+        Buffer empty(0, Buffer::kSimdAlignment);
+        assert(empty.GetDataSize() == 0);
+    }
+
+    {
+        bool released = false;
+        auto* bytes = new uint8_t[256];
+        for (int32_t i = 0; i < 256; i++) bytes[i] = static_cast<uint8_t>(i);
+
+        Buffer slice;
+        {
+            Buffer buf(bytes, 256, [&released](uint8_t* p) {
+                released = true;
+                delete[] p;
+            });
+
+            Buffer view = buf.View();
+            assert(view.GetData() == buf.GetData());
+            assert(view.GetDataSize() == 256);
+            assert(buf.IsShared());
+
+            slice = view.Slice(16, 32);
+            assert(slice.GetDataSize() == 32);
+            assert(slice.GetData()[0] == 16 && slice.GetData()[31] == 47);
+
+            // slices of slices stay inside the parent
+            Buffer sub = slice.Slice(8, 8);
+            assert(sub.GetData()[0] == 24);
+        }
+
+        // the last slice keeps the store alive
+        assert(!released);
+        assert(!slice.IsShared());
+        assert(slice.GetData()[1] == 17);
+
+        slice = Buffer();
+        assert(released);
+    }
+
+    {
+        // MoveData hands out the store when nothing else refers to it
+        Buffer buf(16);
+        memset(buf.GetData(), 0xCD, 16);
+        const uint8_t* store = buf.GetData();
+        uint8_t* data = buf.MoveData();
+        assert(buf.GetDataSize() == 0 && buf.GetData() == nullptr);
+        assert(data == store && data[15] == 0xCD);
+        delete[] data;
+    }
+
+    {
+        // and a private copy when it is shared, or not from new[]
+        Buffer buf(16, Buffer::kSimdAlignment);
+        memset(buf.GetData(), 0xAB, 16);
+        Buffer view = buf.View();
+        uint8_t* data = buf.MoveData();
+        assert(buf.GetDataSize() == 0 && buf.GetData() == nullptr);
+        assert(data != view.GetData() && data[15] == 0xAB);
+        delete[] data;
+
+        data = view.MoveData();
+        assert(data[0] == 0xAB);
+        delete[] data;
+
+        view.SetData(new uint8_t[4], 4);
+        assert(view.GetDataSize() == 4);
+    }
+
+    cout << "Buffer tests passed" << endl;
+
+    return 0;
+}
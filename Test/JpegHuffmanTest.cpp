@@ -0,0 +1,237 @@
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "HuffmanTree.hpp"
+#include "JpegHuffman.hpp"
+
+using namespace std;
+using namespace My;
+
+// the luminance tables of T.81 annex K.3
+static const uint8_t kDcCounts[16] = {0, 1, 5, 1, 1, 1, 1, 1,
+                                      1, 0, 0, 0, 0, 0, 0, 0};
+static const uint8_t kDcSymbols[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+
+static const uint8_t kAcCounts[16] = {0, 2, 1, 3, 3, 2, 4, 3,
+                                      5, 5, 4, 4, 0, 0, 1, 0x7D};
+static const uint8_t kAcSymbols[] = {
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06,
+    0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08,
+    0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0, 0x24, 0x33, 0x62, 0x72,
+    0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45,
+    0x46, 0x47, 0x48, 0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+    0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6A, 0x73, 0x74, 0x75,
+    0x76, 0x77, 0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3,
+    0xA4, 0xA5, 0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6,
+    0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9,
+    0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+    0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4,
+    0xF5, 0xF6, 0xF7, 0xF8, 0xF9, 0xFA};
+
+struct Code {
+    uint32_t bits;
+    uint32_t length;
+};
+
+// the canonical code of every symbol
+static vector<Code> MakeCodes(const uint8_t counts[16],
+                              const uint8_t* symbols) {
+    vector<Code> codes(256, {0, 0});
+    uint32_t code = 0;
+    size_t index = 0;
+    for (uint32_t length = 1; length <= 16; length++) {
+        for (uint32_t i = 0; i < counts[length - 1]; i++) {
+            codes[symbols[index++]] = {code++, length};
+        }
+        code <<= 1;
+    }
+    return codes;
+}
+
+// writes bits most significant first, stuffing 0x00 after every 0xFF when
+// asked to
+class BitWriter {
+   public:
+    explicit BitWriter(bool stuffing) : m_bStuffing(stuffing) {}
+
+    void Put(uint32_t bits, uint32_t length) {
+        for (int32_t i = length - 1; i >= 0; i--) {
+            m_nByte = static_cast<uint8_t>((m_nByte << 1) | ((bits >> i) & 1));
+            if (++m_nBits == 8) Flush();
+        }
+    }
+
+    // pads the last byte with ones, as encoders do
+    vector<uint8_t>& Finish() {
+        while (m_nBits) Put(1, 1);
+        return m_Data;
+    }
+
+   private:
+    void Flush() {
+        m_Data.push_back(m_nByte);
+        if (m_bStuffing && m_nByte == 0xFF) m_Data.push_back(0x00);
+        m_nByte = 0;
+        m_nBits = 0;
+    }
+
+    vector<uint8_t> m_Data;
+    uint8_t m_nByte{0};
+    uint32_t m_nBits{0};
+    bool m_bStuffing;
+};
+
+int main(int, char**) {
+    JpegHuffmanTable dc_table;
+    JpegHuffmanTable ac_table;
+    bool dc_ok = dc_table.Populate(kDcCounts, kDcSymbols, sizeof(kDcSymbols));
+    bool ac_ok = ac_table.Populate(kAcCounts, kAcSymbols, sizeof(kAcSymbols));
+    assert(dc_ok && ac_ok);
+    assert(dc_table.GetSymbolCount() == sizeof(kDcSymbols));
+    assert(ac_table.GetSymbolCount() == sizeof(kAcSymbols));
+
+    {
+        // malformed tables are refused, whatever the build
+        JpegHuffmanTable table;
+        const uint8_t symbols[256] = {};
+
+        // more symbols than the segment holds
+        bool ok = table.Populate(kDcCounts, kDcSymbols, sizeof(kDcSymbols) - 1);
+        assert(!ok);
+
+        // three codes of one bit
+        uint8_t over[16] = {3};
+        ok = table.Populate(over, symbols, sizeof(symbols));
+        assert(!ok);
+
+        // two of one bit leave none for the longer lengths
+        uint8_t full[16] = {2, 1};
+        ok = table.Populate(full, symbols, sizeof(symbols));
+        assert(!ok);
+
+        // more than 256 symbols
+        uint8_t many[16] = {};
+        many[14] = 255;
+        many[15] = 255;
+        ok = table.Populate(many, symbols, sizeof(symbols));
+        assert(!ok);
+    }
+
+    {
+        // every code decodes to its symbol, the 16 bit ones too
+        for (auto [counts, symbols, size, table] :
+             {make_tuple(kDcCounts, kDcSymbols, sizeof(kDcSymbols), &dc_table),
+              make_tuple(kAcCounts, kAcSymbols, sizeof(kAcSymbols),
+                         &ac_table)}) {
+            auto codes = MakeCodes(counts, symbols);
+            for (size_t i = 0; i < size; i++) {
+                BitWriter writer(true);
+                writer.Put(codes[symbols[i]].bits, codes[symbols[i]].length);
+                auto& data = writer.Finish();
+                data.push_back(0xFF);
+                data.push_back(0xD9);
+
+                JpegBitReader reader(data.data(), data.data() + data.size());
+                assert(table->Decode(reader) == symbols[i]);
+            }
+        }
+    }
+
+    {
+        // random symbols with their extra bits, as in a scan, agree with
+        // the tree decoder on the same codes
+        auto dc_codes = MakeCodes(kDcCounts, kDcSymbols);
+        auto ac_codes = MakeCodes(kAcCounts, kAcSymbols);
+
+        mt19937 rng(1);
+        vector<uint8_t> symbols;
+        vector<int32_t> values;
+        BitWriter stuffed(true);
+        BitWriter plain(false);
+        for (int32_t i = 0; i < 20000; i++) {
+            bool dc = (i % 8 == 0);
+            uint8_t symbol =
+                dc ? kDcSymbols[rng() % sizeof(kDcSymbols)]
+                   : kAcSymbols[rng() % sizeof(kAcSymbols)];
+            const auto& code = dc ? dc_codes[symbol] : ac_codes[symbol];
+            uint32_t size = symbol & 0x0F;
+            uint32_t extra = size ? rng() & ((1u << size) - 1) : 0;
+
+            for (auto* writer : {&stuffed, &plain}) {
+                writer->Put(code.bits, code.length);
+                writer->Put(extra, size);
+            }
+
+            int32_t value = static_cast<int32_t>(extra);
+            if (size && value < (1 << (size - 1))) value -= (1 << size) - 1;
+            symbols.push_back(symbol);
+            values.push_back(value);
+        }
+
+        auto& data = stuffed.Finish();
+        const size_t scan_size = data.size();
+        data.push_back(0xFF);
+        data.push_back(0xD0);
+        data.push_back(0x12);
+
+        HuffmanTree<uint8_t> dc_tree;
+        HuffmanTree<uint8_t> ac_tree;
+        dc_tree.PopulateWithHuffmanTable(kDcCounts, kDcSymbols);
+        ac_tree.PopulateWithHuffmanTable(kAcCounts, kAcSymbols);
+        const auto& unstuffed = plain.Finish();
+        size_t byte_offset = 0;
+        uint8_t bit_offset = 0;
+
+        JpegBitReader reader(data.data(), data.data() + data.size());
+        for (size_t i = 0; i < symbols.size(); i++) {
+            bool dc = (i % 8 == 0);
+            assert(!reader.Empty());
+            uint8_t symbol = (dc ? dc_table : ac_table).Decode(reader);
+            int32_t value = reader.Receive(symbol & 0x0F);
+            assert(symbol == symbols[i]);
+            assert(value == values[i]);
+
+            uint8_t expected = (dc ? dc_tree : ac_tree)
+                                   .DecodeSingleValue(
+                                       unstuffed.data(), unstuffed.size(),
+                                       &byte_offset, &bit_offset);
+            assert(symbol == expected);
+            bit_offset += symbol & 0x0F;
+            byte_offset += bit_offset >> 3;
+            bit_offset &= 0x07;
+        }
+
+        // only the padding is left, and the reader stopped at the marker
+        while (!reader.Empty()) reader.Skip(1);
+        assert(reader.GetPosition() == data.data() + scan_size);
+    }
+
+    {
+        // past the marker only zeros are read
+        const uint8_t data[] = {0xA5, 0xFF, 0x00, 0xFF, 0xD9, 0x77};
+        JpegBitReader reader(data, data + sizeof(data));
+        assert(reader.Get(8) == 0xA5);
+        assert(reader.Get(8) == 0xFF);
+        assert(reader.Empty());
+        assert(reader.Get(16) == 0);
+        assert(reader.Empty());
+        assert(reader.GetPosition() == data + 3);
+
+        // a scan cut short ends the same way
+        const uint8_t cut[] = {0x81, 0xFF};
+        JpegBitReader short_reader(cut, cut + sizeof(cut));
+        assert(short_reader.Receive(1) == 1);
+        assert(short_reader.Receive(3) == -7);
+        assert(short_reader.Receive(4) == -14);
+        assert(short_reader.Empty());
+        assert(short_reader.GetPosition() == cut + 1);
+    }
+
+    cout << "jpeg huffman ok" << endl;
+
+    return 0;
+}
@@ -1,3 +1,5 @@
+#include <cassert>
+#include <cstring>
 #include <iostream>
 #include <string>
 
@@ -37,6 +39,24 @@ int main(int argc, const char** argv) {
         cout << image;
     }
 
+    {
+        // a Huffman table with three codes of one bit is refused, as is
+        // one longer than its segment
+        const uint8_t over[] = {0xFF, 0xD8, 0xFF, 0xC4, 0x00, 0x16, 0x00,
+                                3,    0,    0,    0,    0,    0,    0,
+                                0,    0,    0,    0,    0,    0,    0,
+                                0,    1,    2,    3,    0xFF, 0xD9};
+        const uint8_t cut[] = {0xFF, 0xD8, 0xFF, 0xC4, 0x01, 0x00, 0x00};
+        for (auto [data, size] :
+             {make_pair(over, sizeof(over)), make_pair(cut, sizeof(cut))}) {
+            Buffer buf(size);
+            memcpy(buf.GetData(), data, size);
+            JfifParser jfif_parser;
+            Image image = jfif_parser.Parse(buf);
+            assert(!image.data);
+        }
+    }
+
     g_pAssetLoader->Finalize();
     g_pMemoryManager->Finalize();
 
@@ -0,0 +1,122 @@
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "MemoryManager.hpp"
+
+using namespace std;
+using namespace My;
+
+namespace My {
+IMemoryManager* g_pMemoryManager = new MemoryManager();
+}  // namespace My
+
+struct TestObject {
+    int32_t id;
+    float value;
+
+    TestObject(int32_t _id, float _value) : id(_id), value(_value) {}
+};
+
+int main(int, char**) {
+    g_pMemoryManager->Initialize();
+
+    // small and large sizes, crossing every size class
+    vector<pair<void*, size_t>> allocations;
+    for (size_t size = 1; size <= 8192; size += 7) {
+        void* p = g_pMemoryManager->Allocate(size);
+        assert(p);
+        memset(p, static_cast<int>(size & 0xFF), size);
+        allocations.emplace_back(p, size);
+    }
+
+    for (auto& allocation : allocations) {
+        auto* p = reinterpret_cast<uint8_t*>(allocation.first);
+        assert(p[0] == (allocation.second & 0xFF));
+        assert(p[allocation.second - 1] == (allocation.second & 0xFF));
+        g_pMemoryManager->Free(allocation.first, allocation.second);
+    }
+
+    cout << "Allocated and freed " << allocations.size() << " blocks" << endl;
+
+    // freed blocks are reused by the same size class
+    void* p1 = g_pMemoryManager->Allocate(24);
+    g_pMemoryManager->Free(p1, 24);
+    void* p2 = g_pMemoryManager->Allocate(20);
+    assert(p1 == p2);
+    g_pMemoryManager->Free(p2, 20);
+
+    auto* obj = g_pMemoryManager->New<TestObject, MemoryTag::kScene>(42, 3.14f);
+    assert(obj->id == 42);
+    cout << "TestObject { " << obj->id << ", " << obj->value << " }" << endl;
+    assert(g_pMemoryManager->GetStatistics(MemoryTag::kScene).inUse ==
+           sizeof(TestObject));
+    g_pMemoryManager->Delete<TestObject, MemoryTag::kScene>(obj);
+
+    // tagged accounting
+    g_pMemoryManager->SetBudget(MemoryTag::kParser, 1024);
+    void* p3 = g_pMemoryManager->Allocate(700, MemoryTag::kParser);
+    void* p4 = g_pMemoryManager->Allocate(9000, MemoryTag::kParser);
+    auto statistics = g_pMemoryManager->GetStatistics(MemoryTag::kParser);
+    assert(statistics.inUse == 9700);
+    assert(statistics.allocationCount == 2);
+    g_pMemoryManager->Tick();  // warns, Parser is over budget
+    g_pMemoryManager->Free(p4, 9000, MemoryTag::kParser);
+    g_pMemoryManager->Free(p3, 700, MemoryTag::kParser);
+    statistics = g_pMemoryManager->GetStatistics(MemoryTag::kParser);
+    assert(statistics.inUse == 0);
+    assert(statistics.peak == 9700);
+
+    // pages from the reserved range are reused, and zeroed, after they
+    // have been freed
+    void* page = g_pMemoryManager->AllocatePage(65536);
+    assert((reinterpret_cast<uintptr_t>(page) & 65535) == 0);
+    memset(page, 0xCD, 65536);
+    g_pMemoryManager->FreePage(page);
+    void* page2 = g_pMemoryManager->AllocatePage(65536);
+    assert((reinterpret_cast<uintptr_t>(page2) & 65535) == 0);
+    if (static_cast<MemoryManager*>(g_pMemoryManager)
+            ->HasReservedAddressSpace()) {
+        assert(page2 == page);
+        const auto* bytes = static_cast<const uint8_t*>(page2);
+        for (size_t i = 0; i < 65536; i++) assert(bytes[i] == 0);
+    }
+    g_pMemoryManager->FreePage(page2);
+
+    // a page of another size in the same bucket takes the freed range
+    void* page3 = g_pMemoryManager->AllocatePage(40000);
+    if (static_cast<MemoryManager*>(g_pMemoryManager)
+            ->HasReservedAddressSpace()) {
+        assert(page3 == page);
+    }
+    memset(page3, 0xCD, 40000);
+    g_pMemoryManager->FreePage(page3);
+    void* page4 = g_pMemoryManager->AllocatePage(65536);
+    assert((reinterpret_cast<uintptr_t>(page4) & 65535) == 0);
+    g_pMemoryManager->FreePage(page4);
+
+    // empty small object pages go back to the system
+    vector<void*> blocks(16384);
+    for (auto& p : blocks) p = g_pMemoryManager->Allocate(64);
+    size_t pool = g_pMemoryManager->GetStatistics(MemoryTag::kSmallObjectPool)
+                      .inUse;
+    for (auto& p : blocks) g_pMemoryManager->Free(p, 64);
+    size_t released = static_cast<MemoryManager*>(g_pMemoryManager)->Trim();
+    cout << "Trimmed " << released << " pages" << endl;
+    assert(released > 0);
+    assert(g_pMemoryManager->GetStatistics(MemoryTag::kSmallObjectPool).inUse <
+           pool);
+
+    for (int32_t i = 0; i < static_cast<int32_t>(MemoryTag::kCount); i++) {
+        auto tag = static_cast<MemoryTag>(i);
+        cout << tag << ": " << g_pMemoryManager->GetStatistics(tag).peak
+             << " bytes peak" << endl;
+    }
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pMemoryManager;
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <cassert>
+#include <iostream>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MemoryManager.hpp"
+#include "MemoryResource.hpp"
+
+using namespace std;
+using namespace My;
+
+namespace My {
+IMemoryManager* g_pMemoryManager = new MemoryManager();
+}  // namespace My
+
+int main(int, char**) {
+    g_pMemoryManager->Initialize();
+
+    {
+        // list nodes are single blocks
+        BlockAllocator allocator(64, 4096, 8);
+        BlockMemoryResource resource(allocator);
+        pmr::list<int32_t> list(&resource);
+        for (int32_t i = 0; i < 1000; i++) list.push_back(i);
+        assert(allocator.GetPageCount() > 0);
+        int32_t sum = 0;
+        for (auto i : list) sum += i;
+        assert(sum == 999 * 1000 / 2);
+        cout << "list of " << list.size() << " in "
+             << allocator.GetPageCount() << " pages" << endl;
+    }
+
+    {
+        // containers bump through the stack, rewinding frees them all
+        StackAllocator allocator(4096, 8);
+        StackMemoryResource resource(allocator);
+        {
+            pmr::vector<double> vector(&resource);
+            for (int32_t i = 0; i < 1000; i++) vector.push_back(i * 0.5);
+            assert(vector[999] == 499.5);
+
+            // over-aligned requests are honored
+            void* p = resource.allocate(100, 256);
+            assert((reinterpret_cast<uintptr_t>(p) & 255) == 0);
+        }
+        assert(allocator.GetAllocatedSize() > 1000 * sizeof(double));
+        allocator.Rewind();
+        assert(allocator.GetAllocatedSize() == 0);
+    }
+
+    {
+        ArenaMemoryResource arena(MemoryTag::kScene);
+        pmr::unordered_map<int32_t, pmr::string> map(&arena);
+        for (int32_t i = 0; i < 100; i++) {
+            map.emplace(i, "a string long enough to leave the SSO buffer");
+        }
+        assert(map[42].get_allocator().resource() == &arena);
+        cout << "arena holds " << arena.GetAllocatedSize() << " bytes" << endl;
+        assert(g_pMemoryManager->GetStatistics(MemoryTag::kScene).inUse > 0);
+    }
+    assert(g_pMemoryManager->GetStatistics(MemoryTag::kScene).inUse == 0);
+
+    {
+        // size classes, accounted to the tag
+        pmr::memory_resource* resource = GetMemoryResource(MemoryTag::kParser);
+        assert(resource == GetMemoryResource(MemoryTag::kParser));
+        assert(resource != GetMemoryResource(MemoryTag::kScene));
+        {
+            pmr::vector<uint8_t> vector(resource);
+            vector.resize(3000);
+            assert(g_pMemoryManager->GetStatistics(MemoryTag::kParser).inUse ==
+                   3000);
+        }
+        assert(g_pMemoryManager->GetStatistics(MemoryTag::kParser).inUse ==
+               0);
+    }
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pMemoryManager;
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "MipChain.hpp"
+#include "TestImages.hpp"
+
+using namespace std;
+using namespace My;
+
+int main(int, char**) {
+    {
+        // down to 1x1, one level after another
+        auto image = MakeImage(13, 6, 32);
+        memset(image.data, 0x40, image.data_size);
+        assert(GenerateMipChain(image));
+        assert(image.mipmaps.size() == 4);
+        assert(image.mipmaps[1].Width == 6 && image.mipmaps[1].Height == 3);
+        assert(image.mipmaps[2].Width == 3 && image.mipmaps[2].Height == 1);
+        assert(image.mipmaps[3].Width == 1 && image.mipmaps[3].Height == 1);
+
+        size_t offset = 0;
+        for (const auto& mip : image.mipmaps) {
+            assert(mip.offset == offset);
+            assert(mip.data_size == mip.pitch * mip.Height);
+            offset += mip.data_size;
+        }
+        assert(image.data_size == offset);
+
+        // a chain is made once
+        assert(!GenerateMipChain(image));
+    }
+
+    {
+        // a flat image stays flat, whatever the filter or edges. sRGB
+        // values come back as they were.
+        for (int32_t value = 0; value < 256; value++) {
+            for (auto filter : {MipFilter::kBox, MipFilter::kKaiser}) {
+                for (bool wrap : {false, true}) {
+                    auto image = MakeImage(8, 4, 32);
+                    memset(image.data, value, image.data_size);
+                    assert(GenerateMipChain(image, {filter, true, wrap}));
+                    for (size_t i = 0; i < image.data_size; i++) {
+                        assert(image.data[i] == value);
+                    }
+                }
+            }
+        }
+    }
+
+    {
+        // black and white average to half the light, not half the code
+        uint8_t pixels[8] = {0, 0, 0, 0, 255, 255, 255, 255};
+        for (bool srgb : {false, true}) {
+            auto image = MakeImage(2, 1, 32);
+            memcpy(image.data, pixels, sizeof(pixels));
+            assert(GenerateMipChain(image, {MipFilter::kBox, srgb, false}));
+            const uint8_t* mip = image.data + image.mipmaps[1].offset;
+            assert(mip[0] == (srgb ? 188 : 128));
+            // alpha is never sRGB
+            assert(mip[3] == 128);
+        }
+    }
+
+    {
+        // bands of rows are filtered apart, the result is as one
+        const uint32_t width = 300;
+        const uint32_t height = 170;
+        auto image = MakeImage(width, height, 32);
+        for (size_t i = 0; i < image.data_size; i++) {
+            image.data[i] = static_cast<uint8_t>((i * 2654435761u) >> 24);
+        }
+        assert(GenerateMipChain(image, {MipFilter::kBox, false, false}));
+
+        const auto& mip = image.mipmaps[1];
+        const uint8_t* out = image.data + mip.offset;
+        for (uint32_t y = 0; y < mip.Height; y++) {
+            for (uint32_t x = 0; x < mip.Width; x++) {
+                for (uint32_t c = 0; c < 4; c++) {
+                    int32_t sum = 0;
+                    for (uint32_t dy = 0; dy < 2; dy++) {
+                        for (uint32_t dx = 0; dx < 2; dx++) {
+                            sum += image.data[image.pitch * (2 * y + dy) +
+                                              4 * (2 * x + dx) + c];
+                        }
+                    }
+                    int32_t got = out[mip.pitch * y + 4 * x + c];
+                    assert(abs(got - (sum + 2) / 4) <= 1);
+                }
+            }
+        }
+    }
+
+    {
+        // 16 bit and float images, ringing never goes below zero
+        auto image16 = MakeImage(16, 16, 64);
+        auto* p16 = reinterpret_cast<uint16_t*>(image16.data);
+        for (size_t i = 0; i < image16.data_size / 2; i++) {
+            p16[i] = (i / 4) % 2 ? 0xFFFF : 0;
+        }
+        assert(GenerateMipChain(image16));
+        assert(image16.mipmaps.size() == 5);
+
+        auto image32 = MakeImage(16, 16, 128, true);
+        auto* p32 = reinterpret_cast<float*>(image32.data);
+        for (size_t i = 0; i < image32.data_size / 4; i++) {
+            p32[i] = (i / 4) % 7 ? 0.0f : 100.0f;
+        }
+        assert(GenerateMipChain(image32));
+        const auto* mips = reinterpret_cast<const float*>(image32.data);
+        for (size_t i = 256 * 4; i < image32.data_size / 4; i++) {
+            assert(mips[i] >= 0.0f && isfinite(mips[i]));
+        }
+    }
+
+    {
+        // single channel images are filtered as they are, never as sRGB
+        auto image = MakeImage(7, 4, 8);
+        for (size_t i = 0; i < image.data_size; i++) {
+            image.data[i] = (i % 2) ? 255 : 0;
+        }
+        assert(GenerateMipChain(image, {MipFilter::kBox, true, false}));
+        assert(image.mipmaps.size() == 3);
+        assert(image.mipmaps[1].pitch == 3);
+        assert(image.data[image.mipmaps[1].offset] == 128);
+    }
+
+    {
+        // 24 bit and compressed images are left alone
+        auto image = MakeImage(4, 4, 24);
+        assert(!GenerateMipChain(image));
+        assert(image.mipmaps.size() == 1);
+    }
+
+    cout << "mip chains ok" << endl;
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "config.h"
+
+#if !defined(OS_WINDOWS)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "AssetLoader.hpp"
+#include "MemoryManager.hpp"
+#include "PakArchive.hpp"
+
+using namespace std;
+using namespace My;
+
+namespace My {
+IMemoryManager* g_pMemoryManager = new MemoryManager();
+AssetLoader* g_pAssetLoader = new AssetLoader();
+}  // namespace My
+
+int main(int, char**) {
+    g_pMemoryManager->Initialize();
+    g_pAssetLoader->Initialize();
+
+    assert(NormalizePakName("./Textures\\eye.png") == "Textures/eye.png");
+    assert(NormalizePakName("/Scene/splash.ogex") == "Scene/splash.ogex");
+
+#if !defined(OS_WINDOWS)
+    string root = "/tmp/PakArchiveTest." + to_string(getpid());
+    string dir = root + "/Asset";
+    mkdir(root.c_str(), 0755);
+    mkdir(dir.c_str(), 0755);
+
+    string text;
+    for (int32_t i = 0; i < 200; i++) {
+        text += "a line that compresses well " + to_string(i % 7) + "\n";
+    }
+
+    vector<uint8_t> noise(10000);
+    mt19937 rng(42);
+    for (auto& byte : noise) byte = static_cast<uint8_t>(rng());
+
+    {
+        PakWriter writer;
+        assert(writer.Begin((dir + "/Test.pak").c_str()));
+        assert(writer.AddEntry(
+            "Shaders/test.txt", reinterpret_cast<const uint8_t*>(text.data()),
+            text.size(), PakCodec::kZlib));
+        assert(writer.AddEntry("noise.bin", noise.data(), noise.size(),
+                               PakCodec::kZlib));
+        assert(writer.AddEntry("lz4.txt",
+                               reinterpret_cast<const uint8_t*>(text.data()),
+                               text.size(), PakCodec::kLz4));
+        assert(writer.AddEntry("empty.bin", nullptr, 0, PakCodec::kZlib));
+        assert(writer.Finish());
+    }
+
+    // a loose file the archive shadows
+    FILE* fp = fopen((dir + "/noise.bin").c_str(), "w");
+    fputs("loose", fp);
+    fclose(fp);
+
+    g_pAssetLoader->AddSearchPath(root.c_str());
+    assert(g_pAssetLoader->MountArchive("Test.pak"));
+
+    {
+        assert(g_pAssetLoader->FileExists("Shaders/test.txt"));
+        assert(g_pAssetLoader->SyncOpenAndReadTextFileToString(
+                   "Shaders/test.txt") == text);
+
+        Buffer lz4 = g_pAssetLoader->SyncOpenAndReadBinary("lz4.txt");
+        assert(lz4.GetDataSize() == text.size());
+        assert(memcmp(lz4.GetData(), text.data(), text.size()) == 0);
+
+        // noise does not compress, it is stored and read in place
+        Buffer stored = g_pAssetLoader->SyncOpenAndReadBinary("./noise.bin");
+        assert(stored.GetDataSize() == noise.size());
+        assert(memcmp(stored.GetData(), noise.data(), noise.size()) == 0);
+        assert(stored.IsAligned(kPakAlignment));
+
+        Buffer empty = g_pAssetLoader->SyncOpenAndReadBinary("empty.bin");
+        assert(empty.GetDataSize() == 0);
+
+        auto future = g_pAssetLoader->AsyncReadBinary("Shaders/test.txt");
+        Buffer async = future.get();
+        assert(async.GetDataSize() == text.size());
+        assert(memcmp(async.GetData(), text.data(), text.size()) == 0);
+
+        assert(!g_pAssetLoader->FileExists("missing.bin"));
+    }
+
+    {
+        // the loose file is back once the archive is gone
+        g_pAssetLoader->UnmountArchives();
+        assert(g_pAssetLoader->SyncOpenAndReadTextFileToString("noise.bin") ==
+               "loose");
+    }
+
+    {
+        // a damaged toc is refused
+        Buffer data = g_pAssetLoader->SyncOpenAndReadBinary("Test.pak");
+        Buffer copy(data.GetDataSize(), Buffer::kPageAlignment);
+        memcpy(copy.GetData(), data.GetData(), data.GetDataSize());
+        auto* header = reinterpret_cast<PakHeader*>(copy.GetData());
+        header->entryCount = 1000000;
+
+        PakArchive archive;
+        assert(!archive.Open(std::move(copy)));
+    }
+
+    g_pAssetLoader->RemoveSearchPath(root.c_str());
+    unlink((dir + "/Test.pak").c_str());
+    unlink((dir + "/noise.bin").c_str());
+    rmdir(dir.c_str());
+    rmdir(root.c_str());
+#endif
+
+    g_pAssetLoader->Finalize();
+    g_pMemoryManager->Finalize();
+
+    return 0;
+}
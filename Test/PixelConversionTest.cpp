@@ -0,0 +1,92 @@
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+#include "PixelConversion.hpp"
+
+using namespace std;
+using namespace My;
+
+// pixel counts around the block sizes of the kernels, and a long row
+static const size_t kCounts[] = {0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 33, 1027};
+
+static vector<uint8_t> Pattern(size_t size) {
+    vector<uint8_t> bytes(size);
+    for (size_t i = 0; i < size; i++) {
+        bytes[i] = static_cast<uint8_t>(i * 7 + 3);
+    }
+    return bytes;
+}
+
+int main(int, char**) {
+    for (size_t count : kCounts) {
+        // sources exactly as long as the pixels, reading past them would
+        // trip the address sanitizer
+        auto rgb = Pattern(count * 3);
+        auto rgba = Pattern(count * 4);
+        auto rgb16 = Pattern(count * 6);
+
+        vector<uint8_t> out8(count * 4);
+        ExpandRGB8ToRGBA8(rgb.data(), out8.data(), count);
+        for (size_t i = 0; i < count; i++) {
+            assert(out8[4 * i] == rgb[3 * i]);
+            assert(out8[4 * i + 1] == rgb[3 * i + 1]);
+            assert(out8[4 * i + 2] == rgb[3 * i + 2]);
+            assert(out8[4 * i + 3] == 0xFF);
+        }
+
+        ExpandBGR8ToRGBA8(rgb.data(), out8.data(), count);
+        for (size_t i = 0; i < count; i++) {
+            assert(out8[4 * i] == rgb[3 * i + 2]);
+            assert(out8[4 * i + 1] == rgb[3 * i + 1]);
+            assert(out8[4 * i + 2] == rgb[3 * i]);
+            assert(out8[4 * i + 3] == 0xFF);
+        }
+
+        SwizzleBGRA8ToRGBA8(rgba.data(), out8.data(), count);
+        for (size_t i = 0; i < count; i++) {
+            assert(out8[4 * i] == rgba[4 * i + 2]);
+            assert(out8[4 * i + 1] == rgba[4 * i + 1]);
+            assert(out8[4 * i + 2] == rgba[4 * i]);
+            assert(out8[4 * i + 3] == rgba[4 * i + 3]);
+        }
+
+        vector<uint8_t> red(count);
+        ExtractRedFromRGBA8(rgba.data(), red.data(), count);
+        for (size_t i = 0; i < count; i++) {
+            assert(red[i] == rgba[4 * i]);
+        }
+
+        vector<uint16_t> out16(count * 4);
+        ExpandRGB16BEToRGBA16(rgb16.data(), out16.data(), count);
+        for (size_t i = 0; i < count; i++) {
+            for (size_t c = 0; c < 3; c++) {
+                const uint8_t* sample = &rgb16[6 * i + 2 * c];
+                assert(out16[4 * i + c] == ((sample[0] << 8) | sample[1]));
+            }
+            assert(out16[4 * i + 3] == 0xFFFF);
+        }
+
+        vector<uint16_t> native(count * 3);
+        for (size_t i = 0; i < native.size(); i++) {
+            native[i] = static_cast<uint16_t>(rgb16[2 * i] * 31 + i);
+        }
+        ExpandRGB16ToRGBA16(native.data(), out16.data(), count);
+        for (size_t i = 0; i < count; i++) {
+            for (size_t c = 0; c < 3; c++) {
+                assert(out16[4 * i + c] == native[3 * i + c]);
+            }
+            assert(out16[4 * i + 3] == 0xFFFF);
+        }
+
+        vector<uint16_t> samples(count * 3);
+        LoadBigEndian16(rgb16.data(), samples.data(), count * 3);
+        for (size_t i = 0; i < count * 3; i++) {
+            assert(samples[i] == ((rgb16[2 * i] << 8) | rgb16[2 * i + 1]));
+        }
+    }
+
+    cout << "pixel conversions match" << endl;
+
+    return 0;
+}
@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "config.h"
+
+#if !defined(OS_WINDOWS)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "AssetLoader.hpp"
+#include "MemoryManager.hpp"
+#include "SceneObjectTexture.hpp"
+#include "TestImages.hpp"
+#include "TextureCache.hpp"
+
+using namespace std;
+using namespace My;
+
+namespace My {
+IMemoryManager* g_pMemoryManager = new MemoryManager();
+AssetLoader* g_pAssetLoader = new AssetLoader();
+}  // namespace My
+
+// the bytes of a 32bit image with its mips down to 1x1
+static size_t ChainBytes(uint32_t width, uint32_t height) {
+    size_t bytes = width * height * 4;
+    while (width > 1 || height > 1) {
+        width = max(1u, width >> 1);
+        height = max(1u, height >> 1);
+        bytes += width * height * 4;
+    }
+    return bytes;
+}
+
+int main(int, char**) {
+    g_pMemoryManager->Initialize();
+    g_pAssetLoader->Initialize();
+
+    {
+        // a texture without a name has no image
+        SceneObjectTexture texture;
+        assert(!texture.GetTextureImage());
+    }
+
+#if !defined(OS_WINDOWS)
+    string root = "/tmp/SceneObjectTextureTest." + to_string(getpid());
+    string dir = root + "/Asset";
+    mkdir(root.c_str(), 0755);
+    mkdir(dir.c_str(), 0755);
+    WriteTga(dir + "/albedo.tga", 16, 8);
+    WriteTga(dir + "/normal.tga", 4, 4);
+
+    g_pAssetLoader->AddSearchPath(root.c_str());
+    TextureCache::SetDirectory("");
+
+    {
+        // textures naming the same file share one image
+        auto albedo = make_shared<SceneObjectTexture>("albedo.tga");
+        auto same = make_shared<SceneObjectTexture>("./albedo.tga");
+        SceneObjectTexture normal("normal.tga");
+        assert(SceneObjectTexture::GetSharedImageCount() == 2);
+
+        auto image = albedo->GetTextureImage();
+        assert(image && image->Width == 16 && image->Height == 8);
+        assert(image->bitcount == 32);
+        assert(image->mipmaps.size() == 5);
+        assert(same->GetTextureImage() == image);
+        assert(normal.GetTextureImage()->Width == 4);
+
+        // the image stays while any texture holds it
+        albedo.reset();
+        assert(SceneObjectTexture::GetSharedImageCount() == 2);
+        assert(same->GetTextureImage() == image);
+
+        // naming another file lets go of the first
+        same->SetName("normal.tga");
+        assert(SceneObjectTexture::GetSharedImageCount() == 1);
+        assert(same->GetTextureImage() == normal.GetTextureImage());
+    }
+
+    assert(SceneObjectTexture::GetSharedImageCount() == 0);
+
+    {
+        // textures dropped while their image loads
+        for (int32_t i = 0; i < 32; i++) {
+            SceneObjectTexture albedo("albedo.tga");
+            SceneObjectTexture normal("normal.tga");
+            albedo.RequestImage();
+            normal.RequestImage();
+        }
+        assert(SceneObjectTexture::GetSharedImageCount() == 0);
+
+        SceneObjectTexture albedo("albedo.tga");
+        assert(albedo.GetTextureImage()->Width == 16);
+    }
+
+    assert(SceneObjectTexture::GetResidentBytes() == 0);
+
+    {
+        // nothing is resident before the image is asked for
+        SceneObjectTexture albedo("albedo.tga");
+        SceneObjectTexture normal("normal.tga");
+        assert(SceneObjectTexture::GetResidentBytes() == 0);
+
+        const size_t albedo_bytes = ChainBytes(16, 8);
+        const size_t normal_bytes = ChainBytes(4, 4);
+
+        albedo.GetTextureImage();
+        SceneObjectTexture::AdvanceFrame();
+        normal.GetTextureImage();
+        SceneObjectTexture::AdvanceFrame();
+        assert(SceneObjectTexture::GetResidentBytes() ==
+               albedo_bytes + normal_bytes);
+
+        // over budget, the least recently used goes first
+        SceneObjectTexture::SetResidencyBudget(normal_bytes);
+        assert(SceneObjectTexture::GetResidentBytes() == normal_bytes);
+
+        // loaded again when asked for, what is used this frame stays
+        auto image = albedo.GetTextureImage();
+        assert(image && image->Width == 16);
+        assert(SceneObjectTexture::GetResidentBytes() == albedo_bytes);
+
+        // uploaded images go with the next frame, whatever the budget
+        SceneObjectTexture::SetResidencyBudget(
+            SceneObjectTexture::kDefaultResidencyBudget);
+        normal.GetTextureImage();
+        normal.MarkUploaded();
+        assert(SceneObjectTexture::GetResidentBytes() ==
+               albedo_bytes + normal_bytes);
+        SceneObjectTexture::AdvanceFrame();
+        assert(SceneObjectTexture::GetResidentBytes() == albedo_bytes);
+
+        // a holder keeps its image after eviction
+        albedo.MarkUploaded();
+        SceneObjectTexture::AdvanceFrame();
+        assert(SceneObjectTexture::GetResidentBytes() == 0);
+        assert(image->Width == 16);
+    }
+
+    {
+        // maps of a single value keep their red channel, mips included
+        WriteTga(dir + "/roughness.tga", 16, 8);
+        SceneObjectTexture roughness("roughness.tga");
+        roughness.SetSingleChannel(true);
+
+        auto image = roughness.GetTextureImage();
+        assert(image->bitcount == 8 && image->pitch == 16);
+        assert(image->mipmaps.size() == 5);
+        assert(image->data_size == ChainBytes(16, 8) / 4);
+        // the file holds BGR, counting up from the first byte
+        for (int32_t i = 0; i < 16 * 8; i++) {
+            assert(image->data[i] == ((3 * i + 2) & 0xFF));
+        }
+    }
+
+    {
+        // the same file decoded with other options is another image,
+        // whichever texture asks first
+        SceneObjectTexture rgba("roughness.tga");
+        SceneObjectTexture red("roughness.tga");
+        SceneObjectTexture color("roughness.tga");
+        red.SetSingleChannel(true);
+        color.SetSRGB(true);
+        assert(SceneObjectTexture::GetSharedImageCount() == 3);
+        assert(rgba.GetTextureImage()->bitcount == 32);
+        assert(red.GetTextureImage()->bitcount == 8);
+        assert(color.GetTextureImage()->bitcount == 32);
+        assert(color.GetTextureImage() != rgba.GetTextureImage());
+        assert(rgba.GetKey() != red.GetKey());
+        assert(rgba.GetKey() != color.GetKey());
+        assert(red.GetKey() != color.GetKey());
+
+        // changing the options names the other image
+        red.SetSingleChannel(false);
+        assert(SceneObjectTexture::GetSharedImageCount() == 2);
+        assert(red.GetTextureImage() == rgba.GetTextureImage());
+        assert(red.GetKey() == rgba.GetKey());
+    }
+
+    {
+        // the faces of a sky box keep the one level of their file
+        SceneObjectTexture face("roughness.tga");
+        face.SetMipChain(false);
+        auto image = face.GetTextureImage();
+        assert(image->mipmaps.size() == 1);
+        assert(image->data_size == 16 * 8 * 4);
+    }
+
+    {
+        // only the smallest mips are streamed until the screen asks for more
+        WriteTga(dir + "/near.tga", 64, 64);
+        WriteTga(dir + "/far.tga", 64, 64);
+        SceneObjectTexture::SetStreamingTailMips(3);
+        SceneObjectTexture near("near.tga");
+        SceneObjectTexture far("far.tga");
+        assert(near.GetStreamedMip() == 0);
+
+        // 64x64 down to 1x1 is 7 levels, the 4x4, 2x2 and 1x1 are the tail
+        assert(near.GetTextureImage()->mipmaps.size() == 7);
+        far.GetTextureImage();
+        assert(near.GetStreamedMip() == 4 && far.GetStreamedMip() == 4);
+        SceneObjectTexture::AdvanceFrame();
+        const size_t tail_bytes = (4 * 4 + 2 * 2 + 1) * 4;
+        assert(SceneObjectTexture::GetStreamedBytes() == 2 * tail_bytes);
+
+        // drawn across 16 pixels wants the 16x16, with what is below it
+        near.RequestScreenSize(16.0f);
+        SceneObjectTexture::AdvanceFrame();
+        assert(near.GetStreamedMip() == 2 && far.GetStreamedMip() == 4);
+        assert(SceneObjectTexture::GetStreamedBytes() ==
+               2 * tail_bytes + (16 * 16 + 8 * 8) * 4);
+
+        // kept while the budget allows, though not drawn
+        SceneObjectTexture::AdvanceFrame();
+        assert(near.GetStreamedMip() == 2);
+
+        // within the budget every texture gets coarse levels before any
+        // gets fine ones, the largest on screen first
+        SceneObjectTexture::SetStreamingBudget(2 * tail_bytes +
+                                               2 * 8 * 8 * 4 + 16 * 16 * 4);
+        near.RequestScreenSize(64.0f);
+        far.RequestScreenSize(32.0f);
+        SceneObjectTexture::AdvanceFrame();
+        assert(near.GetStreamedMip() == 2 && far.GetStreamedMip() == 3);
+
+        far.RequestScreenSize(1000.0f);
+        SceneObjectTexture::AdvanceFrame();
+        assert(near.GetStreamedMip() == 3 && far.GetStreamedMip() == 2);
+
+        // the tails stay whatever the budget
+        SceneObjectTexture::SetStreamingBudget(0);
+        far.RequestScreenSize(1000.0f);
+        SceneObjectTexture::AdvanceFrame();
+        assert(near.GetStreamedMip() == 4 && far.GetStreamedMip() == 4);
+        assert(SceneObjectTexture::GetStreamedBytes() == 2 * tail_bytes);
+
+        SceneObjectTexture::SetStreamingBudget(
+            SceneObjectTexture::kDefaultStreamingBudget);
+        SceneObjectTexture::SetStreamingTailMips(
+            SceneObjectTexture::kDefaultStreamingTailMips);
+
+        // a loaded image is handed out without waiting, an evicted one
+        // is loaded again in the background
+        assert(near.TryGetTextureImage());
+        near.MarkUploaded();
+        SceneObjectTexture::AdvanceFrame();
+        shared_ptr<Image> image;
+        while (!(image = near.TryGetTextureImage())) {
+            this_thread::yield();
+        }
+        assert(image->Width == 64);
+    }
+
+    g_pAssetLoader->RemoveSearchPath(root.c_str());
+    error_code error;
+    filesystem::remove_all(root, error);
+#endif
+
+    g_pAssetLoader->Finalize();
+    g_pMemoryManager->Finalize();
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#include "MemoryManager.hpp"
+#include "StackAllocator.hpp"
+
+using namespace std;
+using namespace My;
+
+namespace My {
+IMemoryManager* g_pMemoryManager = new MemoryManager();
+}  // namespace My
+
+int main(int, char**) {
+    g_pMemoryManager->Initialize();
+
+    {
+        StackAllocator allocator(4096, 16);
+
+        // simulate a few frames worth of scratch allocations
+        for (int frame = 0; frame < 8; frame++) {
+            uint8_t* last = nullptr;
+            for (size_t size = 1; size < 1024; size += 13) {
+                auto* p = reinterpret_cast<uint8_t*>(allocator.Allocate(size));
+                assert((reinterpret_cast<uintptr_t>(p) & 15) == 0);
+                assert(p != last);
+                memset(p, frame, size);
+                last = p;
+            }
+
+            // larger than a page
+            auto* big = allocator.AllocateArray<float>(4096);
+            big[4095] = 1.0f;
+
+            cout << "frame " << frame << ": " << allocator.GetAllocatedSize()
+                 << " bytes" << endl;
+
+            allocator.Rewind();
+        }
+
+        // pages are reused after a rewind
+        void* first = allocator.Allocate(32);
+        allocator.Rewind();
+        assert(allocator.Allocate(32) == first);
+    }
+
+    g_pMemoryManager->Finalize();
+
+    delete g_pMemoryManager;
+
+    return 0;
+}
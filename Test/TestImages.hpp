@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "Image.hpp"
+
+// images the texture tests build and write
+
+// an uncompressed image of one level, its pixels left to the caller
+inline My::Image MakeImage(uint32_t width, uint32_t height, uint32_t bitcount,
+                           bool is_float = false) {
+    My::Image image;
+    image.Width = width;
+    image.Height = height;
+    image.bitcount = bitcount;
+    image.is_float = is_float;
+    image.pitch = width * (bitcount >> 3);
+    image.data_size = image.pitch * height;
+    image.data = new uint8_t[image.data_size];
+    image.mipmaps.emplace_back(width, height, image.pitch, 0,
+                               image.data_size);
+    return image;
+}
+
+// an uncompressed 24bit tga of the given size, byte i of its pixels is
+// value(i)
+template <typename Value>
+inline void WriteTga(const std::string& path, uint16_t width, uint16_t height,
+                     Value&& value) {
+    uint8_t header[18] = {0};
+    header[2] = 2;
+    header[12] = width & 0xFF;
+    header[13] = width >> 8;
+    header[14] = height & 0xFF;
+    header[15] = height >> 8;
+    header[16] = 24;
+
+    FILE* fp = fopen(path.c_str(), "wb");
+    fwrite(header, sizeof(header), 1, fp);
+    for (int32_t i = 0; i < width * height * 3; i++) {
+        fputc(value(i), fp);
+    }
+    fclose(fp);
+}
+
+// one counting up from the first byte
+inline void WriteTga(const std::string& path, uint16_t width,
+                     uint16_t height) {
+    WriteTga(path, width, height, [](int32_t i) { return i & 0xFF; });
+}
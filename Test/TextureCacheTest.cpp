@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "config.h"
+
+#if !defined(OS_WINDOWS)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "AssetLoader.hpp"
+#include "MemoryManager.hpp"
+#include "TextureCache.hpp"
+
+using namespace std;
+using namespace My;
+
+namespace My {
+IMemoryManager* g_pMemoryManager = new MemoryManager();
+AssetLoader* g_pAssetLoader = new AssetLoader();
+}  // namespace My
+
+int main(int, char**) {
+    g_pMemoryManager->Initialize();
+    g_pAssetLoader->Initialize();
+
+#if !defined(OS_WINDOWS)
+    string root = "/tmp/TextureCacheTest." + to_string(getpid());
+    string dir = root + "/Asset";
+    string source = dir + "/texture.png";
+    mkdir(root.c_str(), 0755);
+    mkdir(dir.c_str(), 0755);
+
+    FILE* fp = fopen(source.c_str(), "w");
+    fputs("stands in for the encoded texture", fp);
+    fclose(fp);
+
+    g_pAssetLoader->AddSearchPath(root.c_str());
+    TextureCache::SetDirectory(root + "/Cache");
+
+    {
+        Image image;
+        image.Width = 8;
+        image.Height = 8;
+        image.bitcount = 32;
+        image.pitch = 32;
+        image.data_size = 256 + 64;
+        image.data = new uint8_t[image.data_size];
+        for (size_t i = 0; i < image.data_size; i++) {
+            image.data[i] = static_cast<uint8_t>(i);
+        }
+        image.mipmaps.emplace_back(8, 8, 32, 0, 256);
+        image.mipmaps.emplace_back(4, 4, 16, 256, 64);
+
+        assert(!TextureCache::Load("texture.png"));
+        assert(TextureCache::Store("texture.png", image));
+
+        auto cached = TextureCache::Load("texture.png");
+        assert(cached);
+        assert(cached->Width == 8 && cached->Height == 8);
+        assert(cached->bitcount == 32 && cached->pitch == 32);
+        assert(cached->data_size == image.data_size);
+        assert(memcmp(cached->data, image.data, image.data_size) == 0);
+        assert(cached->mipmaps.size() == 2);
+        assert(cached->mipmaps[1].offset == 256);
+        assert(cached->mipmaps[1].data_size == 64);
+
+        // the pixels are mapped on a page boundary
+        assert(cached->storage.IsAligned(4096));
+
+        // another asset misses, even with the same cache directory
+        assert(!TextureCache::Load("other.png"));
+
+        // so does the same asset decoded otherwise, and storing it keeps
+        // the first
+        assert(!TextureCache::Load("texture.png", "r8"));
+        Image red;
+        red.Width = red.Height = 1;
+        red.bitcount = 8;
+        red.pitch = 1;
+        red.data_size = 1;
+        red.data = new uint8_t[1]{7};
+        assert(TextureCache::Store("texture.png", red, "r8"));
+        assert(TextureCache::Load("texture.png", "r8")->bitcount == 8);
+        assert(TextureCache::Load("texture.png")->bitcount == 32);
+
+        // an entry whose level lies past its pixels misses. the 4x4 level
+        // is moved 8 bytes on, its end past the 320 bytes there are.
+        const uint64_t level[] = {4 | (4ull << 32), 16, 256, 64};
+        size_t patched = 0;
+        for (const auto& file :
+             filesystem::directory_iterator(root + "/Cache")) {
+            FILE* fp = fopen(file.path().c_str(), "r+b");
+            vector<uint8_t> content(filesystem::file_size(file.path()));
+            fread(content.data(), content.size(), 1, fp);
+            auto it = search(content.begin(), content.end(),
+                             reinterpret_cast<const uint8_t*>(level),
+                             reinterpret_cast<const uint8_t*>(level + 4));
+            if (it != content.end()) {
+                const uint64_t offset = 264;
+                fseek(fp, (it - content.begin()) + 16, SEEK_SET);
+                fwrite(&offset, sizeof(offset), 1, fp);
+                patched++;
+            }
+            fclose(fp);
+        }
+        assert(patched == 1);
+        assert(!TextureCache::Load("texture.png"));
+        assert(TextureCache::Store("texture.png", image));
+        assert(TextureCache::Load("texture.png"));
+    }
+
+    {
+        // a changed source misses
+        FILE* fp = fopen(source.c_str(), "w");
+        fputs("edited", fp);
+        fclose(fp);
+        assert(!TextureCache::Load("texture.png"));
+    }
+
+    Image small;
+    small.Width = small.Height = 1;
+    small.bitcount = 32;
+    small.pitch = 4;
+    small.data_size = 4;
+    small.data = new uint8_t[4]{1, 2, 3, 4};
+
+    {
+        // so does one rewritten within the same second at the same size
+        assert(TextureCache::Store("texture.png", small));
+        assert(TextureCache::Load("texture.png"));
+        this_thread::sleep_for(chrono::milliseconds(20));
+        FILE* fp = fopen(source.c_str(), "w");
+        fputs("EDITED", fp);
+        fclose(fp);
+        assert(!TextureCache::Load("texture.png"));
+    }
+
+    {
+        // by default entries are kept beside the Asset directory, wherever
+        // the working directory is
+        TextureCache::SetDefaultDirectory();
+        assert(TextureCache::GetDirectory("texture.png") ==
+               root + "/Cache/Textures");
+        assert(TextureCache::Store("texture.png", small));
+        assert(filesystem::is_directory(root + "/Cache/Textures"));
+        assert(TextureCache::Load("texture.png"));
+    }
+
+    {
+        TextureCache::SetDirectory("");
+        assert(TextureCache::GetDirectory("texture.png").empty());
+        assert(!TextureCache::Store("texture.png", small));
+        assert(!TextureCache::Load("texture.png"));
+    }
+
+    g_pAssetLoader->RemoveSearchPath(root.c_str());
+    error_code error;
+    filesystem::remove_all(root, error);
+#endif
+
+    g_pAssetLoader->Finalize();
+    g_pMemoryManager->Finalize();
+
+    return 0;
+}
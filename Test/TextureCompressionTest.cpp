@@ -0,0 +1,209 @@
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+
+#include "DDS.hpp"
+#include "MipChain.hpp"
+#include "TestImages.hpp"
+#include "TextureCompression.hpp"
+
+using namespace std;
+using namespace My;
+
+// over the channels of the top level
+static double PSNR(const Image& a, const Image& b, uint32_t channels) {
+    double sum = 0.0;
+    for (uint32_t y = 0; y < a.Height; y++) {
+        for (uint32_t x = 0; x < a.Width; x++) {
+            for (uint32_t c = 0; c < channels; c++) {
+                double d = a.data[a.pitch * y + 4 * x + c] -
+                           b.data[b.pitch * y + 4 * x + c];
+                sum += d * d;
+            }
+        }
+    }
+    double mse = sum / (double(a.Width) * a.Height * channels);
+    return mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : INFINITY;
+}
+
+static Image RoundTrip(const Image& image, BlockFormat format) {
+    auto compressed = CompressImage(image, format);
+    assert(compressed.compressed);
+    assert(compressed.compress_format == GetCompressFormat(format));
+    auto decompressed = DecompressImage(compressed);
+    assert(decompressed.Width == image.Width);
+    assert(decompressed.Height == image.Height);
+    return decompressed;
+}
+
+int main(int, char**) {
+    {
+        // flat blocks come back as they were, when the format holds them
+        auto image = MakeImage(8, 8, 32);
+        for (size_t i = 0; i < image.data_size; i += 4) {
+            image.data[i] = 255;
+            image.data[i + 1] = 0;
+            image.data[i + 2] = 0;
+            image.data[i + 3] = 255;
+        }
+        for (auto format : {BlockFormat::kBC1, BlockFormat::kBC3}) {
+            auto result = RoundTrip(image, format);
+            assert(memcmp(result.data, image.data, image.data_size) == 0);
+        }
+
+        for (int32_t value = 0; value < 256; value += 5) {
+            memset(image.data, value, image.data_size);
+            auto result = RoundTrip(image, BlockFormat::kBC5);
+            for (size_t i = 0; i < result.data_size; i += 4) {
+                assert(result.data[i] == value && result.data[i + 1] == value);
+                assert(result.data[i + 2] == 0 && result.data[i + 3] == 255);
+            }
+        }
+    }
+
+    {
+        // smooth images keep their detail
+        auto image = MakeImage(64, 48, 32);
+        for (uint32_t y = 0; y < image.Height; y++) {
+            for (uint32_t x = 0; x < image.Width; x++) {
+                uint8_t* pixel = image.data + image.pitch * y + 4 * x;
+                pixel[0] = static_cast<uint8_t>(128 + 100 * sin(x / 7.0));
+                pixel[1] = static_cast<uint8_t>(128 + 100 * cos(y / 5.0));
+                pixel[2] = static_cast<uint8_t>(x * 2 + y);
+                pixel[3] = static_cast<uint8_t>(x * 4);
+            }
+        }
+
+        assert(PSNR(image, RoundTrip(image, BlockFormat::kBC1), 3) > 30.0);
+        assert(PSNR(image, RoundTrip(image, BlockFormat::kBC3), 4) > 30.0);
+        assert(PSNR(image, RoundTrip(image, BlockFormat::kBC4), 1) > 40.0);
+        assert(PSNR(image, RoundTrip(image, BlockFormat::kBC5), 2) > 40.0);
+    }
+
+    {
+        // cut out alpha stays cut out
+        auto image = MakeImage(16, 16, 32);
+        for (size_t i = 0; i < image.data_size; i += 4) {
+            image.data[i] = image.data[i + 1] = image.data[i + 2] = 0x80;
+            image.data[i + 3] = ((i / 4) % 3) ? 0xFF : 0;
+        }
+        auto result = RoundTrip(image, BlockFormat::kBC3);
+        for (size_t i = 3; i < image.data_size; i += 4) {
+            assert(result.data[i] == image.data[i]);
+        }
+    }
+
+    {
+        // every mip, down to the blocks smaller than 4x4
+        auto image = MakeImage(13, 6, 32);
+        for (size_t i = 0; i < image.data_size; i++) {
+            image.data[i] = static_cast<uint8_t>(i * 7);
+        }
+        assert(GenerateMipChain(image));
+
+        auto compressed = CompressImage(image, BlockFormat::kBC1);
+        assert(compressed.mipmaps.size() == image.mipmaps.size());
+        const uint32_t blocks[][2] = {{4, 2}, {2, 1}, {1, 1}, {1, 1}};
+        size_t offset = 0;
+        for (size_t i = 0; i < compressed.mipmaps.size(); i++) {
+            const auto& mip = compressed.mipmaps[i];
+            assert(mip.Width == image.mipmaps[i].Width);
+            assert(mip.Height == image.mipmaps[i].Height);
+            assert(mip.pitch == blocks[i][0] * 8);
+            assert(mip.data_size == mip.pitch * blocks[i][1]);
+            assert(mip.offset == offset);
+            offset += mip.data_size;
+        }
+        assert(compressed.data_size == offset);
+
+        auto decompressed = DecompressImage(compressed);
+        assert(decompressed.mipmaps.size() == image.mipmaps.size());
+        assert(decompressed.mipmaps.back().Width == 1);
+    }
+
+    {
+        // half floats within what 10 bit endpoints hold. one region fits
+        // a line, as brightness ramps of a single hue are.
+        auto image = MakeImage(32, 16, 96, true);
+        auto* pixels = reinterpret_cast<float*>(image.data);
+        for (uint32_t i = 0; i < image.Width * image.Height; i++) {
+            uint32_t x = i % image.Width;
+            uint32_t y = i / image.Width;
+            float scale = 1.0f + x * 0.5f + y * 0.25f;
+            pixels[3 * i] = 0.5f * scale;
+            pixels[3 * i + 1] = 20.0f * scale;
+            pixels[3 * i + 2] = 0.05f * scale;
+        }
+
+        auto result = RoundTrip(image, BlockFormat::kBC6H);
+        assert(result.is_float && result.bitcount == 128);
+        const auto* decoded = reinterpret_cast<const float*>(result.data);
+        double error = 0.0;
+        for (uint32_t i = 0; i < image.Width * image.Height; i++) {
+            for (uint32_t c = 0; c < 3; c++) {
+                float expected = pixels[3 * i + c];
+                float got = decoded[4 * i + c];
+                assert(fabs(got - expected) <= 0.1f * expected);
+                error += fabs(got - expected) / expected;
+            }
+            assert(decoded[4 * i + 3] == 1.0f);
+        }
+        assert(error / (image.Width * image.Height * 3) < 0.02);
+    }
+
+    {
+        // what DdsWriter writes DdsParser reads back, level by level
+        for (auto format : {BlockFormat::kBC1, BlockFormat::kBC4,
+                            BlockFormat::kBC5, BlockFormat::kBC6H}) {
+            bool hdr = (format == BlockFormat::kBC6H);
+            auto image = MakeImage(20, 12, hdr ? 128 : 32, hdr);
+            for (size_t i = 0; i < image.data_size; i += 4) {
+                if (hdr) {
+                    auto value = static_cast<float>(i % 97);
+                    memcpy(image.data + i, &value, sizeof(value));
+                } else {
+                    memset(image.data + i, static_cast<int>(i % 251), 4);
+                }
+            }
+            assert(GenerateMipChain(image));
+            auto compressed = CompressImage(image, format);
+
+            ostringstream out;
+            assert(DdsWriter::Write(compressed, out));
+            string file = out.str();
+            Buffer buf(file.size());
+            memcpy(buf.GetData(), file.data(), file.size());
+
+            DdsParser parser;
+            auto parsed = parser.Parse(buf);
+            assert(parsed.compressed);
+            assert(parsed.compress_format == compressed.compress_format);
+            assert(parsed.is_float == hdr);
+            assert(parsed.Width == 20 && parsed.Height == 12);
+            assert(parsed.data_size == compressed.data_size);
+            assert(parsed.mipmaps.size() == compressed.mipmaps.size());
+            for (size_t i = 0; i < parsed.mipmaps.size(); i++) {
+                assert(parsed.mipmaps[i].offset ==
+                       compressed.mipmaps[i].offset);
+                assert(parsed.mipmaps[i].data_size ==
+                       compressed.mipmaps[i].data_size);
+            }
+            assert(memcmp(parsed.data, compressed.data,
+                          compressed.data_size) == 0);
+        }
+    }
+
+    {
+        // what the encoders do not take gives an empty image
+        auto rgb = MakeImage(4, 4, 24);
+        assert(!CompressImage(rgb, BlockFormat::kBC1).data);
+        auto rgba = MakeImage(4, 4, 32);
+        assert(!CompressImage(rgba, BlockFormat::kBC6H).data);
+        assert(!DecompressImage(rgba).data);
+    }
+
+    cout << "texture compression ok" << endl;
+
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "config.h"
+
+#if !defined(OS_WINDOWS)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "AssetLoader.hpp"
+#include "MemoryManager.hpp"
+#include "TestImages.hpp"
+#include "TextureCache.hpp"
+#include "VirtualTexture.hpp"
+
+using namespace std;
+using namespace My;
+
+namespace My {
+IMemoryManager* g_pMemoryManager = new MemoryManager();
+AssetLoader* g_pAssetLoader = new AssetLoader();
+}  // namespace My
+
+// feeds the camera at (x, y) until the pages it needs are filled
+static void Settle(VirtualTexture& texture, float x, float y, float radius) {
+    for (int32_t i = 0; i < 500; i++) {
+        texture.Feedback(x, y, radius);
+        texture.Update();
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+}
+
+// the value page (x, y) was filled with, read from its slot in the cache
+static int32_t PageValue(const VirtualTexture& texture, uint32_t x,
+                         uint32_t y) {
+    int32_t slot = texture.GetPageTable()[y * texture.GetWidth() + x];
+    if (slot == VirtualTexture::kNotResident) return -1;
+
+    const auto& settings = texture.GetSettings();
+    const auto& cache = texture.GetCache();
+    size_t px = slot % settings.cacheWidth * settings.pageSize;
+    size_t py = slot / settings.cacheWidth * settings.pageSize;
+    uint8_t value = cache.data[py * cache.pitch + px * 4];
+    // the whole page holds it
+    for (size_t row = 0; row < settings.pageSize; row++) {
+        for (size_t col = 0; col < settings.pageSize; col++) {
+            assert(cache.data[(py + row) * cache.pitch + (px + col) * 4] ==
+                   value);
+        }
+    }
+    return value;
+}
+
+int main(int, char**) {
+    g_pMemoryManager->Initialize();
+    g_pAssetLoader->Initialize();
+
+#if !defined(OS_WINDOWS)
+    string root = "/tmp/VirtualTextureTest." + to_string(getpid());
+    string dir = root + "/Asset";
+    mkdir(root.c_str(), 0755);
+    mkdir(dir.c_str(), 0755);
+    g_pAssetLoader->AddSearchPath(root.c_str());
+    TextureCache::SetDirectory("");
+
+    // a 4x4 grid of pages, the one at (x, y) filled with 10 * (4y + x).
+    // the page in the corner is larger than the others.
+    for (uint32_t y = 0; y < 4; y++) {
+        for (uint32_t x = 0; x < 4; x++) {
+            uint16_t size = (x == 3 && y == 3) ? 32 : 8;
+            auto value = static_cast<uint8_t>(10 * (4 * y + x));
+            WriteTga(dir + "/page_" + to_string(x) + "_" + to_string(y) +
+                         ".tga",
+                     size, size, [value](int32_t) { return value; });
+        }
+    }
+
+    {
+        VirtualTextureSettings settings;
+        settings.pageSize = 8;
+        settings.cacheWidth = 2;
+        settings.cacheHeight = 2;
+        settings.fillsPerFrame = 1;
+        VirtualTexture texture(4, 4, settings);
+        for (uint32_t y = 0; y < 4; y++) {
+            for (uint32_t x = 0; x < 4; x++) {
+                texture.SetPageName(x, y, "page_" + to_string(x) + "_" +
+                                              to_string(y) + ".tga");
+            }
+        }
+
+        // nothing is loaded before the camera asks for it
+        assert(texture.GetResidentPageCount() == 0);
+        assert(!texture.GetCache().data);
+        for (auto slot : texture.GetPageTable()) {
+            assert(slot == VirtualTexture::kNotResident);
+        }
+
+        // the pages around the camera, no more than the cache holds
+        Settle(texture, 1.0f, 1.0f, 0.8f);
+        assert(texture.GetResidentPageCount() == 4);
+        assert(texture.GetCache().Width == 16);
+        assert(texture.GetCache().bitcount == 32);
+        assert(PageValue(texture, 0, 0) == 0);
+        assert(PageValue(texture, 1, 0) == 10);
+        assert(PageValue(texture, 0, 1) == 40);
+        assert(PageValue(texture, 1, 1) == 50);
+        assert(PageValue(texture, 2, 2) == -1);
+        assert(texture.IsPageTableDirty());
+        assert(texture.TakeDirtySlots().size() == 4);
+        assert(texture.TakeDirtySlots().empty());
+        texture.ClearPageTableDirty();
+
+        // moving on, the pages left behind make room for the new ones,
+        // the larger page resampled to the size of the others
+        Settle(texture, 3.0f, 3.0f, 0.8f);
+        assert(texture.GetResidentPageCount() == 4);
+        assert(PageValue(texture, 2, 2) == 100);
+        assert(PageValue(texture, 3, 2) == 110);
+        assert(PageValue(texture, 2, 3) == 140);
+        assert(PageValue(texture, 3, 3) == 150);
+        assert(PageValue(texture, 0, 0) == -1);
+        assert(PageValue(texture, 1, 1) == -1);
+
+        // a camera far from the grid needs nothing, and drops nothing
+        Settle(texture, 100.0f, 100.0f, 2.0f);
+        assert(texture.GetResidentPageCount() == 4);
+        assert(PageValue(texture, 3, 3) == 150);
+    }
+
+    g_pAssetLoader->RemoveSearchPath(root.c_str());
+    error_code error;
+    filesystem::remove_all(root, error);
+#endif
+
+    g_pAssetLoader->Finalize();
+    g_pMemoryManager->Finalize();
+
+    cout << "virtual texture ok" << endl;
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <future>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "WorkerPool.hpp"
+
+using namespace std;
+using namespace My;
+
+int main(int, char**) {
+    {
+        // one thread per core by default
+        WorkerPool pool;
+        assert(pool.GetThreadCount() ==
+               max(1u, thread::hardware_concurrency()));
+
+        auto answer = pool.Submit([] { return 42; });
+        assert(answer.get() == 42);
+    }
+
+    {
+        // many more tasks than threads, never more than the threads run
+        // at once
+        WorkerPool pool(3);
+        atomic<int32_t> running{0};
+        atomic<int32_t> peak{0};
+        mutex ids_mutex;
+        set<thread::id> ids;
+
+        vector<future<void>> futures;
+        for (int32_t i = 0; i < 256; i++) {
+            futures.push_back(pool.Submit([&] {
+                int32_t now = ++running;
+                int32_t seen = peak.load();
+                while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+                }
+                this_thread::sleep_for(chrono::microseconds(100));
+                --running;
+
+                lock_guard<mutex> lock(ids_mutex);
+                ids.insert(this_thread::get_id());
+            }));
+        }
+
+        for (auto& future : futures) future.get();
+        assert(peak.load() <= 3);
+        assert(ids.size() <= 3);
+    }
+
+    {
+        // a task throwing hands the exception to its future
+        WorkerPool pool(1);
+        auto failed =
+            pool.Submit([]() -> int32_t { throw runtime_error("failed"); });
+        bool caught = false;
+        try {
+            failed.get();
+        } catch (const runtime_error&) {
+            caught = true;
+        }
+        assert(caught);
+    }
+
+    {
+        // queued tasks still run when the pool goes away
+        atomic<int32_t> done{0};
+        vector<future<void>> futures;
+        {
+            WorkerPool pool(1);
+            for (int32_t i = 0; i < 32; i++) {
+                futures.push_back(pool.Submit([&done] { ++done; }));
+            }
+        }
+        assert(done.load() == 32);
+        for (auto& future : futures) future.get();
+    }
+
+    {
+        // every index runs once
+        WorkerPool pool(4);
+        vector<atomic<int32_t>> hits(1000);
+        pool.ParallelFor(hits.size(), [&hits](size_t i) { ++hits[i]; });
+        for (auto& hit : hits) assert(hit.load() == 1);
+
+        pool.ParallelFor(0, [](size_t) { assert(0); });
+    }
+
+    {
+        // a task of a busy pool spreads its work over the same pool,
+        // the calling threads take on what no helper gets to
+        WorkerPool pool(2);
+        atomic<int32_t> done{0};
+        vector<future<void>> futures;
+        for (int32_t i = 0; i < 4; i++) {
+            futures.push_back(pool.Submit([&pool, &done] {
+                pool.ParallelFor(64, [&done](size_t) { ++done; });
+            }));
+        }
+        for (auto& future : futures) future.get();
+        assert(done.load() == 4 * 64);
+    }
+
+    return 0;
+}
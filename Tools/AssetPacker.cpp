@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "PakArchive.hpp"
+
+using namespace std;
+using namespace My;
+
+namespace fs = std::filesystem;
+
+// usage: AssetPacker [--store|--zlib|--lz4] <directory> <archive>
+//
+// packs every file below directory, named by its path relative to it.
+// archives and hidden files are skipped.
+
+static bool IsPacked(const fs::path& relative) {
+    for (const auto& part : relative) {
+        if (part.string().front() == '.') return false;
+    }
+
+    return relative.extension() != ".pak";
+}
+
+int main(int argc, char** argv) {
+    PakCodec codec = PakCodec::kZlib;
+    vector<const char*> arguments;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--store") == 0) {
+            codec = PakCodec::kStored;
+        } else if (strcmp(argv[i], "--zlib") == 0) {
+            codec = PakCodec::kZlib;
+        } else if (strcmp(argv[i], "--lz4") == 0) {
+            codec = PakCodec::kLz4;
+        } else {
+            arguments.push_back(argv[i]);
+        }
+    }
+
+    if (arguments.size() != 2) {
+        cerr << "usage: " << argv[0]
+             << " [--store|--zlib|--lz4] <directory> <archive>" << endl;
+        return 1;
+    }
+
+    fs::path root(arguments[0]);
+    error_code error;
+
+    // sorted, the same tree always gives the same archive
+    vector<fs::path> files;
+    for (fs::recursive_directory_iterator it(root, error), end;
+         !error && it != end; it.increment(error)) {
+        if (it->is_regular_file() &&
+            IsPacked(it->path().lexically_relative(root))) {
+            files.push_back(it->path());
+        }
+    }
+
+    if (error) {
+        cerr << "Error walking " << root << ": " << error.message() << endl;
+        return 1;
+    }
+
+    sort(files.begin(), files.end());
+
+    PakWriter writer;
+    if (!writer.Begin(arguments[1])) {
+        cerr << "Error creating " << arguments[1] << endl;
+        return 1;
+    }
+
+    size_t total = 0;
+    for (const auto& file : files) {
+        ifstream in(file, ios::binary);
+        vector<uint8_t> content((istreambuf_iterator<char>(in)),
+                                istreambuf_iterator<char>());
+        if (in.bad()) {
+            cerr << "Error reading " << file << endl;
+            return 1;
+        }
+
+        string name = file.lexically_relative(root).generic_string();
+        if (!writer.AddEntry(name.c_str(), content.data(), content.size(),
+                             codec)) {
+            cerr << "Error packing " << name << endl;
+            return 1;
+        }
+
+        total += content.size();
+    }
+
+    if (!writer.Finish()) {
+        cerr << "Error writing " << arguments[1] << endl;
+        return 1;
+    }
+
+    cout << "Packed " << files.size() << " files, " << total << " bytes into "
+         << arguments[1] << " (" << fs::file_size(arguments[1]) << " bytes)"
+         << endl;
+
+    return 0;
+}
@@ -0,0 +1,298 @@
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "AssetLoader.hpp"
+#include "BMP.hpp"
+#include "DDS.hpp"
+#include "HDR.hpp"
+#include "JPEG.hpp"
+#include "MemoryManager.hpp"
+#include "MipChain.hpp"
+#include "PNG.hpp"
+#include "TGA.hpp"
+#include "TextureCompression.hpp"
+
+using namespace std;
+using namespace My;
+
+namespace fs = std::filesystem;
+
+// the parsers allocate through the memory manager
+namespace My {
+IMemoryManager* g_pMemoryManager = new MemoryManager();
+AssetLoader* g_pAssetLoader = new AssetLoader();
+}  // namespace My
+
+// usage: TextureCooker [--force] [--format bc1|bc3|bc4|bc5|bc6h]
+//                      <image|directory>... <output directory>
+//
+// encodes every image into a block compressed .dds with all of its mips,
+// named as the source with the extension replaced. images found in a
+// directory keep their path below it in the output directory. outputs newer
+// than their source are kept unless --force is given. unless --format says
+// otherwise, .hdr images become BC6H, normal maps BC5, roughness, metallic,
+// ao and height maps BC4, images with alpha BC3 and the others BC1. maps
+// are told by the last word of their name, as in brick_normal.png or
+// brick-roughness.tga.
+
+static bool IsImage(const fs::path& path) {
+    string ext = path.extension().string();
+    transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".bmp" ||
+           ext == ".tga" || ext == ".hdr";
+}
+
+static bool ParseFormat(const char* name, BlockFormat& format) {
+    static const pair<const char*, BlockFormat> s_Formats[] = {
+        {"bc1", BlockFormat::kBC1}, {"bc3", BlockFormat::kBC3},
+        {"bc4", BlockFormat::kBC4}, {"bc5", BlockFormat::kBC5},
+        {"bc6h", BlockFormat::kBC6H}};
+    for (const auto& entry : s_Formats) {
+        if (strcmp(name, entry.first) == 0) {
+            format = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
+
+static Image ParseImage(const fs::path& path) {
+    ifstream in(path, ios::binary);
+    vector<uint8_t> content((istreambuf_iterator<char>(in)),
+                            istreambuf_iterator<char>());
+    if (in.bad() || content.empty()) return Image();
+
+    Buffer buf(content.size());
+    memcpy(buf.GetData(), content.data(), content.size());
+
+    string ext = path.extension().string();
+    transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    Image image;
+    if (ext == ".jpg" || ext == ".jpeg") {
+        JfifParser jfif_parser;
+        image = jfif_parser.Parse(buf);
+    } else if (ext == ".png") {
+        PngParser png_parser(PixelLayout::kRGBA);
+        image = png_parser.Parse(buf);
+    } else if (ext == ".bmp") {
+        BmpParser bmp_parser;
+        image = bmp_parser.Parse(buf);
+    } else if (ext == ".tga") {
+        TgaParser tga_parser(PixelLayout::kRGBA);
+        image = tga_parser.Parse(buf);
+    } else if (ext == ".hdr") {
+        HdrParser hdr_parser;
+        image = hdr_parser.Parse(buf);
+        image.is_float = true;
+    }
+
+    return image;
+}
+
+// brings the image to what the encoders and GenerateMipChain take: 32 bit
+// RGBA, or 128 bit float RGBA for .hdr
+static bool Normalize(Image& image) {
+    if (image.is_float && image.bitcount == 128) return true;
+    if (!image.is_float && image.bitcount == 32) return true;
+
+    uint32_t channels = image.is_float ? image.bitcount / 32 : 0;
+    if (image.is_float && channels != 3) return false;
+    if (!image.is_float && image.bitcount != 8 && image.bitcount != 64) {
+        return false;
+    }
+
+    size_t pixel_size = image.is_float ? 16 : 4;
+    size_t pitch = image.Width * pixel_size;
+    auto* data = new uint8_t[pitch * image.Height];
+    for (uint32_t y = 0; y < image.Height; y++) {
+        const uint8_t* src = image.data + image.pitch * y;
+        uint8_t* dst = data + pitch * y;
+        for (uint32_t x = 0; x < image.Width; x++) {
+            if (image.is_float) {
+                float pixel[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+                memcpy(pixel, src + 12 * x, 12);
+                memcpy(dst + 16 * x, pixel, sizeof(pixel));
+            } else if (image.bitcount == 8) {
+                memset(dst + 4 * x, src[x], 3);
+                dst[4 * x + 3] = 0xFF;
+            } else {
+                // the high bytes of 16 bit channels
+                const auto* src16 =
+                    reinterpret_cast<const uint16_t*>(src) + 4 * x;
+                for (uint32_t c = 0; c < 4; c++) {
+                    dst[4 * x + c] = static_cast<uint8_t>(src16[c] >> 8);
+                }
+            }
+        }
+    }
+
+    image.AdoptData(data);
+    image.bitcount = static_cast<uint32_t>(pixel_size * 8);
+    image.pitch = pitch;
+    image.data_size = pitch * image.Height;
+    image.mipmaps.clear();
+    image.mipmaps.emplace_back(image.Width, image.Height, pitch, 0,
+                               image.data_size);
+    return true;
+}
+
+static bool HasAlpha(const Image& image) {
+    for (uint32_t y = 0; y < image.Height; y++) {
+        const uint8_t* row = image.data + image.pitch * y;
+        for (uint32_t x = 0; x < image.Width; x++) {
+            if (row[4 * x + 3] != 0xFF) return true;
+        }
+    }
+    return false;
+}
+
+static BlockFormat ChooseFormat(const fs::path& path, const Image& image) {
+    if (image.is_float) return BlockFormat::kBC6H;
+
+    // the last word, so that metal_plate_albedo stays color
+    string name = path.stem().string();
+    transform(name.begin(), name.end(), name.begin(), ::tolower);
+    string suffix = name.substr(name.find_last_of("_-. ") + 1);
+
+    for (const char* normal : {"normal", "normals", "nrm"}) {
+        if (suffix == normal) return BlockFormat::kBC5;
+    }
+    for (const char* single :
+         {"rough", "roughness", "metal", "metallic", "metalness", "ao",
+          "occlusion", "height", "displacement"}) {
+        if (suffix == single) return BlockFormat::kBC4;
+    }
+
+    return HasAlpha(image) ? BlockFormat::kBC3 : BlockFormat::kBC1;
+}
+
+static bool Cook(const fs::path& source, const fs::path& target,
+                 bool has_format, BlockFormat format) {
+    Image image = ParseImage(source);
+    if (!image.data || !Normalize(image)) {
+        cerr << "Error reading " << source << endl;
+        return false;
+    }
+
+    if (!has_format) format = ChooseFormat(source, image);
+    if ((format == BlockFormat::kBC6H) != image.is_float) {
+        cerr << "Error: " << source << " can not be encoded so" << endl;
+        return false;
+    }
+
+    // only color is stored sRGB, data maps are filtered as they are
+    MipChainSettings settings;
+    settings.srgb =
+        (format == BlockFormat::kBC1 || format == BlockFormat::kBC3);
+    GenerateMipChain(image, settings);
+
+    Image compressed = CompressImage(image, format);
+    ofstream out(target, ios::binary | ios::trunc);
+    if (!compressed.data || !DdsWriter::Write(compressed, out)) {
+        cerr << "Error writing " << target << endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    bool force = false;
+    bool has_format = false;
+    BlockFormat format = BlockFormat::kBC1;
+    vector<const char*> arguments;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--force") == 0) {
+            force = true;
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            if (!ParseFormat(argv[++i], format)) {
+                cerr << "Unknown format " << argv[i] << endl;
+                return 1;
+            }
+            has_format = true;
+        } else {
+            arguments.push_back(argv[i]);
+        }
+    }
+
+    if (arguments.size() < 2) {
+        cerr << "usage: " << argv[0]
+             << " [--force] [--format bc1|bc3|bc4|bc5|bc6h]"
+                " <image|directory>... <output directory>"
+             << endl;
+        return 1;
+    }
+
+    g_pMemoryManager->Initialize();
+
+    fs::path output(arguments.back());
+    arguments.pop_back();
+    error_code error;
+    fs::create_directories(output, error);
+
+    // each source with its path in the output directory
+    vector<pair<fs::path, fs::path>> sources;
+    for (const char* argument : arguments) {
+        fs::path path(argument);
+        if (!fs::is_directory(path)) {
+            sources.emplace_back(path, path.filename());
+            continue;
+        }
+
+        for (fs::recursive_directory_iterator it(path, error), end;
+             !error && it != end; it.increment(error)) {
+            if (it->is_regular_file() && IsImage(it->path())) {
+                sources.emplace_back(it->path(),
+                                     it->path().lexically_relative(path));
+            }
+        }
+    }
+    sort(sources.begin(), sources.end());
+
+    size_t cooked = 0;
+    size_t kept = 0;
+    bool failed = false;
+    set<fs::path> targets;
+    for (const auto& [source, relative] : sources) {
+        fs::path target = output / relative;
+        target.replace_extension(".dds");
+
+        // such as brick.png and brick.tga side by side
+        if (!targets.insert(target).second) {
+            cerr << "Error: " << source << " cooks to " << target
+                 << " as another image does" << endl;
+            failed = true;
+            continue;
+        }
+
+        if (!force && fs::exists(target, error) &&
+            fs::last_write_time(target, error) >=
+                fs::last_write_time(source, error)) {
+            kept++;
+            continue;
+        }
+
+        fs::create_directories(target.parent_path(), error);
+        if (Cook(source, target, has_format, format)) {
+            cooked++;
+        } else {
+            failed = true;
+        }
+    }
+
+    cout << "Cooked " << cooked << " textures, " << kept << " up to date"
+         << endl;
+
+    g_pMemoryManager->Finalize();
+
+    return failed ? 1 : 0;
+}
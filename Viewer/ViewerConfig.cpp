@@ -40,7 +40,9 @@ IPhysicsManager* g_pPhysicsManager =
     static_cast<IPhysicsManager*>(new MyPhysicsManager);
 IMemoryManager* g_pMemoryManager =
     static_cast<IMemoryManager*>(new MemoryManager);
-AssetLoader* g_pAssetLoader = static_cast<AssetLoader*>(new AssetLoader);
+// every launch reads the same scene, prefetch what the last one read
+AssetLoader* g_pAssetLoader =
+    static_cast<AssetLoader*>(new AssetLoader("Cache/Viewer.manifest"));
 SceneManager* g_pSceneManager = static_cast<SceneManager*>(new SceneManager);
 InputManager* g_pInputManager = static_cast<InputManager*>(new InputManager);
 AnimationManager* g_pAnimationManager =
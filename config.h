@@ -0,0 +1,13 @@
+#define USE_ISPC
+/* #undef OS_WINDOWS */
+#define OS_LINUX
+/* #undef OS_BSD */
+/* #undef OS_ANDROID */
+/* #undef OS_MACOS */
+/* #undef OS_WEBASSEMBLY */
+// Enable this to print out very detailed decode information
+// #define DUMP_DETAILS 1
+
+// Enable this to use OpenGL Debug ARB
+/* #undef OPENGL_RHI_DEBUG */
+